@@ -524,9 +524,11 @@ void ConsoleRoboCupCtrl::help(In& stream)
   list("  jm <axis> ( off | <button> <button> ) : Map two buttons on an axis.", pattern, true);
   list("  js <axis> <speed> <threshold> [<center>] : Set axis maximum speed and ignore threshold for \"jc motion <num>\" commands.", pattern, true);
   list("  log start | stop | clear | save <file> | full | jpeg : Record log file and (de)activate image compression.", pattern, true);
+  list("  log saveIndexed <file> : Save log compressed and with an index for fast loading.", pattern, true);
   list("  log saveAudio <file> : Save audio data from log.", pattern, true);
   list("  log saveImages [raw] <file> : Save images from log.", pattern, true);
   list("  log saveTiming <file> : Save timing data from log to csv.", pattern, true);
+  list("  log saveTrace <file> : Save stopwatch traces from log as Chrome trace json.", pattern, true);
   list("  log ? [<pattern>] | load <file> | ( keep | remove ) <message> {<message>} : Load, filter, and display information about log file.", pattern, true);
   list("  log start | pause | stop | forward [image] | backward [image] | repeat | goto <number> | cycle | once | fast_forward | fast_rewind : Replay log file.", pattern, true);
   list("  mof : Recompile motion net and send it to the robot. ", pattern, true);
@@ -731,10 +733,12 @@ void ConsoleRoboCupCtrl::createCompletion()
     "log start",
     "log stop",
     "log save",
+    "log saveIndexed",
     "log saveAudio",
     "log saveImages",
     "log saveImages raw",
     "log saveTiming",
+    "log saveTrace",
     "log clear",
     "log full",
     "log jpeg",
@@ -809,6 +813,7 @@ void ConsoleRoboCupCtrl::createCompletion()
 
   addCompletionFiles("log load ", std::string(File::getBHDir()) + "/Config/Logs/*.log");
   addCompletionFiles("log save ", std::string(File::getBHDir()) + "/Config/Logs/*.log");
+  addCompletionFiles("log saveIndexed ", std::string(File::getBHDir()) + "/Config/Logs/*.log");
   addCompletionFiles("call ", std::string(File::getBHDir()) + "/Config/Scenes/*.con");
 
   if(moduleInfo)
@@ -29,7 +29,7 @@ LocalRobot::LocalRobot()
   {
     logFile = ((ConsoleRoboCupCtrl*)RoboCupCtrl::controller)->getLogFile();
     logPlayer.open(logFile.c_str());
-    logPlayer.handleAllMessages(annotationInfos['c']);
+    logPlayer.handleAllMessages(annotationInfos['c'], idAnnotation);
     logPlayer.play();
     puppet = (SimRobotCore2::Body*)RoboCupCtrl::application->resolveObject("RoboCup.puppets." + robotName, SimRobotCore2::body);
     if(puppet)
@@ -6,6 +6,7 @@
 * @author Martin Lötzsch
 */
 
+#include <QFile>
 #include <QImage>
 #include "LogPlayer.h"
 #include "Representations/Infrastructure/AudioData.h"
@@ -16,9 +17,14 @@
 #include "Platform/File.h"
 #include "Tools/MessageQueue/LogFileFormat.h"
 #include <snappy-c.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <vector>
 #include <list>
 #include <map>
+#include <set>
 using namespace std;
 
 LogPlayer::LogPlayer(MessageQueue& targetQueue) :
@@ -28,9 +34,17 @@ LogPlayer::LogPlayer(MessageQueue& targetQueue) :
   init();
 }
 
+LogPlayer::~LogPlayer()
+{
+  closeIndexed();
+  if(streamHandler)
+    delete streamHandler;
+}
+
 void LogPlayer::init()
 {
   clear();
+  closeIndexed();
   stop();
   numberOfFrames = 0;
   numberOfMessagesWithinCompleteFrames = 0;
@@ -73,6 +87,16 @@ bool LogPlayer::open(const char* fileName)
       case logFileUncompressed: //regular log file
         file >> *this;
         break;
+      case logFileCompressedWithIndex: //compressed log file with index, only the index is loaded
+        if(openIndexed(fileName))
+        {
+          frameIndex = logFileIndex.frameIndex;
+          numberOfFrames = logFileIndex.numberOfFrames;
+          numberOfMessagesWithinCompleteFrames = logFileIndex.numberOfMessagesWithinCompleteFrames;
+          stop();
+          return true;
+        }
+        // no index, e.g. because logging was interrupted -> read like a compressed log file
       case logFileCompressed://compressed log file
         while(!file.eof())
         {
@@ -98,7 +122,6 @@ bool LogPlayer::open(const char* fileName)
     }
 
     stop();
-    countFrames();
     createFrameIndex();
     return true;
   }
@@ -143,7 +166,7 @@ void LogPlayer::stepBackward()
     else
       return;
     currentMessageNumber = frameIndex[currentFrameNumber];
-    queue.setSelectedMessageForReading(currentMessageNumber);
+    selectMessage(currentMessageNumber);
     stepRepeat();
   }
 }
@@ -178,7 +201,7 @@ void LogPlayer::stepForward()
     replayStreamSpecification();
     do
     {
-      copyMessage(++currentMessageNumber, targetQueue);
+      copyLogMessage(++currentMessageNumber, targetQueue);
       if(queue.getMessageID() == idImage || queue.getMessageID() == idImageUpper || 
         queue.getMessageID() == idJPEGImage || queue.getMessageID() == idJPEGImageUpper || 
         queue.getMessageID() == idThumbnail || queue.getMessageID() == idThumbnailUpper ||
@@ -213,7 +236,7 @@ void LogPlayer::stepRepeat()
   {
     --currentFrameNumber;
     currentMessageNumber = currentFrameNumber >= 0 ? frameIndex[currentFrameNumber] : 0;
-    queue.setSelectedMessageForReading(currentMessageNumber);
+    selectMessage(currentMessageNumber);
     stepForward();
   }
 }
@@ -225,7 +248,7 @@ void LogPlayer::gotoFrame(int frame)
   {
     currentFrameNumber = frame - 1;
     currentMessageNumber = currentFrameNumber >= 0 ? frameIndex[currentFrameNumber] : 0;
-    queue.setSelectedMessageForReading(currentMessageNumber);
+    selectMessage(currentMessageNumber);
     stepForward();
   }
 }
@@ -234,6 +257,7 @@ bool LogPlayer::save(const char* fileName, const StreamHandler* streamHandler)
 {
   if(state == recording)
     recordStop();
+  loadAllBlocks();
 
   if(!getNumberOfMessages())
     return false;
@@ -255,13 +279,78 @@ bool LogPlayer::save(const char* fileName, const StreamHandler* streamHandler)
   return false;
 }
 
+bool LogPlayer::saveIndexed(const char* fileName, const StreamHandler* streamHandler)
+{
+  if(state == recording)
+    recordStop();
+  loadAllBlocks();
+
+  if(!getNumberOfMessages())
+    return false;
+
+  OutBinaryFile file(fileName);
+  if(!file.exists())
+    return false;
+
+  file << logFileMessageIDs; // write magic byte to indicate message id table
+  writeMessageIDs(file);
+  if(streamHandler || this->streamHandler)
+  {
+    file << logFileStreamSpecification;
+    file << (this->streamHandler ? *this->streamHandler : *streamHandler);
+  }
+  file << logFileCompressedWithIndex;
+
+  // The index identifies frames by the ids as they are stored in the queue.
+  unsigned char processBegin = idProcessBegin;
+  unsigned char processFinished = idProcessFinished;
+  for(int id = queue.numOfMappedIDs - 1; id >= 0; --id)
+    if(queue.mapID(static_cast<unsigned char>(id)) == idProcessBegin)
+      processBegin = static_cast<unsigned char>(id);
+    else if(queue.mapID(static_cast<unsigned char>(id)) == idProcessFinished)
+      processFinished = static_cast<unsigned char>(id);
+
+  // Blocks end with a complete frame, so playing a frame never requires two blocks.
+  LogFileIndex index;
+  std::vector<char> block;
+  std::vector<char> compressedBlock;
+  int firstMessage = 0;
+  unsigned blockStart = 0;
+  for(int i = 0; i < getNumberOfMessages(); ++i)
+  {
+    queue.setSelectedMessageForReading(i);
+    if(i == firstMessage)
+      blockStart = queue.selectedMessageForReadingPosition;
+    const unsigned blockEnd = queue.selectedMessageForReadingPosition + MessageQueueBase::headerSize + queue.getMessageSize();
+    if(i == getNumberOfMessages() - 1 || (queue.getMessageID() == idProcessFinished && blockEnd - blockStart >= indexedBlockSize))
+    {
+      const unsigned usedSize = blockEnd - blockStart;
+      block.resize(MessageQueueBase::queueHeaderSize + usedSize);
+      reinterpret_cast<unsigned*>(block.data())[0] = usedSize;
+      reinterpret_cast<unsigned*>(block.data())[1] = i + 1 - firstMessage;
+      std::memcpy(block.data() + MessageQueueBase::queueHeaderSize, queue.buf + blockStart, usedSize);
+
+      size_t compressedSize = snappy_max_compressed_length(block.size());
+      compressedBlock.resize(compressedSize);
+      if(snappy_compress(block.data(), block.size(), compressedBlock.data(), &compressedSize) != SNAPPY_OK)
+        return false;
+      file << static_cast<unsigned>(compressedSize);
+      file.write(compressedBlock.data(), compressedSize);
+      index.addBlock(static_cast<unsigned>(compressedSize), block.data(), block.size(), processBegin, processFinished);
+      firstMessage = i + 1;
+    }
+  }
+  index.write(file);
+  return true;
+}
+
 bool LogPlayer::saveImages(const bool raw, const char* fileName)
 {
   int i = 0;
   Image image;
   for(currentMessageNumber = 0; currentMessageNumber < getNumberOfMessages(); currentMessageNumber++)
   {
-    queue.setSelectedMessageForReading(currentMessageNumber);
+    selectMessage(currentMessageNumber);
     if(queue.getMessageID() == idImage)
     {
       in.bin >> image;
@@ -333,6 +422,7 @@ bool LogPlayer::saveImages(const bool raw, const char* fileName)
 
 void LogPlayer::recordStart()
 {
+  loadAllBlocks();
   state = recording;
 }
 
@@ -372,7 +462,7 @@ bool LogPlayer::replay()
       replayStreamSpecification();
       do
       {
-        copyMessage(++currentMessageNumber, targetQueue);
+        copyLogMessage(++currentMessageNumber, targetQueue);
         if(queue.getMessageID() == idImage || queue.getMessageID() == idJPEGImage || 
           queue.getMessageID() == idImageUpper || queue.getMessageID() == idJPEGImageUpper || 
           queue.getMessageID() == idThumbnail || queue.getMessageID() == idThumbnailUpper ||
@@ -416,6 +506,7 @@ bool LogPlayer::replay()
 void LogPlayer::keep(MessageID* messageIDs)
 {
   stop();
+  loadAllBlocks();
   LogPlayer temp((MessageQueue&) *this);
   temp.setSize(queue.getSize());
   moveAllMessages(temp);
@@ -435,14 +526,16 @@ void LogPlayer::keep(MessageID* messageIDs)
       ++m;
     }
   }
-  countFrames();
-  if(!frameIndex.empty())
+  if(frameIndex.empty())
+    countFrames();
+  else
     createFrameIndex();
 }
 
 void LogPlayer::remove(MessageID* messageIDs)
 {
   stop();
+  loadAllBlocks();
   LogPlayer temp((MessageQueue&) *this);
   temp.setSize(queue.getSize());
   moveAllMessages(temp);
@@ -459,8 +552,9 @@ void LogPlayer::remove(MessageID* messageIDs)
     if(!*m)
       temp.copyMessage(temp.currentMessageNumber, *this);
   }
-  countFrames();
-  if(!frameIndex.empty())
+  if(frameIndex.empty())
+    countFrames();
+  else
     createFrameIndex();
 }
 
@@ -472,7 +566,20 @@ void LogPlayer::statistics(int frequencies[numOfDataMessageIDs], unsigned* sizes
     for(int i = 0; i < numOfDataMessageIDs; ++i)
       sizes[i] = 0;
 
-  if(getNumberOfMessages() > 0)
+  if(indexedLogData)
+  {
+    for(const LogFileIndex::Block& block : logFileIndex.blocks)
+      for(const LogFileIndex::MessageStatistics& entry : block.statistics)
+        if(!processIdentifier || processIdentifier == entry.processIdentifier)
+        {
+          const MessageID id = queue.mapID(entry.id);
+          ASSERT(id < numOfDataMessageIDs);
+          frequencies[id] += entry.count;
+          if(sizes)
+            sizes[id] += entry.size;
+        }
+  }
+  else if(getNumberOfMessages() > 0)
   {
     int current = queue.getSelectedMessageForReading();
     char currentProcess = 0;
@@ -493,16 +600,170 @@ void LogPlayer::statistics(int frequencies[numOfDataMessageIDs], unsigned* sizes
   }
 }
 
+void LogPlayer::handleAllMessages(MessageHandler& handler, MessageID id)
+{
+  const int numberOfBlocks = indexedLogData ? static_cast<int>(logFileIndex.blocks.size()) : 1;
+  for(int block = 0; block < numberOfBlocks; ++block)
+  {
+    if(indexedLogData)
+    {
+      const std::vector<LogFileIndex::MessageStatistics>& statistics = logFileIndex.blocks[block].statistics;
+      if(std::none_of(statistics.begin(), statistics.end(), [&](const LogFileIndex::MessageStatistics& entry) {return queue.mapID(entry.id) == id;}))
+        continue;
+      loadBlock(block);
+    }
+    for(int i = 0; i < MessageQueue::getNumberOfMessages(); ++i)
+    {
+      queue.setSelectedMessageForReading(i);
+      if(queue.getMessageID() == id)
+      {
+        in.config.reset();
+        in.text.reset();
+        handler.handleMessage(in);
+      }
+    }
+  }
+}
+
+bool LogPlayer::openIndexed(const char* fileName)
+{
+  const File file(fileName, "rb");
+  if(!file.exists())
+    return false;
+  indexedLogFile = new QFile(QString::fromStdString(file.getFullName()));
+  const qint64 size = indexedLogFile->open(QIODevice::ReadOnly) ? indexedLogFile->size() : 0;
+  const char* data = size > 0 ? reinterpret_cast<const char*>(indexedLogFile->map(0, size)) : nullptr;
+  size_t indexStart;
+  if(data && logFileIndex.read(data, static_cast<size_t>(size), indexStart))
+  {
+    // The blocks are stored directly in front of the index, each preceded by its size.
+    size_t blocksSize = 0;
+    for(const LogFileIndex::Block& block : logFileIndex.blocks)
+      blocksSize += sizeof(unsigned) + block.compressedSize;
+    if(blocksSize <= indexStart)
+    {
+      size_t offset = indexStart - blocksSize;
+      for(const LogFileIndex::Block& block : logFileIndex.blocks)
+      {
+        unsigned compressedSize;
+        std::memcpy(&compressedSize, data + offset, sizeof(unsigned));
+        if(compressedSize != block.compressedSize)
+          break;
+        blockOffsets.push_back(offset + sizeof(unsigned));
+        offset += sizeof(unsigned) + compressedSize;
+      }
+      if(blockOffsets.size() == logFileIndex.blocks.size())
+      {
+        indexedLogData = data;
+        return true;
+      }
+    }
+  }
+  closeIndexed();
+  return false;
+}
+
+void LogPlayer::closeIndexed()
+{
+  if(indexedLogFile)
+  {
+    delete indexedLogFile; // also unmaps the file
+    indexedLogFile = nullptr;
+    indexedLogData = nullptr;
+  }
+  logFileIndex.clear();
+  blockOffsets.clear();
+  blockCache.clear();
+  loadedBlock = -1;
+}
+
+bool LogPlayer::uncompressBlock(int block, std::vector<char>& data) const
+{
+  const char* compressed = indexedLogData + blockOffsets[block];
+  const size_t compressedSize = logFileIndex.blocks[block].compressedSize;
+  size_t size = 0;
+  if(snappy_uncompressed_length(compressed, compressedSize, &size) != SNAPPY_OK)
+    return false;
+  data.resize(size);
+  return snappy_uncompress(compressed, compressedSize, data.data(), &size) == SNAPPY_OK;
+}
+
+void LogPlayer::loadBlock(int block)
+{
+  if(block == loadedBlock)
+    return;
+
+  auto i = std::find_if(blockCache.begin(), blockCache.end(), [block](const std::pair<int, std::vector<char>>& entry) {return entry.first == block;});
+  if(i != blockCache.end())
+    blockCache.splice(blockCache.begin(), blockCache, i);
+  else
+  {
+    if(blockCache.size() < maxCachedBlocks)
+      blockCache.emplace_front();
+    else // reuse the memory of the least recently used block
+      blockCache.splice(blockCache.begin(), blockCache, --blockCache.end());
+    blockCache.front().first = block;
+    VERIFY(uncompressBlock(block, blockCache.front().second));
+  }
+
+  queue.clearMessages();
+  InBinaryMemory stream(blockCache.front().second.data(), blockCache.front().second.size());
+  stream >> *this;
+  queue.createIndex();
+  ASSERT(MessageQueue::getNumberOfMessages() == logFileIndex.blocks[block].numberOfMessages);
+  loadedBlock = block;
+}
+
+void LogPlayer::loadAllBlocks()
+{
+  if(indexedLogData)
+  {
+    queue.clearMessages();
+    std::vector<char> data;
+    for(int block = 0; block < static_cast<int>(logFileIndex.blocks.size()); ++block)
+    {
+      VERIFY(uncompressBlock(block, data));
+      InBinaryMemory stream(data.data(), data.size());
+      stream >> *this;
+    }
+    closeIndexed();
+    queue.createIndex();
+  }
+}
+
+void LogPlayer::selectMessage(int message)
+{
+  if(indexedLogData)
+  {
+    const int block = logFileIndex.findBlock(message);
+    loadBlock(block);
+    message -= logFileIndex.blocks[block].firstMessage;
+  }
+  queue.setSelectedMessageForReading(message);
+}
+
+void LogPlayer::copyLogMessage(int message, MessageQueue& other)
+{
+  selectMessage(message);
+  other.out.bin.write(queue.getData(), queue.getMessageSize());
+  other.out.finishMessage(queue.getMessageID());
+}
+
 void LogPlayer::createFrameIndex()
 {
   queue.createIndex();
   frameIndex.clear();
-  frameIndex.reserve(numberOfFrames);
+  numberOfFrames = 0;
   for(int i = 0; i < getNumberOfMessages(); ++i)
   {
     queue.setSelectedMessageForReading(i);
     if(queue.getMessageID() == idProcessBegin)
       frameIndex.push_back(i);
+    else if(queue.getMessageID() == idProcessFinished)
+    {
+      ++numberOfFrames;
+      numberOfMessagesWithinCompleteFrames = i + 1;
+    }
   }
 }
 
@@ -594,7 +855,7 @@ bool LogPlayer::writeTimingData(const std::string& fileName)
   map<unsigned, unsigned> processStartTimes;/**< After parsing this contains the start time of each frame (frames may be missing) */
   for(int currentMessageNumber = 0; currentMessageNumber < getNumberOfMessages(); currentMessageNumber++)
   {
-    queue.setSelectedMessageForReading(currentMessageNumber);
+    selectMessage(currentMessageNumber);
     if(queue.getMessageID() == idStopwatch)
     {//NOTE: this parser is a slightly modified version of the on in TimeInfo
       //first get the names
@@ -685,6 +946,88 @@ bool LogPlayer::writeTimingData(const std::string& fileName)
   return true;
 }
 
+bool LogPlayer::writeTraceData(const std::string& fileName)
+{
+  stop();
+
+  // The ids of the stopwatches are shared by all processes, but the names are only sent
+  // as part of the timing data of each process, a few per frame.
+  map<unsigned short, string> names;
+  for(int currentMessageNumber = 0; currentMessageNumber < getNumberOfMessages(); currentMessageNumber++)
+  {
+    selectMessage(currentMessageNumber);
+    if(queue.getMessageID() == idStopwatch)
+    {
+      unsigned short nameCount;
+      in.bin >> nameCount;
+      for(int i = 0; i < nameCount; ++i)
+      {
+        string watchName;
+        unsigned short watchId;
+        in.bin >> watchId >> watchName;
+        for(string::size_type pos = watchName.find_first_of("\\\""); pos != string::npos; pos = watchName.find_first_of("\\\"", pos + 2))
+          watchName.insert(pos, 1, '\\');
+        names[watchId] = watchName;
+      }
+    }
+  }
+
+  ofstream file(fileName);
+  if(!file.is_open())
+    return false;
+  file << fixed << setprecision(3) << "{\"traceEvents\":[";
+
+  set<pair<char, unsigned char>> threads;
+  char process = 0;
+  const char* separator = "\n";
+  for(int currentMessageNumber = 0; currentMessageNumber < getNumberOfMessages(); currentMessageNumber++)
+  {
+    selectMessage(currentMessageNumber);
+    if(queue.getMessageID() == idProcessBegin)
+      in.bin >> process;
+    else if(queue.getMessageID() == idStopwatchTrace)
+    {
+      unsigned frameNo;
+      unsigned char numOfThreads;
+      in.bin >> frameNo >> numOfThreads;
+      for(int i = 0; i < numOfThreads; ++i)
+      {
+        unsigned char thread;
+        unsigned numOfEvents;
+        uint64_t baseTime;
+        in.bin >> thread >> numOfEvents >> baseTime;
+        threads.emplace(process, thread);
+        for(unsigned j = 0; j < numOfEvents; ++j)
+        {
+          unsigned short watchId;
+          unsigned time;
+          in.bin >> watchId >> time;
+          const auto name = names.find(watchId & 0x7fff);
+          file << separator << "{\"name\":\"" << (name == names.end() ? "unknown" : name->second)
+               << "\",\"ph\":\"" << (watchId & 0x8000 ? 'E' : 'B')
+               << "\",\"ts\":" << static_cast<double>(baseTime + time) / 1000.
+               << ",\"pid\":" << static_cast<int>(process) << ",\"tid\":" << static_cast<int>(thread) << "}";
+          separator = ",\n";
+        }
+      }
+    }
+  }
+
+  // Name the processes and threads
+  for(const pair<char, unsigned char>& thread : threads)
+  {
+    const string processName = thread.first == 'c' ? "Cognition" : thread.first == 'm' ? "Motion" : string(1, thread.first);
+    file << separator << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << static_cast<int>(thread.first)
+         << ",\"args\":{\"name\":\"" << processName << "\"}}";
+    separator = ",\n";
+    file << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << static_cast<int>(thread.first)
+         << ",\"tid\":" << static_cast<int>(thread.second) << ",\"args\":{\"name\":\""
+         << (thread.second ? processName + " thread " + to_string(thread.second) : processName) << "\"}}";
+  }
+  file << "\n]}\n";
+  return file.good();
+}
+
 bool LogPlayer::saveAudioFile(const char* fileName)
 {
   OutBinaryFile stream(fileName);
@@ -695,7 +1038,7 @@ bool LogPlayer::saveAudioFile(const char* fileName)
   AudioData audioData;
   for(currentMessageNumber = 0; currentMessageNumber < getNumberOfMessages(); ++currentMessageNumber)
   {
-    queue.setSelectedMessageForReading(currentMessageNumber);
+    selectMessage(currentMessageNumber);
     if(queue.getMessageID() == idAudioData)
     {
       in.bin >> audioData;
@@ -741,7 +1084,7 @@ bool LogPlayer::saveAudioFile(const char* fileName)
   char* p = (char*) (header + 1);
   for(currentMessageNumber = 0; currentMessageNumber < getNumberOfMessages(); ++currentMessageNumber)
   {
-    queue.setSelectedMessageForReading(currentMessageNumber);
+    selectMessage(currentMessageNumber);
     if(queue.getMessageID() == idAudioData)
     {
       in.bin >> audioData;
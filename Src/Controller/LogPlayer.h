@@ -11,14 +11,21 @@
 #include "Representations/Infrastructure/FrameInfo.h"
 #include "Representations/Infrastructure/Image.h"
 #include "Representations/Infrastructure/JPEGImage.h"
+#include "Tools/MessageQueue/LogFileIndex.h"
 #include "Tools/MessageQueue/MessageQueue.h"
 #include "Tools/Streams/StreamHandler.h"
+#include <list>
+
+class QFile;
 
 /**
 * @class LogPlayer
 *
 * A message queue that can record and play logfiles.
 * The messages are played in the same time sequence as they were recorded.
+* Log files with an index (logFileCompressedWithIndex) are not loaded completely.
+* Instead, the file is mapped into memory and only the blocks that are accessed
+* are decompressed. In that case, the queue only contains a single block.
 *
 * @author Martin Lötzsch
 */
@@ -32,18 +39,25 @@ public:
   LogPlayer(MessageQueue& targetQueue);
 
   /** Destructor. */
-  ~LogPlayer() {if(streamHandler) delete streamHandler;}
+  ~LogPlayer();
 
   /** Deletes all messages from the queue */
   void init();
 
   /**
   * Opens a log file and reads all messages into the queue.
+  * If the log file has an index, only the index is read.
   * @param fileName the name of the file to open
   * @return if the reading was successful
   */
   bool open(const char* fileName);
 
+  /**
+  * Returns the number of messages in the log, including the ones that are
+  * not decompressed yet.
+  */
+  int getNumberOfMessages() const {return indexedLogData ? logFileIndex.getNumberOfMessages() : MessageQueue::getNumberOfMessages();}
+
   /**
   * Plays the queue.
   * Note that you have to call replay() regularly if you want to use that function
@@ -94,6 +108,16 @@ public:
   */
   bool save(const char* fileName, const StreamHandler* streamHandler);
 
+  /**
+  * Writes all messages in the log player queue to a compressed log file with an index
+  * that can be opened without decompressing all of it.
+  * @param fileName the name of the file to write
+  * @param streamHandler Specification of logged data types. Will be ignored if
+  *                      it is a nullptr or logger already has a specification.
+  * @return Whether the writing was successful
+  */
+  bool saveIndexed(const char* fileName, const StreamHandler* streamHandler);
+
   /**
   * Writes all audio data in the log player queue to a single wav file.
   * @param fileName the name of the file to write
@@ -115,6 +139,14 @@ public:
    */
   bool writeTimingData(const std::string& fileName);
 
+  /**
+   * Writes the stopwatch traces in the Chrome trace event format, which can
+   * be viewed in chrome://tracing or Perfetto.
+   * @param fileName The name of the json file.
+   * @return true if writing was successful
+   */
+  bool writeTraceData(const std::string& fileName);
+
   /**
   * Save an image to a file.
   * @param image The image to save.
@@ -158,6 +190,16 @@ public:
   */
   void statistics(int frequencies[numOfDataMessageIDs], unsigned* sizes = nullptr, char processIdentifier = 0);
 
+  using MessageQueue::handleAllMessages;
+
+  /**
+  * Calls a message handler for all messages of a certain type. If the log file
+  * has an index, only the blocks that contain such messages are decompressed.
+  * @param handler The message handler.
+  * @param id The type of the messages.
+  */
+  void handleAllMessages(MessageHandler& handler, MessageID id);
+
   /** different states of the logplayer */
   ENUM(LogPlayerState,
   {,
@@ -182,6 +224,59 @@ private:
   std::vector<int> frameIndex; /**< The message numbers the frames start at. */
   StreamHandler* streamHandler; /**< The stream specification of the log file entries. */
 
+  static constexpr size_t maxCachedBlocks = 4; /**< The number of decompressed blocks kept in memory. */
+  static constexpr unsigned indexedBlockSize = 4 << 20; /**< The uncompressed size of the blocks written by saveIndexed(). */
+  QFile* indexedLogFile = nullptr; /**< The log file with an index that is mapped into memory. */
+  const char* indexedLogData = nullptr; /**< The contents of the mapped log file. nullptr if all messages are in the queue. */
+  LogFileIndex logFileIndex; /**< The index of the mapped log file. */
+  std::vector<size_t> blockOffsets; /**< The offsets of the compressed blocks in the mapped log file. */
+  std::list<std::pair<int, std::vector<char>>> blockCache; /**< Recently decompressed blocks, most recently used first. */
+  int loadedBlock = -1; /**< The block that is in the queue. */
+
+  /**
+  * Tries to map a log file with an index into memory.
+  * @param fileName The name of the log file.
+  * @return Was the index found? If not, the log file must be read as a compressed log file.
+  */
+  bool openIndexed(const char* fileName);
+
+  /** Unmaps the log file with an index if one is mapped. */
+  void closeIndexed();
+
+  /**
+  * Decompresses a block of the mapped log file.
+  * @param block The index of the block.
+  * @param data The decompressed block, i.e. a streamed message queue.
+  * @return Was the block decompressed successfully?
+  */
+  bool uncompressBlock(int block, std::vector<char>& data) const;
+
+  /**
+  * Replaces the messages in the queue by a block of the mapped log file.
+  * The blocks decompressed last are cached.
+  * @param block The index of the block.
+  */
+  void loadBlock(int block);
+
+  /**
+  * Decompresses all blocks of the mapped log file into the queue and unmaps it.
+  * Afterwards, the log player works as if the file had no index.
+  */
+  void loadAllBlocks();
+
+  /**
+  * Selects a message for reading. Loads the block containing the message if required.
+  * @param message The number of the message in the whole log.
+  */
+  void selectMessage(int message);
+
+  /**
+  * Copies a message to another queue. Loads the block containing the message if required.
+  * @param message The number of the message in the whole log.
+  * @param other The queue the message is copied to.
+  */
+  void copyLogMessage(int message, MessageQueue& other);
+
   /**
   * The method counts the number of frames.
   */
@@ -189,6 +284,7 @@ private:
 
   /**
    * Creates the index of the first message numbers of all frames.
+   * Also counts the number of frames.
    */
   void createFrameIndex();
 
@@ -1299,7 +1299,7 @@ bool RobotConsole::log(In& stream, bool first)
     logPlayer.init();
     return true;
   }
-  else if(command == "save")
+  else if(command == "save" || command == "saveIndexed")
   {
     std::string name;
     stream >> name;
@@ -1308,7 +1308,7 @@ bool RobotConsole::log(In& stream, bool first)
     else if(first && logFile == "") // poll specification if created new log file
     {
       polled[idStreamSpecification] = false;
-      handleConsole("_log save " + name);
+      handleConsole("_log " + command + " " + name);
       return true;
     }
     else
@@ -1318,6 +1318,8 @@ bool RobotConsole::log(In& stream, bool first)
       if(name[0] != '/' && name[0] != '\\' && (name.size() < 2 || name[1] != ':'))
         name = std::string("Logs\\") + name;
       SYNC;
+      if(command == "saveIndexed")
+        return logPlayer.saveIndexed(name.c_str(), logFile == "" ? &streamHandler : nullptr);
       return logPlayer.save(name.c_str(), logFile == "" ? &streamHandler : nullptr);
     }
   }
@@ -1366,6 +1368,20 @@ bool RobotConsole::log(In& stream, bool first)
       return logPlayer.writeTimingData(name);
     }
   }
+  else if(command == "saveTrace")
+  {
+    SYNC;
+    std::string name;
+    stream >> name;
+    if(name.size() == 0)
+      return false;
+    else
+    {
+      if((int) name.rfind('.') <= (int) name.find_last_of("\\/"))
+        name = name + ".json";
+      return logPlayer.writeTraceData(name);
+    }
+  }
   else if(command == "keep" || command == "remove")
   {
     SYNC;
@@ -1502,7 +1518,7 @@ bool RobotConsole::log(In& stream, bool first)
         LogPlayer::LogPlayerState state = logPlayer.state;
         bool result = logPlayer.open(name.c_str());
         if(result)
-          logPlayer.handleAllMessages(annotationInfos['c']);
+          logPlayer.handleAllMessages(annotationInfos['c'], idAnnotation);
         if(result && state == LogPlayer::playing)
           logPlayer.play();
         return result;
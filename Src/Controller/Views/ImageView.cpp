@@ -252,9 +252,13 @@ void ImageWidget::copyImageSegmented(const Image& srcImage)
   unsigned* p = (unsigned*) imageData->bits();
   const unsigned char drawnColors = (unsigned char)(drawAllColors ? ~0 : 1 << (drawnColor - 1));
   const ColorTable& ct = imageView.console.colorTable;
+  std::vector<ColorTable::Colors> colors(width);
   for(int y = 0; y < height; ++y)
-    for(const Image::Pixel* cur = &srcImage[y][0], * end = cur + width; cur < end; ++cur)
-      *p++ = displayColors[ct[*cur].colors & drawnColors];
+  {
+    ct.classify(srcImage[y], width, colors.data());
+    for(const ColorTable::Colors& color : colors)
+      *p++ = displayColors[color.colors & drawnColors];
+  }
 }
 
 void ImageWidget::paintImage(QPainter& painter, const Image& srcImage)
@@ -28,7 +28,7 @@ void HeadControl2014::resetQueue()
 {
   targetQueue.clear();
   relativeAngleReached = false;
-  if (Blackboard::getInstance().exists("FrameInfo"))
+  if (Blackboard::getInstance().exists(idFrameInfo))
     timeStampTarget = theFrameInfo.time;
 }
 
@@ -8,7 +8,7 @@
 
 #include "CameraProvider.h"
 #include "Platform/SystemCall.h"
-#include "Representations/Infrastructure/JPEGImage.h"
+#include "Tools/ImageProcessing/JPEGEncoder.h"
 #include "Tools/Streams/InStreams.h"
 #include "Tools/Debugging/Stopwatch.h"
 
@@ -35,6 +35,8 @@ CameraProvider::CameraProvider() :
 
 CameraProvider::~CameraProvider()
 {
+  delete jpegEncoder;
+  delete jpegEncoderUpper;
 #ifdef CAMERA_INCLUDED
   if(upperCamera)
   {
@@ -73,7 +75,12 @@ void CameraProvider::update(Image& image)
 #endif // CAMERA_INCLUDED
   STOPWATCH("compressJPEG")
   {
-    DEBUG_RESPONSE("representation:JPEGImage") OUTPUT(idJPEGImage, bin, JPEGImage(image));
+    DEBUG_RESPONSE("representation:JPEGImage")
+    {
+      if(!jpegEncoder)
+        jpegEncoder = new JPEGEncoder;
+      jpegEncoder->stream(image, idJPEGImage);
+    }
   }
 }
 
@@ -113,7 +120,12 @@ void CameraProvider::update(ImageUpper& imageUpper)
 #endif // CAMERA_INCLUDED
   STOPWATCH("compressJPEGUpper")
   {
-    DEBUG_RESPONSE("representation:JPEGImageUpper") OUTPUT(idJPEGImageUpper, bin, JPEGImage(imageUpper));
+    DEBUG_RESPONSE("representation:JPEGImageUpper")
+    {
+      if(!jpegEncoderUpper)
+        jpegEncoderUpper = new JPEGEncoder;
+      jpegEncoderUpper->stream(imageUpper, idJPEGImageUpper);
+    }
   }
 }
 
@@ -16,6 +16,7 @@
 #include "Tools/Module/Module.h"
 
 class NaoCamera;
+class JPEGEncoder;
 
 MODULE(CameraProvider,
 {,
@@ -40,6 +41,8 @@ private:
 
   NaoCamera* upperCamera = nullptr;
   NaoCamera* lowerCamera = nullptr;
+  JPEGEncoder* jpegEncoder = nullptr; /**< Compresses the lower images streamed in a thread of its own. Created on demand. */
+  JPEGEncoder* jpegEncoderUpper = nullptr; /**< Compresses the upper images streamed in a thread of its own. Created on demand. */
   CameraInfo lowerCameraInfo;
   CameraInfoUpper upperCameraInfo;
   CameraSettings lowerCameraSettings;
@@ -8,10 +8,12 @@
 
 #include "CameraProviderV6.h"
 #include "Platform/SystemCall.h"
-#include "Representations/Infrastructure/JPEGImage.h"
+#include "Tools/ImageProcessing/JPEGEncoder.h"
 #include "Tools/Streams/InStreams.h"
 #include "Tools/Debugging/Stopwatch.h"
+#include "Tools/Module/Blackboard.h"
 #include "Tools/Settings.h"
+#include "Representations/Infrastructure/LowFrameRateImage.h"
 #include <chrono>
 #include <thread>
 
@@ -41,6 +43,11 @@ CameraProviderV6::CameraProviderV6() :
 
 CameraProviderV6::~CameraProviderV6()
 {
+#ifdef CAMERA_INCLUDED
+  releaseFrameBuffers();
+#endif
+  delete jpegEncoder;
+  delete jpegEncoderUpper;
 #ifdef CAMERA_INCLUDED
   if (upperCamera)
   {
@@ -66,7 +73,7 @@ void CameraProviderV6::update(Image& image)
   if (lowerCamera->hasImage())
   {
     image.setResolution(lowerCameraInfo.width, lowerCameraInfo.height);
-    image.setImage(const_cast<unsigned char*>(lowerCamera->getImage()));
+    image.setImage(lowerCamera->getFrameBuffer());
     lastImageTimeStampLL = lowerCamera->getTimeStamp();
     if (Global::getSettings().naoVersion == RobotConfig::V6)
     {
@@ -89,7 +96,12 @@ void CameraProviderV6::update(Image& image)
 #endif // CAMERA_INCLUDED
   STOPWATCH("compressJPEG")
   {
-    DEBUG_RESPONSE("representation:JPEGImage") OUTPUT(idJPEGImage, bin, JPEGImage(image));
+    DEBUG_RESPONSE("representation:JPEGImage")
+    {
+      if(!jpegEncoder)
+        jpegEncoder = new JPEGEncoder;
+      jpegEncoder->stream(image, idJPEGImage);
+    }
   }
 }
 
@@ -111,7 +123,7 @@ void CameraProviderV6::update(ImageUpper& imageUpper)
   if (upperCamera->hasImage())
   {
     imageUpper.setResolution(upperCameraInfo.width, upperCameraInfo.height);
-    imageUpper.setImage(const_cast<unsigned char*>(upperCamera->getImage()));
+    imageUpper.setImage(upperCamera->getFrameBuffer());
     //lastImageTimeStampLLUpper is in micro seconds and 64 bit
     lastImageTimeStampLLUpper = upperCamera->getTimeStamp();
     if (Global::getSettings().naoVersion == RobotConfig::V6)
@@ -147,7 +159,12 @@ void CameraProviderV6::update(ImageUpper& imageUpper)
 #endif // CAMERA_INCLUDED
   STOPWATCH("compressJPEGUpper")
   {
-    DEBUG_RESPONSE("representation:JPEGImageUpper") OUTPUT(idJPEGImageUpper, bin, JPEGImage(imageUpper));
+    DEBUG_RESPONSE("representation:JPEGImageUpper")
+    {
+      if(!jpegEncoderUpper)
+        jpegEncoderUpper = new JPEGEncoder;
+      jpegEncoderUpper->stream(imageUpper, idJPEGImageUpper);
+    }
   }
 }
 
@@ -305,6 +322,7 @@ void CameraProviderV6::setupCameras()
   upperCameraInfo.updateFocalLength();
   lowerCameraInfo.updateFocalLength();
 #ifdef CAMERA_INCLUDED
+  releaseFrameBuffers();
   if (upperCamera != nullptr)
     delete upperCamera;
   if (lowerCamera != nullptr)
@@ -326,6 +344,23 @@ void CameraProviderV6::setupCameras()
 #endif
 }
 
+void CameraProviderV6::releaseFrameBuffers()
+{
+  Blackboard& blackboard = Blackboard::getInstance();
+  if (blackboard.exists("Image"))
+    static_cast<Image&>(blackboard["Image"]).unshare();
+  if (blackboard.exists("ImageUpper"))
+    static_cast<ImageUpper&>(blackboard["ImageUpper"]).unshare();
+  if (blackboard.exists("LowFrameRateImage"))
+    static_cast<LowFrameRateImage&>(blackboard["LowFrameRateImage"]).image.unshare();
+  if (blackboard.exists("LowFrameRateImageUpper"))
+    static_cast<LowFrameRateImageUpper&>(blackboard["LowFrameRateImageUpper"]).image.unshare();
+  if (jpegEncoder)
+    jpegEncoder->release();
+  if (jpegEncoderUpper)
+    jpegEncoderUpper->release();
+}
+
 bool CameraProviderV6::isFrameDataComplete()
 {
 #ifdef CAMERA_INCLUDED
@@ -427,6 +462,8 @@ void CameraProviderV6::waitForFrameData2()
     if (resetUpper) resetLower = true;
     if (resetLower) resetUpper = true;
 
+    if (resetUpper || resetLower)
+      releaseFrameBuffers();
     if (resetUpper)
     {
       BH_TRACE;
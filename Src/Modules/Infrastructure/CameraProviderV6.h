@@ -16,6 +16,7 @@
 #include "Tools/Module/Module.h"
 
 class NaoCameraV6;
+class JPEGEncoder;
 
 MODULE(CameraProviderV6,
 {,
@@ -40,6 +41,8 @@ private:
 
   NaoCameraV6* upperCamera = nullptr;
   NaoCameraV6* lowerCamera = nullptr;
+  JPEGEncoder* jpegEncoder = nullptr; /**< Compresses the lower images streamed in a thread of its own. Created on demand. */
+  JPEGEncoder* jpegEncoderUpper = nullptr; /**< Compresses the upper images streamed in a thread of its own. Created on demand. */
   CameraInfo lowerCameraInfo;
   CameraInfoUpper upperCameraInfo;
   CameraSettingsV6 lowerCameraSettings;
@@ -100,4 +103,11 @@ private:
   bool processResolutionRequest();
 
   void setupCameras();
+
+  /**
+   * Drops all references to the frame buffers of the cameras before they are
+   * deleted. Otherwise, the devices would stay open and could not be configured
+   * again. The images on the blackboard keep copies of their pixels.
+   */
+  void releaseFrameBuffers();
 };
@@ -7,70 +7,30 @@ IntegralImageProvider::IntegralImageProvider()
 
 void IntegralImageProvider::update(IntegralImage &integralImage)
 {
-  if (theFrameInfo.time != timeStampLastExecuted)
-  {
-    timeStampLastExecuted = theFrameInfo.time;
-    execute();
-  }
-  integralImage = lowerImage;
-}
-void IntegralImageProvider::update(IntegralImageUpper &integralImageUpper)
-{
-  if (theFrameInfo.time != timeStampLastExecuted)
-  {
-    timeStampLastExecuted = theFrameInfo.time;
-    execute();
-  }
-  integralImageUpper = upperImage;
-}
-
-void IntegralImageProvider::execute()
-{
-  if (!initialized)
-  {
-    lowerImage.init(widthLower, heightLower);
-    upperImage.init(widthUpper, heightUpper);
-    INIT_DEBUG_IMAGE_BLACK(IntegralImage, widthLower, heightLower);
-    INIT_DEBUG_IMAGE_BLACK(IntegralImageUpper, widthUpper, heightUpper);
-  }
+  if (integralImage.width != widthLower || integralImage.height != heightLower)
+    integralImage.init(widthLower, heightLower);
   if (createLower)
   {
     if (fromGrayLower)
     {
       if (fromSobelLower)
-        lowerImage.createIntegralImageDiffFromGraySobel(theSobelImage, theFieldColors.fieldColorArray[0].fieldColorOptY);
+        integralImage.createIntegralImageDiffFromGraySobel(theSobelImage, theFieldColors.fieldColorArray[0].fieldColorOptY);
       else
-        lowerImage.createIntegralImageDiffFromGray(theImage, theFieldColors.fieldColorArray[0].fieldColorOptY);
+        integralImage.createIntegralImageDiffFromGray(theImage, theFieldColors.fieldColorArray[0].fieldColorOptY);
     }
     else
     {
       if (fromSobelLower)
-        lowerImage.createIntegralImageSobel(theSobelImage);
-      else
-        lowerImage.createIntegralImage(theImage);
-    }
-  }
-  if (createUpper)
-  {
-    if (fromGrayUpper)
-    {
-      if (fromSobelUpper)
-        upperImage.createIntegralImageDiffFromGraySobel(theSobelImageUpper, theFieldColorsUpper.fieldColorArray[0].fieldColorOptY);
-      else
-        upperImage.createIntegralImageDiffFromGray(theImageUpper, theFieldColorsUpper.fieldColorArray[0].fieldColorOptY);
-    }
-    else
-    {
-      if (fromSobelUpper)
-        upperImage.createIntegralImageSobel(theSobelImageUpper);
+        integralImage.createIntegralImageSobel(theSobelImage);
       else
-        upperImage.createIntegralImage(theImageUpper);
+        integralImage.createIntegralImage(theImage);
     }
   }
   COMPLEX_IMAGE(IntegralImage)
   {
-    int width = lowerImage.width;
-    int height = lowerImage.height;
+    int width = integralImage.width;
+    int height = integralImage.height;
+    INIT_DEBUG_IMAGE_BLACK(IntegralImage, width, height);
     int rowIndex = 0;
     int lastRowIndex = -width;
     for (int y = 1; y < height; y++)
@@ -79,19 +39,43 @@ void IntegralImageProvider::execute()
       lastRowIndex += width;
       for (int x = 1; x < width; x++)
       {
-        int pixelValue = lowerImage.image[rowIndex + x]
-          + lowerImage.image[lastRowIndex + x - 1]
-          - lowerImage.image[rowIndex + x - 1]
-          - lowerImage.image[lastRowIndex + x];
+        int pixelValue = integralImage.image[rowIndex + x]
+          + integralImage.image[lastRowIndex + x - 1]
+          - integralImage.image[rowIndex + x - 1]
+          - integralImage.image[lastRowIndex + x];
         DEBUG_IMAGE_SET_PIXEL_YUV(IntegralImage, x, y, static_cast<unsigned char>(pixelValue), 127, 127);
       }
     }
     SEND_DEBUG_IMAGE(IntegralImage);
   }
+}
+
+void IntegralImageProvider::update(IntegralImageUpper &integralImageUpper)
+{
+  if (integralImageUpper.width != widthUpper || integralImageUpper.height != heightUpper)
+    integralImageUpper.init(widthUpper, heightUpper);
+  if (createUpper)
+  {
+    if (fromGrayUpper)
+    {
+      if (fromSobelUpper)
+        integralImageUpper.createIntegralImageDiffFromGraySobel(theSobelImageUpper, theFieldColorsUpper.fieldColorArray[0].fieldColorOptY);
+      else
+        integralImageUpper.createIntegralImageDiffFromGray(theImageUpper, theFieldColorsUpper.fieldColorArray[0].fieldColorOptY);
+    }
+    else
+    {
+      if (fromSobelUpper)
+        integralImageUpper.createIntegralImageSobel(theSobelImageUpper);
+      else
+        integralImageUpper.createIntegralImage(theImageUpper);
+    }
+  }
   COMPLEX_IMAGE(IntegralImageUpper)
   {
-    int width = upperImage.width;
-    int height = upperImage.height;
+    int width = integralImageUpper.width;
+    int height = integralImageUpper.height;
+    INIT_DEBUG_IMAGE_BLACK(IntegralImageUpper, width, height);
     int rowIndex = 0;
     int lastRowIndex = -width;
     for (int y = 1; y < height; y++)
@@ -100,10 +84,10 @@ void IntegralImageProvider::execute()
       lastRowIndex += width;
       for (int x = 1; x < width; x++)
       {
-        int pixelValue = upperImage.image[rowIndex + x]
-          + upperImage.image[lastRowIndex + x - 1]
-          - upperImage.image[rowIndex + x - 1]
-          - upperImage.image[lastRowIndex + x];
+        int pixelValue = integralImageUpper.image[rowIndex + x]
+          + integralImageUpper.image[lastRowIndex + x - 1]
+          - integralImageUpper.image[rowIndex + x - 1]
+          - integralImageUpper.image[lastRowIndex + x];
         DEBUG_IMAGE_SET_PIXEL_YUV(IntegralImageUpper, x, y, static_cast<unsigned char>(pixelValue), 127, 127);
       }
     }
@@ -111,4 +95,4 @@ void IntegralImageProvider::execute()
   }
 }
 
-MAKE_MODULE(IntegralImageProvider, perception);
\ No newline at end of file
+MAKE_MODULE(IntegralImageProvider, perception);
@@ -43,13 +43,7 @@ public:
   IntegralImageProvider();
 
 private:
+  /** The integral images are created in place, i.e. in the representations themselves. */
   void update(IntegralImage &integralImage);
   void update(IntegralImageUpper &integralImageUpper);
-  void execute();
-
-  unsigned timeStampLastExecuted = 0;
-
-  IntegralImage lowerImage;
-  IntegralImageUpper upperImage;
-  bool initialized = false;
 };
\ No newline at end of file
@@ -53,9 +53,7 @@ void LowFrameRateImageProvider::logCurrentImage(LowFrameRateImage& lowFrameRateI
 void LowFrameRateImageProvider::updateImage(LowFrameRateImage& lfrImage, bool upper) const
 {
   const Image& image = upper ? (Image&)theImageUpper : theImage;
-  lfrImage.image.setImage(const_cast<Image::Pixel*>(image[0]));
-  lfrImage.image.setResolution(image.width, image.height, image.isFullSize);
-  lfrImage.image.timeStamp = image.timeStamp;
+  lfrImage.image.shareImage(image);
   lfrImage.imageUpdated = true;
 }
 
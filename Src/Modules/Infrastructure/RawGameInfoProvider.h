@@ -66,8 +66,8 @@ private:
 #else
   void update(RawGameInfo& rawGameInfo)
   { 
-    if(Blackboard::getInstance().exists("GameInfo"))
-      (GameInfo&) rawGameInfo = (GameInfo&) Blackboard::getInstance()["GameInfo"]; 
+    if(Blackboard::getInstance().exists(idGameInfo))
+      (GameInfo&) rawGameInfo = (GameInfo&) Blackboard::getInstance()[idGameInfo]; 
   }
   void update(OpponentTeamInfo& teamInfo) {}
   void update(OwnTeamInfo& ownTeamInfo) {}
@@ -236,6 +236,7 @@ void LineMatcher::execute(LineMatchingResult & theLineMatchingResult)
 
   // reset theLineMatchingResult
   theLineMatchingResult.reset();
+  theLineMatchingResult.timestamp = theFrameInfo.time;
   for (const auto& i : theCLIPFieldLinesPercept.lines)
   {
     LineMatchingResult::FieldLine obs(i.startOnField.cast<double>(), i.endOnField.cast<double>(),
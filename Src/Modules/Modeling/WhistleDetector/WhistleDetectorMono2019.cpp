@@ -1,5 +1,6 @@
 #include "WhistleDetectorMono2019.h"
 #include "Tools/Settings.h"
+#include <xmmintrin.h>
 
 #define DEBUG_WIDTH 512
 #define DEBUG_HEIGHT 300
@@ -16,23 +17,26 @@
 
 WhistleDetectorMono2019::WhistleDetectorMono2019()
 {
-    ringPos = 0;
-
-    samplesLeft = params.WINDOW_SIZE / 2;
-    buffer = std::vector<float>(params.WINDOW_SIZE); //TODO: new in set, free in play
-
-    currMinAmp = params.MIN_AMP;
     channelRequest = params.USE_CHANNEL+1; // makes sure request is checked in initial update iteration
     currChannel = 0;
 
     releaseCount = static_cast<unsigned int>(params.RELEASE);
     attackCount = 0;
 
-    in = std::vector<kiss_fft_cpx>(params.WINDOW_SIZE);
-    out = std::vector<kiss_fft_cpx>(params.WINDOW_SIZE);
-    amplitudes = std::vector<float>(AMP_SIZE);
-
     SET_DEBUG_IMAGE_SIZE(CHROMA, CHROMA_WIDTH, AMP_SIZE);
+
+    // log files are replayed synchronously, so that the results do not depend on timing
+    if (SystemCall::getMode() != SystemCall::logfileReplay)
+        analysisThread.start(this, &WhistleDetectorMono2019::run);
+}
+
+WhistleDetectorMono2019::~WhistleDetectorMono2019()
+{
+    analysisThread.announceStop();
+    samplesAvailable.post();
+    analysisThread.stop();
+    if (fftConfig)
+        kiss_fftr_free(fftConfig);
 }
 
 void WhistleDetectorMono2019::update(WhistleDortmund &whistle)
@@ -57,140 +61,50 @@ void WhistleDetectorMono2019::update(WhistleDortmund &whistle)
       }
     }
 
-    //declare detection variables
-    int peak1Pos = -1, peak2Pos = -1;
-
     if (theAudioData.isValid)
     {
-        unsigned int audioDataPos = params.USE_CHANNEL;
-
-        while (audioDataPos < theAudioData.samples.size())
         {
-            while (audioDataPos < theAudioData.samples.size() && samplesLeft > 0)
-            {
-                buffer[ringPos] = theAudioData.samples[audioDataPos];
-
-                audioDataPos += channels; // skip all channels but one
-                samplesLeft--;
-                ringPos = (ringPos + 1) % params.WINDOW_SIZE;
-            }
-
-            if (samplesLeft == 0)
-            {
-                whistle.detectionState = WhistleDortmund::DetectionState::notDetected;
-                samplesLeft = params.WINDOW_SIZE / 2;
-
-                for (unsigned int i = 0; i < static_cast<unsigned int>(params.WINDOW_SIZE); i++)
-                {
-                    in[i].r = buffer[(i + ringPos) % params.WINDOW_SIZE];
-                    in[i].i = 0.f;
-
-                    //apply Hann window
-                    if (params.USE_HANN_WINDOWING)
-                       in[i].r *= std::pow(std::sin(pi * i / params.WINDOW_SIZE), 2.f);
-                    else if (params.USE_NUTTALL_WINDOWING)
-                       in[i].r *= 0.355768f
-                           - 0.487396f * std::sin(1 * pi * i / params.WINDOW_SIZE)
-                           + 0.144232f * std::sin(2 * pi * i / params.WINDOW_SIZE)
-                           - 0.012604f * std::sin(3 * pi * i / params.WINDOW_SIZE);
-                }
-
-                //do FFT analysis
-                kissFFT(in.data(), out.data());
-
-                for (int i = 0; i < AMP_SIZE; i++)
-                {
-                    amplitudes[i] = std::sqrt((out[i].r * out[i].r) + (out[i].i * out[i].i)); //TODO: sqrt necessary?
-                }
-
-                // calculate min_amp regarding environment noise level
-                currMinAmp = calc_noise_based_min_amp(amplitudes, sampleRate, params.NOISE_HISTORY_SIZE);
-
-                //do peak detection
-                int min_i = params.MIN_FREQ_WHISTLE * params.WINDOW_SIZE / sampleRate;
-                int max_i = params.MAX_FREQ_WHISTLE * params.WINDOW_SIZE / sampleRate;
-
-                int lastPeakPos = peakPos;
-                // recalculate peakPos
-                peakPos = min_i;
-				//get maximum
-                for (int i = min_i; i <= max_i; i++)
-                {
-                    if (amplitudes[i] > amplitudes[peakPos])
-                        peakPos = i;
-                }
-                if (lastPeakPos == -1) { // case no peak has been there recently
-                  lastPeakPos = peakPos;
-                }
-                if (amplitudes[peakPos] >= currMinAmp)// && std::abs(peakPos - lastPeakPos) < params.PEAK_DIFF)
-                {
-                    min_i = static_cast<int>(peakPos * params.OVERTONE_MULT_MIN_1);
-                    max_i = static_cast<int>(peakPos * params.OVERTONE_MULT_MAX_1);
-
-                    peak1Pos = min_i;
-                    for (int i = min_i; i <= max_i; i++) //maximum for overtone 1
-                    {
-                        if (amplitudes[i] > amplitudes[peak1Pos])
-                            peak1Pos = i;
-                    }
-
-                    if (amplitudes[peak1Pos] >= amplitudes[peakPos]*params.OVERTONE_MIN_AMP_1) //overtone 1 is "good enough"
-                    {
-                        min_i = static_cast<int>(peakPos * params.OVERTONE_MULT_MIN_2);
-                        max_i = static_cast<int>(peakPos * params.OVERTONE_MULT_MAX_2);
-
-                        peak2Pos = min_i;
-                        for (int i = min_i; i <= max_i; i++)
-                        {
-                            if (amplitudes[i] > amplitudes[peak2Pos])
-                                peak2Pos = i;
-                        }
-
-                        if (amplitudes[peak2Pos] >= amplitudes[peakPos]*params.OVERTONE_MIN_AMP_2)
-                        {                           
-                            if (theFrameInfo.getTimeSince(lastAttackTime) < params.ATTACK_TIMEOUT_MS)
-                            {
-                                //add attack to prevent short noises to be detected as whistles
-                                attackCount++;
-                                if (attackCount >= static_cast<unsigned int>(params.ATTACK))
-                                {
-                                    whistle.detectionState = WhistleDortmund::DetectionState::isDetected;
-                                    whistle.lastDetectionTime = theFrameInfo.time;
-
-                                    // print some peak relations for parameter definition
-                                    //printf("peak0=%.3f, peak1=%.3f, peak1/peak0=%.3f\n", amplitudes[peakPos],amplitudes[peak1Pos],(amplitudes[peak1Pos]/amplitudes[peakPos]));
-                                }
-                            }
-                            else
-                            {
-                                attackCount = 0;
-                                peakPos = -1;
-                            }
-                            lastAttackTime = theFrameInfo.time;
-                        }
-                    }
-                }
-                //add release to ensure the detection plot to be smooth
-                if (whistle.detectionState == WhistleDortmund::DetectionState::isDetected) {
-                    releaseCount = 0;
-                }
-                else if (releaseCount < static_cast<unsigned int>(params.RELEASE))
-                {
-                    whistle.detectionState = WhistleDortmund::DetectionState::isDetected;
-                    releaseCount += 1;
-                }
-            }
+            SYNC;
+            // hand the samples over to the analysis thread, but do not let them pile up if it cannot keep up
+            const size_t maxPendingSamples = static_cast<size_t>(sampleRate) * channels;
+            if (pendingChannels != channels || pendingSampleRate != theAudioData.sampleRate)
+                pendingSamples.clear();
+            pendingSamples.insert(pendingSamples.end(), theAudioData.samples.begin(), theAudioData.samples.end());
+            if (pendingSamples.size() > maxPendingSamples)
+                pendingSamples.erase(pendingSamples.begin(), pendingSamples.end() - maxPendingSamples / channels * channels);
+            pendingChannels = channels;
+            pendingSampleRate = theAudioData.sampleRate;
+            pendingTime = theFrameInfo.time;
+            pendingParams = params;
+            pendingChannel = currChannel;
         }
+
+        // without the analysis thread, the samples of this frame are analyzed right away
+        if (!analysisThread.isRunning())
+            analyzePending();
+
+        // pick up the latest results
+        SYNC;
+        whistle = detection;
+        amplitudes = debugAmplitudes;
+        currMinAmp = debugMinAmp;
+        peakPos = debugPeakPos;
+        peak1Pos = debugPeak1Pos;
+        peak2Pos = debugPeak2Pos;
     }
     else
     {
+        SYNC;
+        pendingSamples.clear();
+        reset = true;
+        detection.detectionState = WhistleDortmund::DetectionState::dontKnow;
         whistle.detectionState = WhistleDortmund::DetectionState::dontKnow;
-        attackCount = 0;
-        peakPos = 0;
     }
+    if (theAudioData.isValid && analysisThread.isRunning())
+        samplesAvailable.post();
 
     //debug draw FFT with detection rects and grids
-    if (theAudioData.isValid)
+    if (theAudioData.isValid && !amplitudes.empty())
     COMPLEX_IMAGE(FFT)
     {
         // transform sample rate to fft size to debug image size
@@ -294,7 +208,7 @@ void WhistleDetectorMono2019::update(WhistleDortmund &whistle)
     }
 
     // draw chroma view of FFTs in a short period of time
-    if (theAudioData.isValid)
+    if (theAudioData.isValid && static_cast<int>(amplitudes.size()) == AMP_SIZE)
     COMPLEX_IMAGE(CHROMA)
     {
         // fill vertical line with FFT informations
@@ -314,61 +228,289 @@ void WhistleDetectorMono2019::update(WhistleDortmund &whistle)
     PLOT("representation:Whistle:detected", (int)whistle.detectionState - 1);
 }
 
-/**
-*   Note that the arrays in and out must have the same size as given by param size
-*/
-void WhistleDetectorMono2019::kissFFT(kiss_fft_cpx in[], kiss_fft_cpx out[])
+void WhistleDetectorMono2019::run()
 {
-    kiss_fft_cfg cfg;
+    Thread<WhistleDetectorMono2019>::setName("WhistleDetector");
 
-    if ((cfg = kiss_fft_alloc(params.WINDOW_SIZE, 0/*is_inverse_fft*/, NULL, NULL)) != NULL)
+    while (analysisThread.isRunning())
     {
-        kiss_fft(cfg, in, out);
-        free(cfg);
+        if (samplesAvailable.wait(100)) // wait 100 ms for new samples, then check again if we should quit
+            analyzePending();
     }
-    else
+}
+
+void WhistleDetectorMono2019::analyzePending()
+{
+    unsigned channels, sampleRate, time, selectedChannel;
+    {
+        SYNC;
+        if (reset)
+        {
+            reset = false;
+            attackCount = 0;
+            for (Channel& channel : channelStates)
+                channel.peakPos = -1;
+            analysisResult.detectionState = WhistleDortmund::DetectionState::dontKnow;
+        }
+        if (pendingSamples.empty())
+            return;
+        samples.swap(pendingSamples); // both keep their capacity, so this does not allocate
+        pendingSamples.clear();
+        channels = pendingChannels;
+        sampleRate = pendingSampleRate;
+        time = pendingTime;
+        selectedChannel = std::min(pendingChannel, channels - 1);
+        analysisParams = pendingParams;
+    }
+
+    if (!analyze(channels, sampleRate, time, selectedChannel))
+        return;
+
+    SYNC;
+    if (!reset)
+    {
+        const Channel& drawn = channelStates[selectedChannel];
+        detection = analysisResult;
+        debugAmplitudes.assign(drawn.amplitudes.begin(), drawn.amplitudes.end());
+        debugMinAmp = drawn.currMinAmp;
+        debugPeakPos = drawn.peakPos;
+        debugPeak1Pos = drawn.peak1Pos;
+        debugPeak2Pos = drawn.peak2Pos;
+    }
+}
+
+void WhistleDetectorMono2019::prepare(unsigned channels)
+{
+    const WhistleDetectorMono2019Params& p = analysisParams;
+    ASSERT(p.WINDOW_SIZE > 0 && p.WINDOW_SIZE % 2 == 0); // the real-input FFT requires an even size
+
+    if (fftSize != p.WINDOW_SIZE || hann != p.USE_HANN_WINDOWING || nuttall != p.USE_NUTTALL_WINDOWING)
+    {
+        if (fftSize != p.WINDOW_SIZE)
+        {
+            if (fftConfig)
+                kiss_fftr_free(fftConfig);
+            fftConfig = kiss_fftr_alloc(p.WINDOW_SIZE, 0/*is_inverse_fft*/, nullptr, nullptr);
+            ASSERT(fftConfig);
+            windowed.resize(p.WINDOW_SIZE);
+            spectrum.resize(p.WINDOW_SIZE / 2 + 1);
+            channelStates.clear(); // the ring buffers have to be refilled
+        }
+        fftSize = p.WINDOW_SIZE;
+        hann = p.USE_HANN_WINDOWING;
+        nuttall = p.USE_NUTTALL_WINDOWING;
+
+        window.resize(fftSize);
+        for (int i = 0; i < fftSize; i++)
+        {
+            if (hann)
+            {
+                const float s = std::sin(pi * i / fftSize);
+                window[i] = s * s;
+            }
+            else if (nuttall)
+                window[i] = 0.355768f
+                    - 0.487396f * std::sin(1 * pi * i / fftSize)
+                    + 0.144232f * std::sin(2 * pi * i / fftSize)
+                    - 0.012604f * std::sin(3 * pi * i / fftSize);
+            else
+                window[i] = 1.f;
+        }
+    }
+
+    if (channelStates.size() != channels)
+    {
+        channelStates.resize(channels);
+        for (Channel& channel : channelStates)
+        {
+            channel.buffer.assign(fftSize, 0.f);
+            channel.amplitudes.resize(spectrum.size());
+        }
+        ringPos = 0;
+        samplesLeft = fftSize / 2;
+    }
+}
+
+bool WhistleDetectorMono2019::analyze(unsigned channels, unsigned sampleRate, unsigned time, unsigned selectedChannel)
+{
+    prepare(channels);
+    const WhistleDetectorMono2019Params& p = analysisParams;
+    bool analyzed = false;
+
+    for (size_t i = 0; i + channels <= samples.size(); i += channels)
     {
-        OUTPUT_WARNING("Not enough memory for KissFFT?");
+        for (unsigned c = 0; c < channels; c++)
+            channelStates[c].buffer[ringPos] = samples[i + c];
+        ringPos = (ringPos + 1) % fftSize;
+
+        if (--samplesLeft > 0)
+            continue;
+        samplesLeft = fftSize / 2;
+        analyzed = true;
+
+        bool detected;
+        if (p.USE_ALL_CHANNELS)
+        {
+            unsigned votes = 0;
+            for (Channel& channel : channelStates)
+                if (analyze(channel, sampleRate))
+                    votes++;
+            detected = votes >= std::max(1u, p.MIN_VOTES);
+        }
+        else
+            detected = analyze(channelStates[selectedChannel], sampleRate);
+
+        analysisResult.detectionState = WhistleDortmund::DetectionState::notDetected;
+        if (detected)
+        {
+            if (static_cast<int>(time - lastAttackTime) < p.ATTACK_TIMEOUT_MS)
+            {
+                //add attack to prevent short noises to be detected as whistles
+                attackCount++;
+                if (attackCount >= static_cast<unsigned int>(p.ATTACK))
+                {
+                    analysisResult.detectionState = WhistleDortmund::DetectionState::isDetected;
+                    analysisResult.lastDetectionTime = time;
+                }
+            }
+            else
+            {
+                attackCount = 0;
+                for (Channel& channel : channelStates)
+                    channel.peakPos = -1;
+            }
+            lastAttackTime = time;
+        }
+        //add release to ensure the detection plot to be smooth
+        if (analysisResult.detectionState == WhistleDortmund::DetectionState::isDetected)
+            releaseCount = 0;
+        else if (releaseCount < static_cast<unsigned int>(p.RELEASE))
+        {
+            analysisResult.detectionState = WhistleDortmund::DetectionState::isDetected;
+            releaseCount += 1;
+        }
     }
+    return analyzed;
+}
+
+bool WhistleDetectorMono2019::analyze(Channel& channel, int sampleRate)
+{
+    const WhistleDetectorMono2019Params& p = analysisParams;
+
+    // the oldest sample is at ringPos
+    const int head = fftSize - static_cast<int>(ringPos);
+    for (int i = 0; i < head; i++)
+        windowed[i] = channel.buffer[ringPos + i] * window[i];
+    for (int i = head; i < fftSize; i++)
+        windowed[i] = channel.buffer[i - head] * window[i];
+
+    //do FFT analysis
+    kiss_fftr(fftConfig, windowed.data(), spectrum.data());
+    computeAmplitudes(channel.amplitudes);
+    const std::vector<float>& amplitudes = channel.amplitudes;
+    const int maxIndex = static_cast<int>(amplitudes.size()) - 1;
+
+    // calculate min_amp regarding environment noise level
+    channel.currMinAmp = calc_noise_based_min_amp(channel, sampleRate, p.NOISE_HISTORY_SIZE);
+    channel.peak1Pos = -1;
+    channel.peak2Pos = -1;
+
+    //do peak detection
+    int min_i = p.MIN_FREQ_WHISTLE * fftSize / sampleRate;
+    int max_i = std::min(maxIndex, p.MAX_FREQ_WHISTLE * fftSize / sampleRate);
+
+    int& peakPos = channel.peakPos;
+    peakPos = min_i;
+    //get maximum
+    for (int i = min_i; i <= max_i; i++)
+        if (amplitudes[i] > amplitudes[peakPos])
+            peakPos = i;
+    if (amplitudes[peakPos] < channel.currMinAmp)
+        return false;
+
+    min_i = static_cast<int>(peakPos * p.OVERTONE_MULT_MIN_1);
+    max_i = std::min(maxIndex, static_cast<int>(peakPos * p.OVERTONE_MULT_MAX_1));
+    if (min_i > maxIndex)
+        return false;
+
+    int& peak1Pos = channel.peak1Pos;
+    peak1Pos = min_i;
+    for (int i = min_i; i <= max_i; i++) //maximum for overtone 1
+        if (amplitudes[i] > amplitudes[peak1Pos])
+            peak1Pos = i;
+    if (amplitudes[peak1Pos] < amplitudes[peakPos] * p.OVERTONE_MIN_AMP_1) //overtone 1 is not "good enough"
+        return false;
+
+    min_i = static_cast<int>(peakPos * p.OVERTONE_MULT_MIN_2);
+    max_i = std::min(maxIndex, static_cast<int>(peakPos * p.OVERTONE_MULT_MAX_2));
+    if (min_i > maxIndex)
+        return false;
+
+    int& peak2Pos = channel.peak2Pos;
+    peak2Pos = min_i;
+    for (int i = min_i; i <= max_i; i++)
+        if (amplitudes[i] > amplitudes[peak2Pos])
+            peak2Pos = i;
+    return amplitudes[peak2Pos] >= amplitudes[peakPos] * p.OVERTONE_MIN_AMP_2;
 }
 
+void WhistleDetectorMono2019::computeAmplitudes(std::vector<float>& amplitudes) const
+{
+    ASSERT(amplitudes.size() == spectrum.size());
+    const float* s = &spectrum[0].r;
+    const int size = static_cast<int>(spectrum.size());
+    int i = 0;
+
+    // four bins at a time: deinterleave real and imaginary parts, then sqrt(r * r + i * i)
+    for (; i + 4 <= size; i += 4, s += 8)
+    {
+        const __m128 a = _mm_loadu_ps(s);
+        const __m128 b = _mm_loadu_ps(s + 4);
+        const __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(&amplitudes[i], _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im))));
+    }
+    for (; i < size; i++, s += 2)
+        amplitudes[i] = std::sqrt(s[0] * s[0] + s[1] * s[1]);
+}
 
 /**
  * @brief calc_noise_based_min_amp
- * @param amplitudes vector
+ * @param channel the channel whose amplitudes and noise history are used
  * @return a meaningful minimal amplutude regarding the environment's noise level
  */
-float WhistleDetectorMono2019::calc_noise_based_min_amp(std::vector<float> amplitudes, const int sampleRate, const size_t historySize)
+float WhistleDetectorMono2019::calc_noise_based_min_amp(Channel& channel, const int sampleRate, const size_t historySize)
 {
   ASSERT(historySize > 0);
 
   //do peak detection
-  int min_i = params.MIN_FREQ_BACKGROUND_NOISE * params.WINDOW_SIZE / sampleRate;
-  int max_i = params.MAX_FREQ_BACKGROUND_NOISE * params.WINDOW_SIZE / sampleRate;
+  int min_i = analysisParams.MIN_FREQ_BACKGROUND_NOISE * fftSize / sampleRate;
+  int max_i = analysisParams.MAX_FREQ_BACKGROUND_NOISE * fftSize / sampleRate;
 
   float sum = 0;
 
   for (int i = min_i; i <= max_i; i++)
   {
-    sum += amplitudes[i];
+    sum += channel.amplitudes[i];
   }
   float mean = sum/(max_i - min_i);
 
+  std::vector<float>& history = channel.history;
   if (history.size() != historySize) {
     history = std::vector<float>(historySize, 5.f*mean);
   }
 
-  if (historyPos >= history.size())
-    historyPos = 0;
-  history[historyPos] = mean;
-  historyPos++;
+  if (channel.historyPos >= history.size())
+    channel.historyPos = 0;
+  history[channel.historyPos] = mean;
+  channel.historyPos++;
 
   float histSum = 0.f;
   for (size_t i = 0; i < historySize; i++)
     histSum += history[i];
   float histMean = histSum / history.size();
 
-  return histMean*params.MIN_AMP;
+  return histMean*analysisParams.MIN_AMP;
 }
 
 MAKE_MODULE(WhistleDetectorMono2019, modeling)
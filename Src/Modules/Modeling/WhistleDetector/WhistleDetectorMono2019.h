@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Tools/Math/kiss_fft130/kiss_fft.h"
+#include "Tools/Math/kiss_fft130/kiss_fftr.h"
 
 #include "Tools/Module/Module.h"
 #include "Representations/Modeling/WhistleDortmund.h"
@@ -10,13 +10,17 @@
 #include "Representations/Infrastructure/AudioData.h"
 #include "Tools/Debugging/DebugDrawings.h"
 #include "Tools/Debugging/DebugImages.h"
+#include "Platform/Semaphore.h"
 #include "Platform/SystemCall.h"
+#include "Platform/Thread.h"
 #include <string>
 #include "Tools/Math/Constants.h"
 
 STREAMABLE(WhistleDetectorMono2019Params,
 {,
 	(unsigned) USE_CHANNEL,
+	(bool) USE_ALL_CHANNELS, // analyze all channels and let them vote
+	(unsigned) MIN_VOTES, // number of channels that must detect a whistle if all channels are analyzed
 	(int) WINDOW_SIZE,
 	(int) MIN_FREQ_BACKGROUND_NOISE,
 	(int) MAX_FREQ_BACKGROUND_NOISE,
@@ -50,6 +54,12 @@ MODULE(WhistleDetectorMono2019,
   }),
 });
 
+/**
+ * The whistle detector analyzes the audio data in a thread of its own, so the
+ * Cognition frame only hands over the samples and picks up the latest result.
+ * Each hop, the samples of a window are multiplied with a cached window table
+ * and transformed with a real-input FFT.
+ */
 class WhistleDetectorMono2019 : public WhistleDetectorMono2019Base
 {
 
@@ -59,24 +69,96 @@ class WhistleDetectorMono2019 : public WhistleDetectorMono2019Base
 
     const int AMP_SIZE = (1 + ((params.WINDOW_SIZE - 1) / 2) + 1);
 
-  int peakPos = -1;
-  unsigned int ringPos, samplesLeft;
-  unsigned int releaseCount, attackCount;
-  float currMinAmp;
-  std::vector<float> buffer;
-  std::vector<kiss_fft_cpx> in, out;
-  std::vector<float> amplitudes;
+  /** The analysis state of a single channel. Only used by the analysis thread. */
+  struct Channel
+  {
+    std::vector<float> buffer; /**< Ring buffer of the samples of the last window. */
+    std::vector<float> amplitudes; /**< The amplitudes of the last window. */
+    std::vector<float> history; /**< The background noise of the last windows. */
+    size_t historyPos = 0;
+    float currMinAmp = 0.f;
+    int peakPos = -1, peak1Pos = -1, peak2Pos = -1;
+  };
+
   unsigned int currChannel, channelRequest;
-  
+  std::vector<float> amplitudes; /**< The amplitudes of the channel drawn, copied from the analysis thread. */
+  float currMinAmp = 0.f;
+  int peakPos = -1, peak1Pos = -1, peak2Pos = -1;
+
+  // Shared between the Cognition thread and the analysis thread. Protected by SYNC.
+  std::vector<float> pendingSamples; /**< Interleaved samples not processed yet. */
+  unsigned pendingChannels = 0; /**< The number of channels of the pending samples. */
+  unsigned pendingSampleRate = 0; /**< The sample rate of the pending samples. */
+  unsigned pendingTime = 0; /**< The frame time of the pending samples. */
+  WhistleDetectorMono2019Params pendingParams; /**< The parameters to use for the pending samples. */
+  unsigned pendingChannel = 0; /**< The channel analyzed if not all channels are used. */
+  bool reset = false; /**< The audio data was invalid. Reset the detection. */
+  WhistleDortmund detection; /**< The latest detection result. */
+  std::vector<float> debugAmplitudes; /**< The amplitudes of the last window of the channel drawn. */
+  float debugMinAmp = 0.f;
+  int debugPeakPos = -1, debugPeak1Pos = -1, debugPeak2Pos = -1; /**< The peaks of the last window of the channel drawn. */
+  DECLARE_SYNC;
+
+  // Only used by the analysis thread.
+  WhistleDetectorMono2019Params analysisParams;
+  std::vector<float> samples; /**< The samples currently analyzed. */
+  std::vector<Channel> channelStates;
+  std::vector<float> window; /**< The cached window function. */
+  std::vector<float> windowed; /**< The windowed samples of a channel. */
+  std::vector<kiss_fft_cpx> spectrum;
+  kiss_fftr_cfg fftConfig = nullptr; /**< The cached plan for the real-input FFT. */
+  int fftSize = 0; /**< The window size the cached plan and window were created for. */
+  bool hann = false, nuttall = false; /**< The window functions the cached window was created for. */
+  unsigned int ringPos = 0, samplesLeft = 0;
+  unsigned int releaseCount, attackCount;
   unsigned lastAttackTime = 0;
+  WhistleDortmund analysisResult;
 
-  std::vector<float> history = std::vector<float>(0);
-  size_t historyPos = 0;
+  Thread<WhistleDetectorMono2019> analysisThread;
+  Semaphore samplesAvailable; /**< Wakes up the analysis thread. */
 
 public:
   WhistleDetectorMono2019();
+  ~WhistleDetectorMono2019();
   void update(WhistleDortmund &whistle);
-  void kissFFT(kiss_fft_cpx in[], kiss_fft_cpx out[]);
+
 private:
-  float calc_noise_based_min_amp(std::vector<float> amplitudes, const int sampleRate, const size_t historySize);
+  /** The main function of the analysis thread. */
+  void run();
+
+  /** Analyzes the samples handed over by update() and publishes the results. */
+  void analyzePending();
+
+  /**
+   * Analyzes a batch of interleaved samples.
+   * @param channels The number of channels.
+   * @param sampleRate The sample rate.
+   * @param time The frame time the samples were handed over at.
+   * @param selectedChannel The channel analyzed if not all channels are used.
+   * @return Was at least one window analyzed?
+   */
+  bool analyze(unsigned channels, unsigned sampleRate, unsigned time, unsigned selectedChannel);
+
+  /**
+   * Updates the FFT plan, the window table and the ring buffers if the
+   * parameters changed.
+   * @param channels The number of channels.
+   */
+  void prepare(unsigned channels);
+
+  /**
+   * Analyzes the last window of a single channel.
+   * @param channel The channel.
+   * @param sampleRate The sample rate.
+   * @return Does the channel contain a whistle with its overtones?
+   */
+  bool analyze(Channel& channel, int sampleRate);
+
+  /**
+   * Computes the amplitudes of the spectrum using SSE.
+   * @param amplitudes The amplitudes. The vector must have the size of the spectrum.
+   */
+  void computeAmplitudes(std::vector<float>& amplitudes) const;
+
+  float calc_noise_based_min_amp(Channel& channel, const int sampleRate, const size_t historySize);
 };
@@ -137,10 +137,11 @@ void SelfLocator2017::predictHypotheses()
 void SelfLocator2017::updateHypothesesPositionConfidence()
 {
   bool updateSpherical, updateInfiniteLines, updateWeighted;
+  const LineMatchingResult& lineMatchingResult = getLineMatchingResult();
   for (auto& hypothesis : poseHypotheses)
   {
-    updateSpherical = hypothesis->updatePositionConfidenceWithLocalFeaturePerceptionsSpherical(theLineMatchingResult, theCLIPCenterCirclePercept, theCLIPGoalPercept, thePenaltyCrossPercept, theFieldDimensions, theCameraMatrix, theCameraMatrixUpper, parameters);
-    updateInfiniteLines = hypothesis->updatePositionConfidenceWithLocalFeaturePerceptionsInfiniteLines(theLineMatchingResult, theCLIPCenterCirclePercept, theFieldDimensions, parameters);
+    updateSpherical = hypothesis->updatePositionConfidenceWithLocalFeaturePerceptionsSpherical(lineMatchingResult, theCLIPCenterCirclePercept, theCLIPGoalPercept, thePenaltyCrossPercept, theFieldDimensions, theCameraMatrix, theCameraMatrixUpper, parameters);
+    updateInfiniteLines = hypothesis->updatePositionConfidenceWithLocalFeaturePerceptionsInfiniteLines(lineMatchingResult, theCLIPCenterCirclePercept, theFieldDimensions, parameters);
     updateWeighted = hypothesis->updatePositionConfidenceWithLocalFeaturePerceptionsWeighted(theCLIPFieldLinesPercept, theCLIPCenterCirclePercept, theCLIPGoalPercept, thePenaltyCrossPercept, theFieldDimensions, parameters);
 
     if (!(updateSpherical || updateInfiniteLines || updateWeighted))
@@ -262,8 +263,9 @@ void SelfLocator2017::executeCommonCode()
   predictHypotheses();
 
   // Fill matrices for update
+  const LineMatchingResult& lineMatchingResult = getLineMatchingResult();
   for (auto& hyp : poseHypotheses)
-    hyp->fillCorrectionMatrices(theLineMatchingResult, theCLIPCenterCirclePercept, theCLIPGoalPercept, thePenaltyCrossPercept, theFieldDimensions,
+    hyp->fillCorrectionMatrices(lineMatchingResult, theCLIPCenterCirclePercept, theCLIPGoalPercept, thePenaltyCrossPercept, theFieldDimensions,
       theCameraMatrix, theCameraMatrixUpper, parameters);
 
   // Update state of hypotheses
@@ -296,7 +298,7 @@ void SelfLocator2017::executeCommonCode()
     {
       Vector2f lastPosition = pose.translation;
       if (theFieldDimensions.clipToCarpet(lastPosition) < 100)
-        poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+        poseHypotheses.push_back(createHypothesis(
           pose,
           std::max(pc * .8f, parameters.spawning.positionConfidenceWhenPositionedManually + 0.1f),
           sc,
@@ -317,6 +319,11 @@ void SelfLocator2017::executeCommonCode()
 
 }
 
+const LineMatchingResult& SelfLocator2017::getLineMatchingResult() const
+{
+  return theLineMatchingResult.timestamp == theFrameInfo.time ? theLineMatchingResult : noLineMatchingResult;
+}
+
 void SelfLocator2017::checkBeingPickedUp()
 {
   // Fill buffer
@@ -375,6 +382,119 @@ void SelfLocator2017::normalizeWeights()
 }
 
 
+SelfLocator2017::PoseHypotheses::value_type SelfLocator2017::createHypothesis(const Pose2f & newPose, float positionConfidence, float symmetryConfidence, const unsigned &timeStamp, const SelfLocator2017Parameters& parameters)
+{
+  if (unusedPoseHypotheses.empty())
+    return std::make_unique<PoseHypothesis2017>(newPose, positionConfidence, symmetryConfidence, timeStamp, parameters);
+
+  PoseHypotheses::value_type hypothesis = std::move(unusedPoseHypotheses.back());
+  unusedPoseHypotheses.pop_back();
+  hypothesis->reset(newPose, positionConfidence, symmetryConfidence, timeStamp, parameters);
+  return hypothesis;
+}
+
+SelfLocator2017::PoseHypotheses::value_type SelfLocator2017::createHypothesis(const PoseHypothesis2017& other, const unsigned &timeStamp)
+{
+  if (unusedPoseHypotheses.empty())
+    return std::make_unique<PoseHypothesis2017>(other, timeStamp);
+
+  PoseHypotheses::value_type hypothesis = std::move(unusedPoseHypotheses.back());
+  unusedPoseHypotheses.pop_back();
+  hypothesis->reset(other, timeStamp);
+  return hypothesis;
+}
+
+SelfLocator2017::PoseHypotheses::iterator SelfLocator2017::removeHypothesis(PoseHypotheses::iterator it)
+{
+  // The hypothesis must not be referenced by its mirrored one while it is unused
+  (*it)->unlinkMirrored();
+  unusedPoseHypotheses.push_back(std::move(*it));
+  return poseHypotheses.erase(it);
+}
+
+void SelfLocator2017::removeAllHypotheses()
+{
+  for (auto& hypothesis : poseHypotheses)
+  {
+    hypothesis->unlinkMirrored();
+    unusedPoseHypotheses.push_back(std::move(hypothesis));
+  }
+  poseHypotheses.clear();
+}
+
+void SelfLocator2017::HypothesisGrid::build(const std::vector<float>& x, const std::vector<float>& y, float cellSize)
+{
+  // Only finite cell sizes allow to compute cells, otherwise everything is in one cell
+  this->cellSize = cellSize > 0.f && std::isfinite(cellSize) ? cellSize : std::numeric_limits<float>::infinity();
+  entries.resize(x.size());
+  for (size_t i = 0; i < x.size(); i++)
+  {
+    entries[i].cellX = getCell(x[i]);
+    entries[i].cellY = getCell(y[i]);
+    entries[i].index = i;
+  }
+  std::sort(entries.begin(), entries.end());
+}
+
+void SelfLocator2017::HypothesisGrid::getCandidates(float x, float y, size_t minIndex, std::vector<size_t>& candidates) const
+{
+  candidates.clear();
+  const int cellX = getCell(x);
+  const int cellY = getCell(y);
+  for (int dx = -1; dx <= 1; dx++)
+  {
+    for (int dy = -1; dy <= 1; dy++)
+    {
+      const Entry first = { cellX + dx, cellY + dy, minIndex + 1 };
+      for (auto it = std::lower_bound(entries.begin(), entries.end(), first);
+        it != entries.end() && it->cellX == first.cellX && it->cellY == first.cellY; it++)
+      {
+        candidates.push_back(it->index);
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+}
+
+int SelfLocator2017::HypothesisGrid::getCell(float value) const
+{
+  // Clipped so that the neighbours of every cell can be addressed without overflow
+  const float cell = std::floor(value / cellSize);
+  return static_cast<int>(std::max(-1000000.f, std::min(1000000.f, cell == cell ? cell : 0.f)));
+}
+
+void SelfLocator2017::HypothesisArrays::fill(const PoseHypotheses& poseHypotheses)
+{
+  const size_t size = poseHypotheses.size();
+  x.resize(size);
+  y.resize(size);
+  rotation.resize(size);
+  symmetryConfidence.resize(size);
+  mean.resize(size);
+  inverseCovariance.resize(size);
+  maxCovarianceTrace = 0.0;
+
+  GaussianDistribution3D gd;
+  Pose2f pose;
+  for (size_t i = 0; i < size; i++)
+  {
+    poseHypotheses[i]->getRobotPose(pose);
+    x[i] = pose.translation.x();
+    y[i] = pose.translation.y();
+    rotation[i] = pose.rotation;
+    symmetryConfidence[i] = poseHypotheses[i]->getSymmetryConfidence();
+    poseHypotheses[i]->extractGaussianDistribution3DFromStateEstimation(gd);
+    mean[i] = gd.mean;
+    inverseCovariance[i] = gd.covariance.inverse();
+
+    // The trace only bounds the largest eigenvalue of positive definite covariances
+    if (gd.covariance.llt().info() == Eigen::Success && std::isfinite(gd.covariance.trace()))
+      maxCovarianceTrace = std::max(maxCovarianceTrace, gd.covariance.trace());
+    else
+      maxCovarianceTrace = std::numeric_limits<double>::infinity();
+  }
+}
+
 void SelfLocator2017::pruneHypothesesInOwnHalf()
 {
   PoseHypotheses::iterator it = poseHypotheses.begin();
@@ -384,7 +504,7 @@ void SelfLocator2017::pruneHypothesesInOwnHalf()
     (*it)->getRobotPose(strikerPose);
     if (strikerPose.translation.x() < 0) // striker will never reach the own half because of manually placement.
     {
-      it = poseHypotheses.erase(it);
+      it = removeHypothesis(it);
     }
     else
     {
@@ -403,7 +523,7 @@ void SelfLocator2017::pruneHypothesesInOpponentHalf()
     (*it)->getRobotPose(keeperPose);
     if (keeperPose.translation.x() > 0)
     {
-      it = poseHypotheses.erase(it);
+      it = removeHypothesis(it);
     }
     else
     {
@@ -426,7 +546,7 @@ void SelfLocator2017::pruneHypothesesOutsideField()
     else
     {
       //delete and auto advance
-      it = poseHypotheses.erase(it);
+      it = removeHypothesis(it);
     }
   }
 }
@@ -450,7 +570,7 @@ void SelfLocator2017::pruneHypothesesOutsideCarpet()
       DEBUG_LOG(TAG, "Detected hypothesis position that is outside of carpet -> deleting hypothesis");
 
       //delete and auto advance
-      it = poseHypotheses.erase(it);
+      it = removeHypothesis(it);
     }
   }
 }
@@ -468,7 +588,7 @@ void SelfLocator2017::pruneHypothesesWithInvalidValues()
       DEBUG_LOG(TAG, "Detected impossible state (NaN) -> deleting hypothesis");
 
       //delete and auto advance
-      it = poseHypotheses.erase(it);
+      it = removeHypothesis(it);
     }
     else
     {
@@ -506,23 +626,29 @@ void SelfLocator2017::pruneHypotheses()
     pruneHypothesesOutsideField();
 
 
-  // Delete positions that seem to be symmetric
+  // The poses and covariances do not change during the pairwise comparisons below,
+  // so they are copied once and candidate pairs are only searched in neighbouring
+  // cells of a grid instead of comparing all pairs.
+  hypothesisArrays.fill(poseHypotheses);
+  const HypothesisArrays& h = hypothesisArrays;
+
+  // Delete positions that seem to be symmetric.
+  // A mirrored pose can only be close if its distance is less than maxDistanceForLocalResetting.
+  hypothesisGrid.build(h.x, h.y, parameters.sensorReset.maxDistanceForLocalResetting * 1.01f);
   for (PoseHypotheses::size_type i = 0; i < poseHypotheses.size(); i++)
   {
-    Pose2f mirrorOfHypothesis;
-    poseHypotheses[i]->getRobotPose(mirrorOfHypothesis);
-    mirrorOfHypothesis = getSymmetricPoseOnField(mirrorOfHypothesis);
-    for (PoseHypotheses::size_type j = i + 1; j < poseHypotheses.size(); j++)
+    const Pose2f mirrorOfHypothesis = getSymmetricPoseOnField(Pose2f(h.rotation[i], h.x[i], h.y[i]));
+    hypothesisGrid.getCandidates(mirrorOfHypothesis.translation.x(), mirrorOfHypothesis.translation.y(), i, pruningCandidates);
+    for (PoseHypotheses::size_type j : pruningCandidates)
     {
-      Pose2f hypoPose;
-      poseHypotheses[j]->getRobotPose(hypoPose);
+      const Pose2f hypoPose(h.rotation[j], h.x[j], h.y[j]);
       // Identify mirror hypothesis
       if (arePosesCloseToEachOther(mirrorOfHypothesis, hypoPose, parameters))
       {
         switch (parameters.localizationStateUpdate.symmetryHandling)
         {
         case SelfLocator2017Parameters::LocalizationStateUpdate::noSymmetricPoses:
-          if (poseHypotheses[i]->getSymmetryConfidence() < poseHypotheses[j]->getSymmetryConfidence())
+          if (h.symmetryConfidence[i] < h.symmetryConfidence[j])
           {
             poseHypotheses[i]->scalePositionConfidence(0);
           }
@@ -537,7 +663,7 @@ void SelfLocator2017::pruneHypotheses()
           if (hasSymmetryBeenFoundAgainAfterLoss(*poseHypotheses[i])
             || hasSymmetryBeenFoundAgainAfterLoss(*poseHypotheses[j]))
           {
-            if (poseHypotheses[i]->getSymmetryConfidence() < poseHypotheses[j]->getSymmetryConfidence())
+            if (h.symmetryConfidence[i] < h.symmetryConfidence[j])
             {
               poseHypotheses[i]->scalePositionConfidence(0);
             }
@@ -557,15 +683,22 @@ void SelfLocator2017::pruneHypotheses()
   }
 
 
-  // "merge" very close hypotheses, i.e. simply delete the less confident one
-  GaussianDistribution3D gd1, gd2;
+  // "merge" very close hypotheses, i.e. simply delete the less confident one.
+  // Both factors of the likelihood must exceed the threshold, i.e. exp(-0.5 * d^T * C^-1 * d) > t,
+  // which requires |d|^2 < -2 * ln(t) * maxEigenvalue(C) <= -2 * ln(t) * trace(C).
+  // The pairs are still processed in the original order, because merging changes the confidences.
+  const double threshold = parameters.pruning.likelihoodTresholdForMerging;
+  const double mergeDistance = threshold > 0.0 && threshold < 1.0 ? std::sqrt(-2.0 * std::log(threshold) * h.maxCovarianceTrace) : std::numeric_limits<double>::infinity();
+  hypothesisGrid.build(h.x, h.y, static_cast<float>(mergeDistance * 1.01 + 1.0));
   for (PoseHypotheses::size_type k = 0; k < poseHypotheses.size(); k++)
   {
-    poseHypotheses[k]->extractGaussianDistribution3DFromStateEstimation(gd1);
-    for (PoseHypotheses::size_type j = k + 1; j < poseHypotheses.size(); j++)
+    hypothesisGrid.getCandidates(h.x[k], h.y[k], k, pruningCandidates);
+    for (PoseHypotheses::size_type j : pruningCandidates)
     {
-      poseHypotheses[j]->extractGaussianDistribution3DFromStateEstimation(gd2);
-      double likelihood = gd1.normalizedProbabilityAt(gd2.mean) * gd2.normalizedProbabilityAt(gd1.mean);
+      const Vector3d diff = h.mean[j] - h.mean[k];
+      const double exponent1 = diff.dot(h.inverseCovariance[k] * diff);
+      const double exponent2 = diff.dot(h.inverseCovariance[j] * diff);
+      const double likelihood = (exponent1 < 0 ? 0.0 : std::exp(-0.5 * exponent1)) * (exponent2 < 0 ? 0.0 : std::exp(-0.5 * exponent2));
       if (likelihood > parameters.pruning.likelihoodTresholdForMerging)
       {
         if (poseHypotheses[k]->getPositionConfidence() > poseHypotheses[j]->getPositionConfidence())
@@ -594,7 +727,7 @@ void SelfLocator2017::pruneHypotheses()
   {
     if ((*it)->getPositionConfidence() < pruningThreshold) // no need to make this small threshold a magic number
     {
-      it = poseHypotheses.erase(it);
+      it = removeHypothesis(it);
     }
     else
     {
@@ -614,7 +747,7 @@ void SelfLocator2017::pruneHypotheses()
         worst = it;
       }
     }
-    poseHypotheses.erase(worst);
+    removeHypothesis(worst);
   }
 }
 
@@ -784,8 +917,8 @@ void SelfLocator2017::handleGettingUpAfterFallDown()
 
     for (unsigned char j = 1; j <= parameters.spawning.noAdditionalHypothesisAfterFallDown / 2; ++j)
     {
-      poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(hypothesis, theFrameInfo.time)); // copy hypotheses
-      poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(hypothesis, theFrameInfo.time)); // copy hypotheses
+      poseHypotheses.push_back(createHypothesis(hypothesis, theFrameInfo.time)); // copy hypotheses
+      poseHypotheses.push_back(createHypothesis(hypothesis, theFrameInfo.time)); // copy hypotheses
       PoseHypotheses::value_type& p1 = *(poseHypotheses.end() - 2); // Get new hypothesis
       PoseHypotheses::value_type & p2 = *(poseHypotheses.end() - 1); // Get new hypothesis
 
@@ -825,7 +958,7 @@ void SelfLocator2017::handleUnPenalized()
   {
     // penalized for more than 15 seconds, so it was most likely no mistake
     // and we can delete all other hypotheses
-    poseHypotheses.clear();
+    removeAllHypotheses();
   }
   else
   {
@@ -861,7 +994,7 @@ void SelfLocator2017::handleSetState()
       bool poseIsInOpponentHalf = pose.translation.x() > 200; // no need to make this small threshold a magic number
       if (poseIsInOpponentHalf)
       {
-        i = poseHypotheses.erase(i);
+        i = removeHypothesis(i);
       }
       else
       {
@@ -891,7 +1024,7 @@ void SelfLocator2017::addHypothesesOnManualPositioningPositions()
     // penalty shootout
     if (Global::getSettings().gameMode == Settings::penaltyShootout)
     {
-      poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+      poseHypotheses.push_back(createHypothesis(
         Pose2f(0, positionsByRules.penaltyShootoutGoaliePosition),
         parameters.spawning.positionConfidenceWhenPositionedManuallyForGoalKeeper,
         sc,
@@ -900,7 +1033,7 @@ void SelfLocator2017::addHypothesesOnManualPositioningPositions()
     }
     else
     {
-      poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+      poseHypotheses.push_back(createHypothesis(
         Pose2f(0, positionsByRules.goaliePosition),
         parameters.spawning.positionConfidenceWhenPositionedManuallyForGoalKeeper,
         sc,
@@ -920,7 +1053,7 @@ void SelfLocator2017::addHypothesesOnManualPositioningPositions()
     {
       for (auto& position : (ownKickoff ? positionsByRules.fieldPlayerPositionsOwnKickoff : positionsByRules.fieldPlayerPositionsOppKickoff))
       {
-        poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+        poseHypotheses.push_back(createHypothesis(
           Pose2f(0, position),
           parameters.spawning.positionConfidenceWhenPositionedManually,
           sc,
@@ -957,7 +1090,7 @@ void SelfLocator2017::addPenaltyStrikerStartingHypothesis()
 
   for (int angle : positionsByRules.penaltyShootAngles) {
     Vector2f rot = Vector2f(backTransl).rotate(Angle::fromDegrees(angle));
-    poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+    poseHypotheses.push_back(createHypothesis(
       Pose2f(rot.angle(), penaltyMarkPos - rot),
       parameters.spawning.positionConfidenceWhenPositionedManually,
       sc,
@@ -974,13 +1107,13 @@ void SelfLocator2017::addHypothesesOnPenaltyPositions(float newPositionConfidenc
 
     for (const auto& offset : positionsByRules.xOffsetPenaltyPositions)
     {
-      poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+      poseHypotheses.push_back(createHypothesis(
         Pose2f(pi_2, offset, theFieldDimensions.yPosRightSideline),
         newPositionConfidence,
         sc,
         theFrameInfo.time,
         parameters));
-      poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+      poseHypotheses.push_back(createHypothesis(
         Pose2f(-pi_2, offset, theFieldDimensions.yPosLeftSideline),
         newPositionConfidence,
         sc,
@@ -1000,10 +1133,11 @@ bool SelfLocator2017::addNewHypothesesFromLineMatches()
     bestHypo->getRobotPose(hypoPose);
 
   std::vector<HypothesisBase> additionalHypotheses;
-  size_t size = theLineMatchingResult.poseHypothesis.size();
+  const LineMatchingResult& lineMatchingResult = getLineMatchingResult();
+  size_t size = lineMatchingResult.poseHypothesis.size();
   if (size > 0)
   {
-    for (auto& ph : theLineMatchingResult.poseHypothesis)
+    for (auto& ph : lineMatchingResult.poseHypothesis)
     {
       // Only add hypotheses on own side
       // AddPoseToHypothesisVector will handle symmetry
@@ -1016,7 +1150,7 @@ bool SelfLocator2017::addNewHypothesesFromLineMatches()
   // Add hypotheses to the system
   for (auto& hyp : additionalHypotheses)
   {
-    poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+    poseHypotheses.push_back(createHypothesis(
       hyp.pose,
       hyp.positionConfidence,
       hyp.symmetryConfidence,
@@ -1046,7 +1180,7 @@ bool SelfLocator2017::addNewHypothesesFromPenaltyCrossLine()
   // Add hypotheses to the system
   for (auto& hyp : additionalHypotheses)
   {
-    poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+    poseHypotheses.push_back(createHypothesis(
       hyp.pose,
       hyp.positionConfidence,
       hyp.symmetryConfidence,
@@ -1076,7 +1210,7 @@ bool SelfLocator2017::addNewHypothesesFromCenterCirleAndLine()
   // Add hypotheses to the system
   for (auto& hyp : additionalHypotheses)
   {
-    poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+    poseHypotheses.push_back(createHypothesis(
       hyp.pose,
       hyp.positionConfidence,
       hyp.symmetryConfidence,
@@ -1112,7 +1246,7 @@ bool SelfLocator2017::addNewHypothesesFromGoal()
   // Add hypotheses to the system
   for (auto& hyp : additionalHypotheses)
   {
-    poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+    poseHypotheses.push_back(createHypothesis(
       hyp.pose,
       hyp.positionConfidence,
       hyp.symmetryConfidence,
@@ -1145,7 +1279,7 @@ bool SelfLocator2017::addNewHypothesesIfSymmetryLost()
         hypothesis.getRobotPose(symmetricPose);
         symmetricPose = getSymmetricPoseOnField(symmetricPose);
 
-        poseHypotheses.push_back(std::make_unique<PoseHypothesis2017>(
+        poseHypotheses.push_back(createHypothesis(
           symmetricPose,
           hypothesis.getPositionConfidence(),
           (hypothesis.getSymmetryConfidence() + parameters.localizationStateUpdate.symmetryFoundAgainWhenBestConfidenceAboveThisThreshold) / 2,
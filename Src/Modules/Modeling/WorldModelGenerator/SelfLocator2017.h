@@ -104,6 +104,68 @@ class SelfLocator2017 : public SelfLocator2017Base
       : pose(_pose), positionConfidence(_positionConfidence), symmetryConfidence(_symmetryConfidence) { }
   };
 
+  /**
+  * A uniform grid over field positions, so that the pairwise comparisons in
+  * pruneHypotheses() only have to look at hypotheses in neighbouring cells.
+  */
+  class HypothesisGrid
+  {
+  public:
+    /**
+    * Sorts positions into the cells of the grid.
+    * @param x The x coordinates of the positions.
+    * @param y The y coordinates of the positions.
+    * @param cellSize The edge length of a cell. All positions that are closer
+    *                 than this to a query position are returned by getCandidates().
+    */
+    void build(const std::vector<float>& x, const std::vector<float>& y, float cellSize);
+
+    /**
+    * Collects the indices of all positions in the cell of a query position and its
+    * eight neighbours.
+    * @param x The x coordinate of the query position.
+    * @param y The y coordinate of the query position.
+    * @param minIndex Only indices larger than this one are returned.
+    * @param candidates Is filled with the indices in ascending order.
+    */
+    void getCandidates(float x, float y, size_t minIndex, std::vector<size_t>& candidates) const;
+
+  private:
+    struct Entry
+    {
+      int cellX;
+      int cellY;
+      size_t index;
+
+      bool operator<(const Entry& other) const
+      {
+        return cellX < other.cellX || (cellX == other.cellX && (cellY < other.cellY || (cellY == other.cellY && index < other.index)));
+      }
+    };
+
+    float cellSize = 1.f;
+    std::vector<Entry> entries; /**< All positions, sorted by their cells. */
+
+    int getCell(float value) const;
+  };
+
+  /**
+  * Contiguous copies of the values of all hypotheses that are compared pairwise
+  * in pruneHypotheses(). They are rebuilt on each call, but keep their storage.
+  */
+  struct HypothesisArrays
+  {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> rotation;
+    std::vector<float> symmetryConfidence;
+    std::vector<Vector3d, Eigen::aligned_allocator<Vector3d>> mean;
+    std::vector<Matrix3d, Eigen::aligned_allocator<Matrix3d>> inverseCovariance;
+    double maxCovarianceTrace; /**< The largest trace of the positive definite covariances, or infinity if one is not. */
+
+    void fill(const PoseHypotheses& poseHypotheses);
+  };
+
   ENUM(LocalizationState,
   { ,
     positionTracking,
@@ -141,6 +203,10 @@ private:
   unsigned lastExecuteTimeStamp;
   
   PoseHypotheses poseHypotheses;
+  PoseHypotheses unusedPoseHypotheses; /**< Removed hypotheses that are reused instead of allocating new ones. */
+  HypothesisArrays hypothesisArrays;
+  HypothesisGrid hypothesisGrid;
+  std::vector<size_t> pruningCandidates;
 
   Pose2f                    lastOdometryData;
   bool                      foundGoodPosition;
@@ -172,11 +238,19 @@ private:
   SideConfidence m_sideConfidence;
   RobotPoseHypothesis m_robotPoseHypothesis;
   RobotPoseHypotheses m_robotPoseHypotheses;
+  LineMatchingResult noLineMatchingResult; /**< Used instead of a line matching result that was not computed in this frame. */
 
   /* ----------------------------------- private methods here ------------------------------------*/
 
   void executeCommonCode();
 
+  /**
+  * Returns the line matching result if it was computed in this frame. Its poses
+  * and lines are relative to the robot, so an older result would be applied to a
+  * pose that odometry has already moved. In that case, an empty result is returned.
+  */
+  const LineMatchingResult& getLineMatchingResult() const;
+
   void checkBeingPickedUp();
 
   void handleFallDown();
@@ -185,6 +259,23 @@ private:
   void handleSetState();
   void handleInitialState();
 
+  /**
+  * Creates a hypothesis. A previously removed one is reused if available.
+  * The parameters are the same as the ones of the constructors of PoseHypothesis2017.
+  */
+  PoseHypotheses::value_type createHypothesis(const Pose2f & newPose, float positionConfidence, float symmetryConfidence, const unsigned &timeStamp, const SelfLocator2017Parameters& parameters);
+  PoseHypotheses::value_type createHypothesis(const PoseHypothesis2017& other, const unsigned &timeStamp);
+
+  /**
+  * Removes a hypothesis from poseHypotheses and keeps it for reuse.
+  * @param it The hypothesis to remove.
+  * @return The iterator following the removed hypothesis.
+  */
+  PoseHypotheses::iterator removeHypothesis(PoseHypotheses::iterator it);
+
+  /** Removes all hypotheses and keeps them for reuse. */
+  void removeAllHypotheses();
+
   void normalizeWeights();
   void pruneHypotheses();
   void pruneHypothesesInOwnHalf();
@@ -49,18 +49,9 @@ namespace
 }
 
 PoseHypothesis2017::PoseHypothesis2017(const Pose2f & newPose, float _positionConfidence, float _symmetryConfidence, const unsigned &timeStamp, const SelfLocator2017Parameters& parameters) :
-  positionConfidence(_positionConfidence),
-  normalizedPositionConfidence(_positionConfidence),
-  symmetryConfidence(_symmetryConfidence),
-  mirrored(nullptr),
-  initialized(false),
-  sensorUpdated(false)
+  mirrored(nullptr)
 {
-  covariance = Eigen::Matrix<double, totalDimension, totalDimension>::Identity();
-  covariance *= 100000.0;
-  _uniqueId = getNextUniqueId();
-  creationTime = timeStamp;
-  init(newPose, parameters);
+  reset(newPose, _positionConfidence, _symmetryConfidence, timeStamp, parameters);
 }
 PoseHypothesis2017::PoseHypothesis2017(const PoseHypothesis2017& other, const unsigned &timeStamp)
   : _uniqueId(0)
@@ -75,6 +66,34 @@ PoseHypothesis2017::PoseHypothesis2017(const PoseHypothesis2017& other, const un
   *this = other;
 }
 
+void PoseHypothesis2017::reset(const Pose2f & newPose, float _positionConfidence, float _symmetryConfidence, const unsigned &timeStamp, const SelfLocator2017Parameters& parameters)
+{
+  unlinkMirrored();
+  positionConfidence = _positionConfidence;
+  normalizedPositionConfidence = _positionConfidence;
+  symmetryConfidence = _symmetryConfidence;
+  mirrored = nullptr;
+  initialized = false;
+  sensorUpdated = false;
+  observationAnglesWithLocalFeaturePerceptionsSpherical.clear();
+  observationsAsNormalsWithLocalFeaturePerceptionsInfiniteLines.clear();
+  covariance = Eigen::Matrix<double, totalDimension, totalDimension>::Identity();
+  covariance *= 100000.0;
+  _uniqueId = getNextUniqueId();
+  creationTime = timeStamp;
+  init(newPose, parameters);
+}
+
+void PoseHypothesis2017::reset(const PoseHypothesis2017& other, const unsigned &timeStamp)
+{
+  unlinkMirrored();
+  mirrored = nullptr;
+  initialized = false;
+  sensorUpdated = false;
+  creationTime = timeStamp;
+  *this = other;
+}
+
 PoseHypothesis2017& PoseHypothesis2017::operator=(const PoseHypothesis2017& other)
 {
   _uniqueId = getNextUniqueId();
@@ -98,10 +117,16 @@ PoseHypothesis2017& PoseHypothesis2017::operator=(const PoseHypothesis2017& othe
 }
 
 PoseHypothesis2017::~PoseHypothesis2017()
+{
+  unlinkMirrored();
+}
+
+void PoseHypothesis2017::unlinkMirrored()
 {
   // Remove reference of mirrored hypothesis to this one
   if (mirrored && (mirrored->mirroredHypothesis() == this))
     mirrored->mirroredHypothesis() = nullptr;
+  mirrored = nullptr;
 }
 
 void PoseHypothesis2017::cleanup()
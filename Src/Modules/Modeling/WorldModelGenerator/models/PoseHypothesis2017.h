@@ -84,6 +84,17 @@ public:
 
   ~PoseHypothesis2017();
 
+  /**
+  * Reinitializes a hypothesis that is not used anymore, so that it is in the same
+  * state as if it was created by the corresponding constructor. The storage of the
+  * observation vectors is kept, so reusing hypotheses does not allocate memory.
+  */
+  void reset(const Pose2f & newPose, float _positionConfidence, float _symmetryConfidence, const unsigned &timeStamp, const SelfLocator2017Parameters& parameters);
+  void reset(const PoseHypothesis2017& other, const unsigned &timeStamp);
+
+  /** Removes the links between this hypothesis and its mirrored one. */
+  void unlinkMirrored();
+
 private:
   // ok, since we only have limited sized matrices for the update, we restrict the measurement dimension...
   static const unsigned int maxMeasurementDimensionSpherical = 20;
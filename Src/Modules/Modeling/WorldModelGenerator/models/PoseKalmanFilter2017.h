@@ -56,6 +56,96 @@ using SphericalObservationVector = std::vector<SphericalObservation<dim>, Eigen:
 template<int dim>
 using InfiniteLineObservationVector = std::vector<InfiniteLineObservation<dim>, Eigen::aligned_allocator<InfiniteLineObservation<dim> > >;
 
+/**
+* Sums up measurements of the same kind, whose joint covariance R has the single measurement
+* covariance S in its diagonal blocks and c * S in all other blocks, i.e.
+* R = ((1 - c) * I + c * 1 * 1^T) (x) S. Its inverse has the same structure, so H^T * R^-1 * H
+* and H^T * R^-1 * z can be summed up per measurement. The Kalman update is then computed in
+* information form, i.e. P' = (P^-1 + H^T * R^-1 * H)^-1 and x' = x + P' * H^T * R^-1 * z,
+* which is equivalent to the usual form, but only needs fixed size matrices and a time that is
+* linear in the number of measurements instead of inverting the n x n innovation covariance.
+*/
+template<int stateDim, int measurementDim>
+class CorrelatedMeasurementAccumulator2017
+{
+public:
+  typedef Eigen::Matrix<double, stateDim, stateDim> StateMatrix;
+  typedef Eigen::Matrix<double, stateDim, 1> StateVector;
+  typedef Eigen::Matrix<double, measurementDim, measurementDim> MeasurementMatrix;
+  typedef Eigen::Matrix<double, measurementDim, 1> MeasurementVector;
+  typedef Eigen::Matrix<double, measurementDim, stateDim> JacobianMatrix;
+
+private:
+  StateMatrix informationMatrix; /**< Sum of H_i^T * S^-1 * H_i. */
+  StateVector informationVector; /**< Sum of H_i^T * S^-1 * z_i. */
+  JacobianMatrix sumOfJacobians;
+  MeasurementVector sumOfMeasurements;
+  int count;
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  CorrelatedMeasurementAccumulator2017() { clear(); }
+
+  void clear()
+  {
+    informationMatrix = StateMatrix::Zero();
+    informationVector = StateVector::Zero();
+    sumOfJacobians = JacobianMatrix::Zero();
+    sumOfMeasurements = MeasurementVector::Zero();
+    count = 0;
+  }
+
+  /**
+  * Adds a measurement.
+  * @param jacobian The jacobian of the measurement model.
+  * @param innovation The difference between the measurement and the expected measurement.
+  * @param singleMeasurementCovarianceInverse S^-1.
+  */
+  void add(const JacobianMatrix& jacobian, const MeasurementVector& innovation, const MeasurementMatrix& singleMeasurementCovarianceInverse)
+  {
+    const Eigen::Matrix<double, stateDim, measurementDim> weightedJacobianTransposed = jacobian.transpose() * singleMeasurementCovarianceInverse;
+    informationMatrix += weightedJacobianTransposed * jacobian;
+    informationVector += weightedJacobianTransposed * innovation;
+    sumOfJacobians += jacobian;
+    sumOfMeasurements += innovation;
+    ++count;
+  }
+
+  /**
+  * Updates a covariance with all measurements added.
+  * @param singleMeasurementCovarianceInverse S^-1.
+  * @param correlationFactor c. Must be in [0, 1[.
+  * @param covariance The covariance that is updated.
+  * @param movement The correction of the state.
+  * @return Was the update possible? If not, the covariance is not changed.
+  */
+  bool apply(const MeasurementMatrix& singleMeasurementCovarianceInverse, double correlationFactor,
+    StateMatrix& covariance, StateVector& movement) const
+  {
+    // ((1 - c) * I + c * 1 * 1^T)^-1 = (I - gamma * 1 * 1^T) / (1 - c)
+    const double gamma = correlationFactor / (1.0 - correlationFactor + count * correlationFactor);
+    const double scale = 1.0 / (1.0 - correlationFactor);
+    const Eigen::Matrix<double, stateDim, measurementDim> weightedSumTransposed = sumOfJacobians.transpose() * singleMeasurementCovarianceInverse;
+
+    bool invertible;
+    StateMatrix information;
+    covariance.computeInverseWithCheck(information, invertible);
+    if (!invertible)
+      return false;
+    information += (informationMatrix - gamma * weightedSumTransposed * sumOfJacobians) * scale;
+
+    StateMatrix newCovariance;
+    information.computeInverseWithCheck(newCovariance, invertible);
+    if (!invertible || !newCovariance.allFinite())
+      return false;
+
+    movement = newCovariance * ((informationVector - gamma * weightedSumTransposed * sumOfMeasurements) * scale);
+    covariance = newCovariance;
+    return true;
+  }
+};
+
 template<int stateDim, int nDim>
 class KalmanStateUpdateObservations2017
 {
@@ -68,6 +158,10 @@ private:
   Eigen::Matrix<double, nDim, 1> expectedMeasurement;
   Eigen::Matrix<double, nDim, 1> tempVector;
   Eigen::Matrix<double, stateDim, stateDim> tempMatrixOfFullDimension;
+  Matrix2d singleMeasurementCovarianceInverse;
+  double correlationFactor = 0.0;
+  bool useInformationForm = false; /**< Is the measurement covariance suitable for the update in information form? */
+  CorrelatedMeasurementAccumulator2017<stateDim, 2> accumulator;
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -96,6 +190,11 @@ public:
         measurementCovariance(row, col) = factor * singleMeasurementCovariance(row % 2, col % 2);
       }
     }
+
+    bool invertible;
+    singleMeasurementCovariance.computeInverseWithCheck(singleMeasurementCovarianceInverse, invertible);
+    correlationFactor = correlationFactorBetweenMeasurements;
+    useInformationForm = invertible && correlationFactor >= 0.0 && correlationFactor < 1.0;
   }
 
   Eigen::Matrix<double, stateDim, 1> updateWithLocalObservations(
@@ -103,6 +202,16 @@ public:
     Eigen::Matrix<double, stateDim, stateDim> & covariance)
   {
     Eigen::Matrix<double, stateDim, 1> movement;
+    if (useInformationForm)
+    {
+      accumulator.clear();
+      for (const SphericalObservation<stateDim>& observation : sphericalObservations)
+        accumulator.add(observation.measurementModelJacobian, (observation.realAngles - observation.nominalAngles) * observation.weight,
+          singleMeasurementCovarianceInverse);
+      if (accumulator.apply(singleMeasurementCovarianceInverse, correlationFactor, covariance, movement))
+        return movement;
+    }
+
     const size_t n = 2 * sphericalObservations.size();
 
     tempVector = Eigen::Matrix<double, nDim, 1>::Zero();
@@ -149,6 +258,10 @@ private:
   Eigen::Matrix<double, nDim, 1> infiniteLineExpectedMeasurement;
   Eigen::Matrix<double, nDim, 1> infiniteLineTempVector;
   Eigen::Matrix<double, stateDim, stateDim> tempMatrixOfFullDimension;
+  Eigen::Matrix<double, stateDim, stateDim> singleMeasurementCovarianceInverse;
+  double correlationFactor = 0.0;
+  bool useInformationForm = false; /**< Is the measurement covariance suitable for the update in information form? */
+  CorrelatedMeasurementAccumulator2017<stateDim, stateDim> accumulator;
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -178,6 +291,11 @@ public:
         infiniteLineMeasurementCovariance(row, col) = factor * singleInfiniteLineMeasurementCovariance(row % stateDim, col % stateDim);
       }
     }
+
+    bool invertible;
+    singleInfiniteLineMeasurementCovariance.computeInverseWithCheck(singleMeasurementCovarianceInverse, invertible);
+    correlationFactor = correlationFactorBetweenMeasurements;
+    useInformationForm = invertible && correlationFactor >= 0.0 && correlationFactor < 1.0;
   }
 
   Eigen::Matrix<double, stateDim, 1> updateWithLocalInfiniteLineObservations(
@@ -186,6 +304,19 @@ public:
   {
 
     Eigen::Matrix<double, stateDim, 1> movement;
+    if (useInformationForm)
+    {
+      accumulator.clear();
+      for (const InfiniteLineObservation<stateDim>& observation : infiniteLineObservations)
+      {
+        const double sign = (observation.nominalNormals.dot(observation.realNormals) > 0) ? 1.0 : -1.0;
+        accumulator.add(observation.measurementModelJacobian, (sign * observation.realNormals - observation.nominalNormals) * observation.weight,
+          singleMeasurementCovarianceInverse);
+      }
+      if (accumulator.apply(singleMeasurementCovarianceInverse, correlationFactor, covariance, movement))
+        return movement;
+    }
+
     const size_t n = stateDim * infiniteLineObservations.size();
 
     infiniteLineTempVector = Eigen::Matrix<double, nDim, 1>::Zero();
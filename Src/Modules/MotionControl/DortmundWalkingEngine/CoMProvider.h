@@ -4,7 +4,6 @@
 */
 
 #pragma once
-#include <list>
 #include "Representations/MotionControl/ActualCoM.h"
 #include "Representations/MotionControl/WalkingEngineParams.h"
 #include "Representations/Infrastructure/JointAngles.h"
@@ -58,12 +57,5 @@ private:
     //const RobotModel &theRobotModel;
 
 		const ActualCoMRCS			&theActualCoMRCS;
-
-		typedef std::list<Footposition> FootList;
-
-		/** List of target foot positions in world coordinate system filled with the
-			foot positions found in theFootpositions. No more needed positions
-			are deleted in every step cycle. */	
-		FootList footPositions;
 };
 
@@ -1,5 +1,9 @@
 #include "FLIPMParamsProvider.h"
 #include "Tools/Module/ModuleManager.h"
+#include "Tools/Streams/InStreams.h"
+#include "Tools/Streams/OutStreams.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 FLIPMParamsProvider::FLIPMParamsProvider() {
@@ -61,6 +65,142 @@ FLIPMParamsProvider::FLIPMParamsProvider() {
   yLQRParams.Gd = loadedFLIPMControllerParameter.controllerParamsY.Gd;
   yLQRParams.Gx = loadedFLIPMControllerParameter.controllerParamsY.Gx;
   yLQRParams.L = loadedFLIPMObserverParameter.observerParamsY.L;
+
+  // Without a cache, the gains of the configuration are assumed to belong to its parameters.
+  // Otherwise, the cache is preferred and the gains are solved again if it does not contain them.
+  InBinaryFile cacheFile("flipmGainCache.dat");
+  if (cacheFile.exists())
+    cacheFile >> gainCache;
+  const bool seedCache = gainCache.entries.empty();
+  for (Dimension dim : {X, Y})
+  {
+    LQRParams& lqrParams = dim == X ? xLQRParams : yLQRParams;
+    const unsigned key = getKey(dim);
+    if (lookUp(dim, key, lqrParams))
+      currentKey[dim] = key;
+    else if (seedCache && isValid(dim, lqrParams))
+    {
+      currentKey[dim] = key;
+      store(key, lqrParams);
+    }
+  }
+}
+
+unsigned FLIPMParamsProvider::getKey(Dimension dim) const
+{
+  std::vector<char> buffer;
+  OutBinaryVector stream(buffer);
+  stream << (dim == X ? paramsX : paramsY) << useRobustIterationMethod << DARE_maxIterations << DARE_threshold;
+
+  // FNV-1a
+  unsigned key = 2166136261u;
+  for (char c : buffer)
+    key = (key ^ static_cast<unsigned char>(c)) * 16777619u;
+  return key;
+}
+
+bool FLIPMParamsProvider::isValid(Dimension dim, const LQRParams& lqrParams) const
+{
+  LQRParams model;
+  createModel(dim == X ? paramsX : paramsY, model);
+  return lqrParams.A.allFinite() && lqrParams.b.allFinite() && lqrParams.c.allFinite() && std::isfinite(lqrParams.Gi)
+         && lqrParams.Gx.allFinite() && lqrParams.Gd.allFinite() && lqrParams.L.allFinite() && lqrParams.Gi != 0.0
+         && lqrParams.A.isApprox(model.A, 1e-4) && lqrParams.b.isApprox(model.b, 1e-4) && lqrParams.c.isApprox(model.c, 1e-4);
+}
+
+bool FLIPMParamsProvider::lookUp(Dimension dim, unsigned key, LQRParams& lqrParams)
+{
+  auto entry = std::find_if(gainCache.entries.begin(), gainCache.entries.end(), [key](const FLIPMCachedGains& entry) {return entry.key == key;});
+  if (entry == gainCache.entries.end())
+    return false;
+  LQRParams cached;
+  cached.A = entry->controller.A;
+  cached.b = entry->controller.b;
+  cached.c = entry->controller.c;
+  cached.Gi = entry->controller.Gi;
+  cached.Gx = entry->controller.Gx;
+  cached.Gd = entry->controller.Gd;
+  cached.L = entry->observer.L;
+  if (!isValid(dim, cached))
+    return false;
+  lqrParams = cached;
+  return true;
+}
+
+void FLIPMParamsProvider::store(unsigned key, const LQRParams& lqrParams)
+{
+  FLIPMCachedGains entry;
+  entry.key = key;
+  entry.controller.A = lqrParams.A;
+  entry.controller.b = lqrParams.b;
+  entry.controller.c = lqrParams.c;
+  entry.controller.Gi = lqrParams.Gi;
+  entry.controller.Gx = lqrParams.Gx;
+  entry.controller.Gd = lqrParams.Gd;
+  entry.observer.L = lqrParams.L;
+
+  std::vector<FLIPMCachedGains>& entries = gainCache.entries;
+  entries.erase(std::remove_if(entries.begin(), entries.end(), [key](const FLIPMCachedGains& entry) {return entry.key == key;}), entries.end());
+  if (entries.size() >= maxCacheEntries)
+    entries.erase(entries.begin());
+  entries.push_back(entry);
+
+  OutBinaryFile stream("flipmGainCache.dat");
+  if (stream.exists())
+    stream << gainCache;
+}
+
+void FLIPMParamsProvider::checkParameters()
+{
+  for (Dimension dim : {X, Y})
+  {
+    if (dim == Y && duplicateXParams)
+      continue;
+    const bool threadStarted = dim == X ? threadXStarted : threadYStarted;
+    const unsigned key = getKey(dim);
+    if (key == currentKey[dim] || threadStarted) // parameters changed during a calculation are checked again when it is finished
+      continue;
+
+    LQRParams& lqrParams = dim == X ? xLQRParams : yLQRParams;
+    if (lookUp(dim, key, lqrParams))
+    {
+      currentKey[dim] = key;
+      (dim == X ? calculationValidX : calculationValidY) = true;
+      OUTPUT_TEXT("FLIPMParamsProvider: Using cached " << getName(dim) << "-Params");
+    }
+    else
+      (dim == X ? initializedX : initializedY) = false;
+  }
+}
+
+void FLIPMParamsProvider::createModel(const FLIPMValues& params, LQRParams& lqrParams) const
+{
+  double dt = params.dt;
+  double dt2 = (dt * dt) / 2;
+  double dt3 = (dt * dt * dt) / 6;
+  double z_h = params.z_h;
+  double g = params.g;
+
+  double M = params.M;
+  double m = params.m;
+  double D = params.D;
+  double E = params.E;
+
+  double DM = D / M;
+  double EM = E / M;
+  double Dm = D / m;
+  double Em = E / m;
+
+  lqrParams.A <<  1,          dt,       dt2,  0,          0,            0,
+                  0,          1,        dt,   0,          0,            0,
+                 -DM,        -EM,       0,    DM,         EM,           0,
+                  0,          0,        0,    1,          dt,           dt2,
+                  Dm * dt,    Em * dt,  0,   -Dm * dt,    1 - Em * dt,  dt,
+                  0,          0,        0,    0,          0,            1;
+
+  lqrParams.b << 0, 0, 0, dt3, dt2, dt;
+
+  lqrParams.c << 1, 0, -z_h / g, 0, 0, 0;
 }
 
 bool FLIPMParamsProvider::checkObservability(const Matrix6d &A, const Matrix3x6d &c) const {
@@ -116,6 +256,9 @@ void FLIPMParamsProvider::update(FLIPMControllerParameter& flipmControllerParame
   param_mutex_X.lock();
     if (finishedCalculationX) {
       xLQRParams = sharedResultsXLQRParams;
+      currentKey[X] = calculationKey[X];
+      if (calculationValidX)
+        store(calculationKey[X], xLQRParams);
       finishedCalculationX = false;
       threadXStarted = false;
       SystemCall::playSound("allright.wav");
@@ -126,6 +269,9 @@ void FLIPMParamsProvider::update(FLIPMControllerParameter& flipmControllerParame
   param_mutex_Y.lock();
     if (finishedCalculationY) {
       yLQRParams = sharedResultsYLQRParams;
+      currentKey[Y] = calculationKey[Y];
+      if (calculationValidY)
+        store(calculationKey[Y], yLQRParams);
       finishedCalculationY = false;
       threadYStarted = false;
       SystemCall::playSound("allright.wav");
@@ -133,10 +279,13 @@ void FLIPMParamsProvider::update(FLIPMControllerParameter& flipmControllerParame
     }
   param_mutex_Y.unlock();
 
+  checkParameters();
+
   if (!initializedX && !threadXStarted) {
     param_mutex_X.lock();
       threadXStarted = true;
     param_mutex_X.unlock();
+    calculationKey[X] = getKey(X);
     calculationThreadX.start(this, &FLIPMParamsProvider::executeX);
     //execute(X);
   }
@@ -145,6 +294,7 @@ void FLIPMParamsProvider::update(FLIPMControllerParameter& flipmControllerParame
     param_mutex_Y.lock();
       threadYStarted = true;
     param_mutex_Y.unlock();
+    calculationKey[Y] = getKey(Y);
     calculationThreadY.start(this, &FLIPMParamsProvider::executeY);
     //execute(Y);
   }
@@ -188,6 +338,9 @@ void FLIPMParamsProvider::update(FLIPMObserverParameter& flipmObserverParameter)
   param_mutex_X.lock();
   if (finishedCalculationX) {
     xLQRParams = sharedResultsXLQRParams;
+    currentKey[X] = calculationKey[X];
+    if (calculationValidX)
+      store(calculationKey[X], xLQRParams);
     finishedCalculationX = false;
     threadXStarted = false;
     OUTPUT_TEXT("Recalculated X-Params");
@@ -197,16 +350,22 @@ void FLIPMParamsProvider::update(FLIPMObserverParameter& flipmObserverParameter)
   param_mutex_Y.lock();
   if (finishedCalculationY) {
     yLQRParams = sharedResultsYLQRParams;
+    currentKey[Y] = calculationKey[Y];
+    if (calculationValidY)
+      store(calculationKey[Y], yLQRParams);
     finishedCalculationY = false;
     threadYStarted = false;
     OUTPUT_TEXT("Recalculated Y-Params");
   }
   param_mutex_Y.unlock();
 
+  checkParameters();
+
   if (!initializedX && !threadXStarted) {
     param_mutex_X.lock();
     threadXStarted = true;
     param_mutex_X.unlock();
+    calculationKey[X] = getKey(X);
     calculationThreadX.start(this, &FLIPMParamsProvider::executeX);
     //execute(X);
   }
@@ -215,6 +374,7 @@ void FLIPMParamsProvider::update(FLIPMObserverParameter& flipmObserverParameter)
     param_mutex_Y.lock();
     threadYStarted = true;
     param_mutex_Y.unlock();
+    calculationKey[Y] = getKey(Y);
     calculationThreadY.start(this, &FLIPMParamsProvider::executeY);
     //execute(Y);
   }
@@ -247,22 +407,6 @@ void FLIPMParamsProvider::execute(Dimension dim)
   LQRParams lqrParams;
   lqrParams.clear();
 
-  double dt = params.dt;
-  double dt2 = (dt * dt) / 2;
-  double dt3 = (dt * dt * dt) / 6;
-  double z_h = params.z_h;
-  double g = params.g;
-
-  double M = params.M;
-  double m = params.m;
-  double D = params.D;
-  double E = params.E;
-
-  double DM = D / M;
-  double EM = E / M;
-  double Dm = D / m;
-  double Em = E / m;
-
   double Qe = params.Qe;
   double Qx = params.Qx;
   double R = params.R;
@@ -271,19 +415,7 @@ void FLIPMParamsProvider::execute(Dimension dim)
   Matrix3d RO = params.RO.cast<double>();
     
   ////////////////////////////////////////////////////////////////////
-  //lqrParams.A = Matrix6d::Zero();
-  lqrParams.A <<  1,          dt,       dt2,  0,          0,            0,
-                  0,          1,        dt,   0,          0,            0,
-                 -DM,        -EM,       0,    DM,         EM,           0,
-                  0,          0,        0,    1,          dt,           dt2,
-                  Dm * dt,    Em * dt,  0,   -Dm * dt,    1 - Em * dt,  dt,
-                  0,          0,        0,    0,          0,            1;
-
-  //lqrParams.b = Vector6d::Zero();
-  lqrParams.b << 0, 0, 0, dt3, dt2, dt;
-
-  //lqrParams.c = Matrix1x6d::Zero();
-  lqrParams.c << 1, 0, -z_h / g, 0, 0, 0;
+  createModel(params, lqrParams);
 
   Vector7d Bt = Vector7d::Zero();
   Bt << lqrParams.c.dot(lqrParams.b) , lqrParams.b;
@@ -8,6 +8,20 @@
 #include "Platform/Thread.h"
 #include <mutex>
 
+/** Gains solved for a set of parameters of one dimension. */
+STREAMABLE(FLIPMCachedGains,
+{ ,
+  (unsigned)(0) key, /**< The hash of the parameters the gains were solved for. */
+  (FLIPMControllerValues) controller,
+  (FLIPMObserverValues) observer,
+});
+
+/** The gains solved so far. It is stored in flipmGainCache.dat. */
+STREAMABLE(FLIPMGainCache,
+{ ,
+  (std::vector<FLIPMCachedGains>) entries, /**< The most recently solved entry is the last one. */
+});
+
 MODULE(FLIPMParamsProvider,
 { ,
   PROVIDES_WITHOUT_MODIFY(FLIPMParameter),
@@ -94,6 +108,11 @@ protected:
   bool initializedFLIPMParams = false;
   FLIPMParameter lastFLIPMParams;
 
+  static const size_t maxCacheEntries = 16; /**< The number of gain sets kept in the cache. */
+  unsigned currentKey[2] = {0, 0}; /**< The keys of the parameters the current gains belong to. */
+  unsigned calculationKey[2] = {0, 0}; /**< The keys of the parameters the threads solve for. */
+  FLIPMGainCache gainCache; /**< Only accessed in the Motion thread, because streaming it needs the stream handler of that thread. */
+
   void update(FLIPMParameter& flipmParameter) {
     flipmParameter.paramsX = paramsX;
     flipmParameter.paramsY = paramsY;
@@ -103,6 +122,39 @@ protected:
   void execute(Dimension dim);
   void executeX() { execute(X); }
   void executeY() { execute(Y); }
+
+  /**
+   * Switches to the gains for the current parameters if they changed. The gains
+   * are taken from the cache if possible. Otherwise, they are solved in the
+   * background, while the previous gains are still used.
+   */
+  void checkParameters();
+
+  /**
+   * Calculates the key of the parameters of a dimension, i.e. a hash of all
+   * values the solution depends on.
+   */
+  unsigned getKey(Dimension dim) const;
+
+  /** Fills in A, b, and c, i.e. the parts of the model that do not require solving a DARE. */
+  void createModel(const FLIPMValues& params, LQRParams& lqrParams) const;
+
+  /**
+   * Checks whether gains are finite and belong to the current parameters of a
+   * dimension. The model is compared with a tolerance, because the gains
+   * loaded from flipmControllerParameter.cfg are rounded.
+   */
+  bool isValid(Dimension dim, const LQRParams& lqrParams) const;
+
+  /**
+   * Looks up the gains for a dimension in the cache. The gains are only
+   * returned if they are finite and match the model of the current parameters.
+   * @return Were valid gains found?
+   */
+  bool lookUp(Dimension dim, unsigned key, LQRParams& lqrParams);
+
+  /** Adds the gains to the cache and writes it to disk. Must not be called by the calculation threads. */
+  void store(unsigned key, const LQRParams& lqrParams);
   bool checkObservability(const Matrix6d &A, const Matrix3x6d &c) const;
   bool checkControllability(const Matrix7d &A, const Vector7d &b) const;
 
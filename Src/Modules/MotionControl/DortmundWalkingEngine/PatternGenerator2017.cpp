@@ -27,6 +27,7 @@
  */
 
 #include "PatternGenerator2017.h"
+#include "Tools/Debugging/AllocationCounter.h"
 #include <iostream>
 #include "Platform/File.h"
 #include "Tools/Math/Bspline.h"
@@ -522,7 +523,7 @@ void PatternGenerator2017::updateWalkPhase()
   }
 }
 
-Vector2f PatternGenerator2017::prependCustomStep(std::list<PatternGenerator2017::Step>& steps, Vector2f distance, bool onFloorLeft)
+Vector2f PatternGenerator2017::prependCustomStep(std::vector<PatternGenerator2017::Step>& steps, Vector2f distance, bool onFloorLeft)
 {
   // step limits
   Vector2f min(-0.10f, -0.05f);
@@ -558,7 +559,7 @@ Vector2f PatternGenerator2017::prependCustomStep(std::list<PatternGenerator2017:
   step.footPos[1] = Vector2f(0.f, 0.f);
   step.swingFootTraj = {};
 
-  steps.push_front(step);
+  steps.insert(steps.begin(), step);
 
   step.duration = getPhaseLength(1-theWalkingEngineParams.footMovement.doubleSupportRatio, calcDynamicStepDuration(distance.x(), distance.y(), 0.f));
   step.onFloor[0] = onFloorLeft;
@@ -567,12 +568,12 @@ Vector2f PatternGenerator2017::prependCustomStep(std::list<PatternGenerator2017:
   step.footPos[1] = step.onFloor[1] ? Vector2f(0.f, 0.f) : distance;
   step.swingFootTraj = {};
 
-  steps.push_front(step);
+  steps.insert(steps.begin(), step);
 
   return distanceLeft;
 }
 
-bool PatternGenerator2017::prependCustomSteps(std::list<PatternGenerator2017::Step>& steps, Pose2f pose, bool startFootLeft, bool endFootLeft, int maxSteps, const StepsFile &stepsFile)
+bool PatternGenerator2017::prependCustomSteps(std::vector<PatternGenerator2017::Step>& steps, Pose2f pose, bool startFootLeft, bool endFootLeft, int maxSteps, const StepsFile &stepsFile)
 {
   if (std::abs(pose.rotation) >= 90_deg)
     return false;
@@ -868,16 +869,15 @@ WalkRequest::StepRequest PatternGenerator2017::selectCustomStepForKick(const Vec
 
     for (int i = 0; i < 2; i++)
     {
-      StepsFile steps = stepFiles[idx];
+      // assignment reuses the memory of the previous candidate
+      kickCandidate = stepFiles[idx];
       if (i)
-        steps.mirror();
-      std::list<PatternGenerator2017::Step> prependedSteps;
-      Pose2f kickPose(calcKickPose(steps, kickTarget));
+        kickCandidate.mirror();
+      prependedSteps.clear();
+      Pose2f kickPose(calcKickPose(kickCandidate, kickTarget));
       bool prependSuccessful = 
-        prependCustomSteps(prependedSteps, kickPose, currentWalkingPhase == secondSingleSupport, steps.steps.front().onFloor[LEFT_FOOT], maxPrependedSteps, steps);
-      steps.steps.insert(steps.steps.begin(), prependedSteps.begin(), prependedSteps.end());
+        prependCustomSteps(prependedSteps, kickPose, currentWalkingPhase == secondSingleSupport, kickCandidate.steps.front().onFloor[LEFT_FOOT], maxPrependedSteps, kickCandidate);
 
-      kickPose = calcKickPose(steps, kickTarget);
       // TODO: better measurement or scrap it completely since maxPrependedSteps tells the story..
       // maybe use the distance and rotation of the prepended steps
       // TODO: distinguish between long and short kicks
@@ -887,15 +887,20 @@ WalkRequest::StepRequest PatternGenerator2017::selectCustomStepForKick(const Vec
       {
         bestKick = kick;
         bestScore = score;
-        currentSteps = steps;
+        currentSteps = kickCandidate;
+        bestPrependedSteps = prependedSteps;
       }
     }
   }
 
+  // only the selected kick gets its prepended steps
+  if (bestKick != WalkRequest::StepRequest::none)
+    currentSteps.steps.insert(currentSteps.steps.begin(), bestPrependedSteps.begin(), bestPrependedSteps.end());
+
   return bestKick;
 }
 
-float PatternGenerator2017::getScore(const std::list<PatternGenerator2017::Step>& steps)
+float PatternGenerator2017::getScore(const std::vector<PatternGenerator2017::Step>& steps)
 {
   float score = 0.f;
   for (const PatternGenerator2017::Step& step : steps)
@@ -1503,7 +1508,7 @@ void PatternGenerator2017::createFootStepTrajectory()
   // new stuff
   currentFootStepTrajectory.resize(curStep.singleSupportDurationInFrames);
   const int noControlPoints = 7;
-  std::vector<Point> controlVector(noControlPoints);
+  Point controlVector[noControlPoints];
   controlVector[0] = Point();
   for (int i = 1; i < noControlPoints-1; i++)
   {
@@ -1513,8 +1518,8 @@ void PatternGenerator2017::createFootStepTrajectory()
     controlVector[i].r = theWalkingEngineParams.footMovement.rotPolygon[i - 1];
   }
   controlVector[noControlPoints-1] = Point(1.f,1.f,0.f,1.f);
-  std::vector<Point> offsetSpline(curStep.singleSupportDurationInFrames);
-  BSpline<Point>::bspline(noControlPoints-1, 3, &(controlVector[0]), &(offsetSpline[0]), curStep.singleSupportDurationInFrames);
+  offsetSpline.resize(curStep.singleSupportDurationInFrames);
+  BSpline<Point>::bspline(noControlPoints-1, 3, controlVector, &(offsetSpline[0]), curStep.singleSupportDurationInFrames);
   Point offsetForThisFrame;
 
   if (footNum == LEFT_FOOT)
@@ -1528,13 +1533,13 @@ void PatternGenerator2017::createFootStepTrajectory()
       offsetForThisFrame.y = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].y * footDiffRelative.translation.y();
       offsetForThisFrame.z = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].z * walkStepHeight;
       offsetForThisFrame.r = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].r * footDiff.rotation;
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].r = lastLeftFootPose2f.rotation + offsetForThisFrame.r;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].r = lastLeftFootPose2f.rotation + offsetForThisFrame.r;
       offsetForThisFrame.rotate2D(lastLeftFootPose2f.rotation);
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].x = lastLeftFootPose2f.translation.x() + offsetForThisFrame.x;
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].y = lastLeftFootPose2f.translation.y() + offsetForThisFrame.y;
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].z = offsetForThisFrame.z; 
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].rx = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].z * footRoll;
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].ry = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].z * footPitch;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].x = lastLeftFootPose2f.translation.x() + offsetForThisFrame.x;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].y = lastLeftFootPose2f.translation.y() + offsetForThisFrame.y;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].z = offsetForThisFrame.z; 
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].rx = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].z * footRoll;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].ry = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].z * footPitch;
     }
   }
   if (footNum == RIGHT_FOOT)
@@ -1548,13 +1553,13 @@ void PatternGenerator2017::createFootStepTrajectory()
       offsetForThisFrame.y = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].y * footDiffRelative.translation.y();
       offsetForThisFrame.z = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].z * walkStepHeight;
       offsetForThisFrame.r = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].r * footDiff.rotation;
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].r = lastRightFootPose2f.rotation + offsetForThisFrame.r;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].r = lastRightFootPose2f.rotation + offsetForThisFrame.r;
       offsetForThisFrame.rotate2D(lastRightFootPose2f.rotation);
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].x = lastRightFootPose2f.translation.x() + offsetForThisFrame.x;
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].y = lastRightFootPose2f.translation.y() + offsetForThisFrame.y;
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].z = offsetForThisFrame.z;
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].rx = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].z * footRoll;
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].ry = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].z * footPitch;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].x = lastRightFootPose2f.translation.x() + offsetForThisFrame.x;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].y = lastRightFootPose2f.translation.y() + offsetForThisFrame.y;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].z = offsetForThisFrame.z;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].rx = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].z * footRoll;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].ry = offsetSpline[curStep.singleSupportDurationInFrames - i - 1].z * footPitch;
     }
   }
   return;
@@ -1563,7 +1568,7 @@ void PatternGenerator2017::createFootStepTrajectory()
   int len = curStep.singleSupportDurationInFrames;
   currentFootStepTrajectory.resize(len);
   for (int i = 0; i < len; i++)
-    currentFootStepTrajectory[i] = plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum];
+    currentFootStepTrajectory[i] = plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum];
   Point polygonEnd = curStep.footPos[footNum];
   Point* output = &(currentFootStepTrajectory[0]);
 
@@ -1592,10 +1597,10 @@ void PatternGenerator2017::createFootStepTrajectory()
     // Add position offset from custom step trajectory
     for (int i = 0; i < len; i++)
     {
-      output[len - i - 1].x += plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].x - polygonEnd.x;
-      output[len - i - 1].y += plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].y - polygonEnd.y;
-      output[len - i - 1].z += plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum].z - polygonEnd.z;
-      plannedFootSteps.steps.at(numOfSteps - i - 1).footPos[footNum] = Point(currentFootStepTrajectory[len-i-1]);
+      output[len - i - 1].x += plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].x - polygonEnd.x;
+      output[len - i - 1].y += plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].y - polygonEnd.y;
+      output[len - i - 1].z += plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum].z - polygonEnd.z;
+      plannedFootSteps.getStep(numOfSteps - i - 1).footPos[footNum] = Point(currentFootStepTrajectory[len-i-1]);
     }
   }
 }
@@ -1702,7 +1707,7 @@ void PatternGenerator2017::updateFootSteps()
     lastStep = resetFootPosition;
     lastStep.onFloor[LEFT_FOOT] = true;
     lastStep.onFloor[RIGHT_FOOT] = true;
-    if (plannedFootSteps.steps[0].onFloor[RIGHT_FOOT])
+    if (plannedFootSteps.getStep(0).onFloor[RIGHT_FOOT])
     {
       robotPose2f = rightFootPose2f;
       robotPose2f.translate(0, theWalkingEngineParams.footMovement.footYDistance);
@@ -1731,7 +1736,7 @@ void PatternGenerator2017::updateFootSteps()
     currentState = walking;
     
     currentTimeStamp = resetFootPosition.timestamp + 1;
-    plannedFootSteps.steps.clear();
+    plannedFootSteps.clear();
     direction = (leftFootPose2f.rotation + rightFootPose2f.rotation)/2.f;
     
   }
@@ -1778,32 +1783,32 @@ void PatternGenerator2017::updateFootSteps()
 
   if (useResetPreview && running)
   {
-    bool isSingleSupport = (plannedFootSteps.steps[0].phase == firstSingleSupport ||
-      plannedFootSteps.steps[0].phase == secondSingleSupport);
+    bool isSingleSupport = (plannedFootSteps.getStep(0).phase == firstSingleSupport ||
+      plannedFootSteps.getStep(0).phase == secondSingleSupport);
     bool stepStart = isSingleSupport &&
-      plannedFootSteps.steps[0].frameInPhase == 0;
+      plannedFootSteps.getStep(0).frameInPhase == 0;
 
     bool nextDoubleSupport = isSingleSupport &&
-      (plannedFootSteps.steps[1].phase == firstDoubleSupport || plannedFootSteps.steps[1].phase == secondDoubleSupport);
+      (plannedFootSteps.getStep(1).phase == firstDoubleSupport || plannedFootSteps.getStep(1).phase == secondDoubleSupport);
     
     if (stepStart)
     {
-      int footNum = (plannedFootSteps.steps[0].phase == secondSingleSupport) ? LEFT_FOOT : RIGHT_FOOT;
-      robotPose2fAfterCurrentStep = Pose2f(plannedFootSteps.steps[plannedFootSteps.steps[0].singleSupportDurationInFrames].footPos[footNum]);
+      int footNum = (plannedFootSteps.getStep(0).phase == secondSingleSupport) ? LEFT_FOOT : RIGHT_FOOT;
+      robotPose2fAfterCurrentStep = Pose2f(plannedFootSteps.getStep(plannedFootSteps.getStep(0).singleSupportDurationInFrames).footPos[footNum]);
       robotPose2fAfterCurrentStep.translate(0.f, (-1 + 2 * footNum)*theWalkingEngineParams.footMovement.footYDistance);
     }
     if (nextDoubleSupport)
     {
-      //speedBeforeStep = Pose2f(plannedFootSteps.steps[0].lastSpeed);
+      //speedBeforeStep = Pose2f(plannedFootSteps.getStep(0).lastSpeed);
     }
   }
 
-  if (useResetPreview && !plannedFootSteps.steps.empty() && !plannedFootSteps.steps[0].customStepRunning) {
+  if (useResetPreview && !plannedFootSteps.empty() && !plannedFootSteps.getStep(0).customStepRunning) {
     localSteps.robotPoseAfterStep = Point(robotPose2fAfterCurrentStep);
   }
   else {
     // TODO: use position after all of the current custom step
-    /*if (plannedFootSteps.steps[0].customStepRunning)
+    /*if (plannedFootSteps.getStep(0).customStepRunning)
     {
       
     }
@@ -1882,7 +1887,7 @@ void PatternGenerator2017::updateFootPositions()
     angleSumBodyTiltBack = 0;
     return;
   }
-  if (plannedFootSteps.steps.empty())
+  if (plannedFootSteps.empty())
     localFootPositions = localSteps.suggestedStep;
   else
   {
@@ -1906,16 +1911,16 @@ void PatternGenerator2017::updateFootPositions()
     PLOT("module:PatternGenerator2017:angleSumTiltBack", angleSumBodyTiltBack);
     localFootPositions = plannedFootSteps.getStep(0);
     localFootPositions.inKick = plannedFootSteps.getStep(0).customStepRunning && plannedFootSteps.getStep(0).inKick;
-    resetPreviewPossible = plannedFootSteps.steps.size() > 1 &&
-      (plannedFootSteps.steps[0].phase == firstDoubleSupport || plannedFootSteps.steps[0].phase == secondDoubleSupport) &&
-      (plannedFootSteps.steps[1].phase == firstSingleSupport || plannedFootSteps.steps[1].phase == secondSingleSupport);
+    resetPreviewPossible = plannedFootSteps.getNumOfSteps() > 1 &&
+      (plannedFootSteps.getStep(0).phase == firstDoubleSupport || plannedFootSteps.getStep(0).phase == secondDoubleSupport) &&
+      (plannedFootSteps.getStep(1).phase == firstSingleSupport || plannedFootSteps.getStep(1).phase == secondSingleSupport);
     if (resetPreviewPossible)
     {
-      nextPlannedFootPosition = plannedFootSteps.steps[1];
+      nextPlannedFootPosition = plannedFootSteps.getStep(1);
       if (skipStepInReset)
-        resetFootPosition = plannedFootSteps.steps[1];
+        resetFootPosition = plannedFootSteps.getStep(1);
       else
-        resetFootPosition = plannedFootSteps.steps[0];
+        resetFootPosition = plannedFootSteps.getStep(0);
     }
     plannedFootSteps.popFront();
   }
@@ -1926,10 +1931,12 @@ void PatternGenerator2017::updateRefZMP2018()
   localRefZMP2018.running = running;
   if (running)
   {
-    while (localRefZMP2018.zmpWCS.size() >= (size_t)currentPreviewLength)
-      localRefZMP2018.zmpWCS.erase(localRefZMP2018.zmpWCS.begin());
-    while (localRefZMP2018.zmpRCS.size() >= (size_t)currentPreviewLength)
-      localRefZMP2018.zmpRCS.erase(localRefZMP2018.zmpRCS.begin());
+    // Keep currentPreviewLength - 1 entries. Removing them at once shifts the rest only once.
+    const size_t keep = currentPreviewLength > 0 ? currentPreviewLength - 1 : 0;
+    if (localRefZMP2018.zmpWCS.size() > keep)
+      localRefZMP2018.zmpWCS.erase(localRefZMP2018.zmpWCS.begin(), localRefZMP2018.zmpWCS.end() - keep);
+    if (localRefZMP2018.zmpRCS.size() > keep)
+      localRefZMP2018.zmpRCS.erase(localRefZMP2018.zmpRCS.begin(), localRefZMP2018.zmpRCS.end() - keep);
     // Generate ref zmp from foot steps. Usually just one new frame - except at start of controller.
     while (!localSteps.empty())
     {
@@ -2105,21 +2112,31 @@ void PatternGenerator2017::addRefZMP(const Footposition &footPosition)
     refZMPState.lastZMPRCS = lastZMPRCS;
     refZMPState.zmp = zmp;
     refZMPState.lpxss = lpxss;
-    refZMPStates.push_back(refZMPState);
-    if (refZMPStates.size() > 3)
-      refZMPStates.erase(refZMPStates.begin());
+    refZMPStates.push_front(refZMPState);
   }
 }
 
+void PatternGenerator2017::updatePattern()
+{
+  const unsigned allocations = AllocationCounter::getCount();
+  updateFootSteps();
+  updateFootPositions();
+  updateRefZMP2018();
+  const unsigned allocationsInFrame = AllocationCounter::getCount() - allocations;
+  PLOT("module:PatternGenerator2017:allocations", allocationsInFrame);
+
+  // Debug drawings and custom step selection allocate memory. Walking itself should not.
+  DEBUG_RESPONSE("module:PatternGenerator2017:assertNoAllocations")
+    ASSERT(allocationsInFrame == 0);
+}
+
 void PatternGenerator2017::update(FootSteps & steps)
 {
   DECLARE_PLOT("module:PatternGenerator2017:unrotatedZMP.x");
   if (lastTimeExecuted != theFrameInfo.time)
   {
     lastTimeExecuted = theFrameInfo.time;
-    updateFootSteps();
-    updateFootPositions();
-    updateRefZMP2018();
+    updatePattern();
   }
   steps = localSteps;
 }
@@ -2129,9 +2146,7 @@ void PatternGenerator2017::update(Footpositions &footPositions)
   if (lastTimeExecuted != theFrameInfo.time || lastTimeExecuted == 0)
   {
     lastTimeExecuted = theFrameInfo.time;
-    updateFootSteps();
-    updateFootPositions();
-    updateRefZMP2018();
+    updatePattern();
   }
   footPositions = localFootPositions;
 }
@@ -2141,9 +2156,7 @@ void PatternGenerator2017::update(RefZMP2018 &refZMP2018)
   if (lastTimeExecuted != theFrameInfo.time)
   {
     lastTimeExecuted = theFrameInfo.time;
-    updateFootSteps();
-    updateFootPositions();
-    updateRefZMP2018();
+    updatePattern();
   }
   refZMP2018 = localRefZMP2018;
 }
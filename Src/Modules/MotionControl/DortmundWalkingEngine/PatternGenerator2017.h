@@ -211,6 +211,7 @@ protected:
   Footposition resetFootPosition;
   Footposition nextPlannedFootPosition;
   std::vector<Point> currentFootStepTrajectory; /**< trajectory of the current foot step (w/o preview). recalculated once a new foot step phase completes. */
+  std::vector<Point> offsetSpline; /**< Buffer for the normalized swing foot spline, kept to avoid allocations. */
   /** For ZMP generation */
   RefZMP2018 localRefZMP2018;
   Point plotZMP = Point();
@@ -307,7 +308,7 @@ protected:
     float lpxss;										/**< Last position of ZMP along the x axis */
     ZMP zmp, lastZMPRCS;
   };
-  std::vector<RefZMPState> refZMPStates;
+  RingBuffer<RefZMPState, 3> refZMPStates;
 
   /** Calculate some values for the next step (currently step duration). */
   float calcDynamicStepDuration(float speedX, float speedY, float speedR);
@@ -389,13 +390,13 @@ protected:
   void saveStepFiles();
   void loadStepFile(std::string file, int idx);
   void saveStepFile(std::string file, int idx, bool robot = false);
-  Vector2f prependCustomStep(std::list<Step>& steps, Vector2f distance, bool onFloorLeft);
-  bool prependCustomSteps(std::list<Step>& steps, Pose2f pose, bool startFootLeft, bool endFootLeft, int maxSteps, const StepsFile &stepsFile);
+  Vector2f prependCustomStep(std::vector<Step>& steps, Vector2f distance, bool onFloorLeft);
+  bool prependCustomSteps(std::vector<Step>& steps, Pose2f pose, bool startFootLeft, bool endFootLeft, int maxSteps, const StepsFile &stepsFile);
   Pose2f calcKickPose(const StepsFile& steps, const Vector2f& kickTarget);
   bool transitionToCustomSteps();
   bool isStablePosition();
   WalkRequest::StepRequest selectCustomStepForKick(const Vector2f& kickTarget);
-  float getScore(const std::list<PatternGenerator2017::Step>& steps);
+  float getScore(const std::vector<PatternGenerator2017::Step>& steps);
   void transitionFromCustomSteps();
   void transitionToWalk(DWE::MovementInformation &moveInf);
   void setCustomWalkingPhase();
@@ -414,12 +415,17 @@ protected:
   /** Current executed steps, may be modified according to ball position / mirror */
   StepsFile currentSteps;
 
+  /** Buffers for the kick selection, kept to avoid allocations while comparing the kicks */
+  StepsFile kickCandidate;
+  std::vector<Step> prependedSteps, bestPrependedSteps;
+
   /** Begin and end of original custom steps without prepended or appended steps */
   std::vector<Step>::iterator currentStepsBegin, currentStepsEnd;
 
   bool customStepKickInPreview = false;
   
   unsigned lastTimeExecuted = 0;
+  void updatePattern(); /**< updates foot steps, foot positions and reference zmp once per frame */
   void updateFootSteps(); /**< set foot steps */
   void updateFootPositions(); /**< interpolate foot steps into foot positions using speed and trajectory of steps */
   void createFootStepTrajectory(); /**< create trajectory for step once every foot pos has been added to plannedFootSteps */
@@ -11,7 +11,6 @@ FieldColorProvider::FieldColorProvider()
 void FieldColorProvider::update(FieldColors &theFieldColor)
 {
   MODIFY("module:FieldColorProvider:fieldColorLower",localFieldColorLower);
-  MODIFY("module:FieldColorProvider:fieldColorUpper",localFieldColorUpper);
   
   execute(false);
   theFieldColor = localFieldColorLower;
@@ -20,6 +19,8 @@ void FieldColorProvider::update(FieldColors &theFieldColor)
 
 void FieldColorProvider::update(FieldColorsUpper &theFieldColorUpper)
 {
+  MODIFY("module:FieldColorProvider:fieldColorUpper",localFieldColorUpper);
+
   execute(true);
   theFieldColorUpper = localFieldColorUpper;
 }
@@ -78,16 +79,17 @@ void FieldColorProvider::execute(const bool &upper)
 void FieldColorProvider::buildSamples(const bool &upper, const Vector2i &lowerLeft, const Vector2i &upperRight, const int &sampleSize)
 {
   const Image &image = upper ? (Image&)theImageUpper : theImage;
-  sampleNo = 0;
+  Samples &s = upper ? samplesUpper : samplesLower;
+  s.sampleNo = 0;
   int sampleNoMax = sampleSize - 1;
   int scanWidth = upperRight.x() - lowerLeft.x();
   int scanHeight = lowerLeft.y() - upperRight.y();
 
   for (int i = 0; i < 64; i++)
   {
-    histY[i] = 0;
-    histCb[i] = 0;
-    histCr[i] = 0;
+    s.histY[i] = 0;
+    s.histCb[i] = 0;
+    s.histCr[i] = 0;
   }
 
   // build samples
@@ -100,13 +102,13 @@ void FieldColorProvider::buildSamples(const bool &upper, const Vector2i &lowerLe
   {
     for (int y = upperRight.y(); y <= lowerLeft.y(); y += yStep)
     {
-      if (sampleNo < sampleNoMax && !image.isOutOfImage(x, y, 2))
+      if (s.sampleNo < sampleNoMax && !image.isOutOfImage(x, y, 2))
       {
         Image::Pixel p = image[y][x];
-        samples[sampleNo].y = p.y;
-        samples[sampleNo].cb = p.cb;
-        samples[sampleNo].cr = p.cr;
-        sampleNo++;
+        s.samples[s.sampleNo].y = p.y;
+        s.samples[s.sampleNo].cb = p.cb;
+        s.samples[s.sampleNo].cr = p.cr;
+        s.sampleNo++;
       }
     }
   }
@@ -115,16 +117,17 @@ void FieldColorProvider::buildSamples(const bool &upper, const Vector2i &lowerLe
 void FieldColorProvider::calcFieldColorFromSamples(const bool &upper, FieldColors::FieldColor &fieldColor)
 {
   FieldColors::FieldColor &lastMainFieldColor = upper ? localFieldColorUpper.fieldColorArray[0] : localFieldColorLower.fieldColorArray[0];
-  maxY = maxCr = maxCb = oldMax = 0;
+  Samples &s = upper ? samplesUpper : samplesLower;
+  float maxY = 0, maxCr = 0, maxCb = 0, oldMax = 0;
   int optCr = lastMainFieldColor.fieldColorOptCr;
   int maxFieldColorY = lastMainFieldColor.maxFieldColorY;
   int optY = lastMainFieldColor.fieldColorOptY;
 
 
   // find most common cr value and base detection of field color cb/y values on that
-  for (int i = 0; i < sampleNo; i++)
+  for (int i = 0; i < s.sampleNo; i++)
   {
-    histCr[((int)samples[i].cr) / 4] += fieldColorWeighted(samples[i], optCr, maxFieldColorY);
+    s.histCr[((int)s.samples[i].cr) / 4] += fieldColorWeighted(s.samples[i], optCr, maxFieldColorY);
   }
 
 
@@ -132,7 +135,7 @@ void FieldColorProvider::calcFieldColorFromSamples(const bool &upper, FieldColor
   for (int i = 0; i < 64; i++)
   {
     oldMax = maxCr;
-    maxCr = std::max(maxCr, histCr[i]);
+    maxCr = std::max(maxCr, s.histCr[i]);
     if (oldMax < maxCr)
       fieldColor.fieldColorOptCr = i * 4 + 1;
   }
@@ -142,14 +145,14 @@ void FieldColorProvider::calcFieldColorFromSamples(const bool &upper, FieldColor
   int rangeUpCr = 0;
   for (int i = (fieldColor.fieldColorOptCr - 1) / 4 + 1; i < 64; i++)
   {
-    if (histCr[i] > maxCr / 10)
+    if (s.histCr[i] > maxCr / 10)
       rangeUpCr++;
     else
       break;
   }
   for (int i = (fieldColor.fieldColorOptCr - 1) / 4 - 1; i >= 0; i--)
   {
-    if (histCr[i] > maxCr / 10)
+    if (s.histCr[i] > maxCr / 10)
       rangeDownCr++;
     else
       break;
@@ -158,12 +161,12 @@ void FieldColorProvider::calcFieldColorFromSamples(const bool &upper, FieldColor
   fieldColor.fieldColorOptCr = (fieldColor.fieldColorOptCr + ((rangeUpCr - rangeDownCr) * 2));
 
   // find most common cb/y values
-  for (int i = 0; i < sampleNo; i++)
+  for (int i = 0; i < s.sampleNo; i++)
   {
-    if (std::abs(fieldColor.fieldColorOptCr - (int)samples[i].cr) < fieldColor.fieldColorMaxDistCr)
+    if (std::abs(fieldColor.fieldColorOptCr - (int)s.samples[i].cr) < fieldColor.fieldColorMaxDistCr)
     {
-      histCb[((int)samples[i].cb) / 4] += std::max(150 - (int)samples[i].cb, 0);
-      histY[((int)samples[i].y) / 4] += 255 - std::max((int)samples[i].y, std::min(3 * optY / 2, 60));
+      s.histCb[((int)s.samples[i].cb) / 4] += std::max(150 - (int)s.samples[i].cb, 0);
+      s.histY[((int)s.samples[i].y) / 4] += 255 - std::max((int)s.samples[i].y, std::min(3 * optY / 2, 60));
     }
   }
 
@@ -171,11 +174,11 @@ void FieldColorProvider::calcFieldColorFromSamples(const bool &upper, FieldColor
   for (int i = 0; i < 64; i++)
   {
     oldMax = maxCb;
-    maxCb = std::max(histCb[i], maxCb);
+    maxCb = std::max(s.histCb[i], maxCb);
     if (oldMax < maxCb)
       fieldColor.fieldColorOptCb = i * 4 + 1;
     oldMax = maxY;
-    maxY = std::max(histY[i], maxY);
+    maxY = std::max(s.histY[i], maxY);
     if (oldMax < maxY)
       fieldColor.fieldColorOptY = i * 4 + 1;
   }
@@ -185,14 +188,14 @@ void FieldColorProvider::calcFieldColorFromSamples(const bool &upper, FieldColor
   int rangeUpCb = 0;
   for (int i = (fieldColor.fieldColorOptCb - 1) / 4 + 1; i < 64; i++)
   {
-    if (histCb[i] > maxCb / 10)
+    if (s.histCb[i] > maxCb / 10)
       rangeUpCb++;
     else
       break;
   }
   for (int i = (fieldColor.fieldColorOptCb - 1) / 4 - 1; i >= 0; i--)
   {
-    if (histCb[i] > maxCb / 10)
+    if (s.histCb[i] > maxCb / 10)
       rangeDownCb++;
     else
       break;
@@ -206,14 +209,14 @@ void FieldColorProvider::calcFieldColorFromSamples(const bool &upper, FieldColor
   int rangeUp = 0;
   for (int i = (fieldColor.fieldColorOptY - 1) / 4 + 1; i < 64; i++)
   {
-    if (histY[i] > maxY / minYDivFactor)
+    if (s.histY[i] > maxY / minYDivFactor)
       rangeUp++;
     else
       break;
   }
   for (int i = (fieldColor.fieldColorOptY - 1) / 4 - 1; i >= 0; i--)
   {
-    if (histY[i] > maxY / minYDivFactor)
+    if (s.histY[i] > maxY / minYDivFactor)
       rangeDown++;
     else
       break;
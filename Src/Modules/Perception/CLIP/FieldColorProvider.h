@@ -46,14 +46,22 @@ public:
   */
   FieldColorProvider();
 
-  float histY[64];
-  float histCr[64];
-  float histCb[64];
+  /**
+  * The samples of one camera and their histograms. There is one set per camera,
+  * so that both cameras can be processed in parallel.
+  */
+  struct Samples
+  {
+    float histY[64];
+    float histCr[64];
+    float histCb[64];
 
-  Image::Pixel samples[2000];
-  int sampleNo;
+    Image::Pixel samples[2000];
+    int sampleNo;
+  };
 
-  float maxY,maxCr,maxCb,oldMax;
+  Samples samplesLower;
+  Samples samplesUpper;
 
   float minYDivFactor;
   
@@ -3,6 +3,7 @@
 #include "Tools/Debugging/DebugImages.h"
 #include "Tools/Math/Transformation.h"
 #include "Tools/ColorModelConversions.h"
+#include "Platform/SystemCall.h"
 
 #include "Tools/Math/sse_mathfun.h"
 
@@ -37,8 +38,9 @@ YoloRobotDetector::YoloRobotDetector()
 {
   timeStamp = 0;
   timeStampUpper = 0;
+  v6 = Global::getSettings().naoVersion == RobotConfig::V6;
 
-  if(Global::getSettings().naoVersion == RobotConfig::V6)
+  if(v6)
   {
     yoloParameterUpper.input_height = upperV6::input_height;
     yoloParameterUpper.input_width = upperV6::input_width;
@@ -67,7 +69,7 @@ YoloRobotDetector::YoloRobotDetector()
   inputVectorUpper.resize(yoloParameterUpper.input_height * yoloParameterUpper.input_width * yoloParameterUpper.input_channel, 0.f);
   localRobotsPerceptUpper.robots.clear();
 
-  if(Global::getSettings().naoVersion == RobotConfig::V6)
+  if(v6)
   {
     yoloParameter.input_height = lowerV6::input_height;
     yoloParameter.input_width = lowerV6::input_width;
@@ -94,6 +96,46 @@ YoloRobotDetector::YoloRobotDetector()
   detectionVector.reserve(yoloParameter.output_height * yoloParameter.output_width * yoloParameter.num_of_boxes);
   inputVector.resize(yoloParameter.input_height * yoloParameter.input_width * yoloParameter.input_channel, 0.f);
   localRobotsPercept.robots.clear();
+
+  yoloResultUpper.reset(new YoloResult(yoloParameterUpper.output_height, yoloParameterUpper.output_width, yoloParameterUpper.num_of_boxes, yoloParameterUpper.num_of_coords, yoloParameterUpper.num_of_classes));
+  yoloResult.reset(new YoloResult(yoloParameter.output_height, yoloParameter.output_width, yoloParameter.num_of_boxes, yoloParameter.num_of_coords, yoloParameter.num_of_classes));
+
+  loadNetwork(v6 ? upperNetworkV6 : upperNetwork, networkUpper, yoloParameterUpper);
+  loadNetwork(v6 ? lowerNetworkV6 : lowerNetwork, network, yoloParameter);
+
+  // log files are replayed synchronously, so that the results do not depend on timing
+  if(parallelNetworks && SystemCall::getMode() != SystemCall::logfileReplay)
+  {
+    networkThread.setPriority(networkThreadPriority);
+    networkThread.start(this, &YoloRobotDetector::networkMain);
+  }
+}
+
+YoloRobotDetector::~YoloRobotDetector()
+{
+  networkThread.announceStop();
+  networkStart.post();
+  networkThread.stop();
+}
+
+void YoloRobotDetector::loadNetwork(const std::string& fileName, ConvNetwork& localNetwork, const YoloParameter& parameter)
+{
+  if(fileName.empty())
+    return;
+  if(!localNetwork.load(fileName))
+    OUTPUT_WARNING("YoloRobotDetector: Could not load " << fileName << ", using the compiled network.");
+  else
+  {
+    const ConvNetwork::Shape& input = localNetwork.getInputShape();
+    const ConvNetwork::Shape& output = localNetwork.getOutputShape();
+    if(input.height != parameter.input_height || input.width != parameter.input_width || input.channels != parameter.input_channel
+       || output.height != parameter.output_height || output.width != parameter.output_width
+       || output.channels != parameter.num_of_boxes * (parameter.num_of_coords + 1 + parameter.num_of_classes))
+    {
+      OUTPUT_WARNING("YoloRobotDetector: The shape of " << fileName << " does not match the compiled network, using the compiled network.");
+      localNetwork = ConvNetwork();
+    }
+  }
 }
 
 void YoloRobotDetector::reset(const bool& upper) {
@@ -114,8 +156,7 @@ void YoloRobotDetector::update(RobotsPercept& theRobotsPercept)
   DECLARE_DEBUG_DRAWING("module:YoloRobotDetector:shirtScan", "drawingOnImage");
   theRobotsPercept.robots.clear();
   
-  execute(true);
-  execute(false);
+  execute();
 
   addObstacleFromBumpers();
 
@@ -127,8 +168,7 @@ void YoloRobotDetector::update(RobotsPerceptUpper& theRobotsPerceptUpper)
   DECLARE_DEBUG_DRAWING("module:YoloRobotDetector:shirtScanUpper", "drawingOnImage");
   theRobotsPerceptUpper.robots.clear();
 
-  execute(true);
-  execute(false);
+  execute();
 
   theRobotsPerceptUpper = localRobotsPerceptUpper;
 }
@@ -137,8 +177,7 @@ void YoloRobotDetector::update(BallHypothesesYolo& theBallHypothesesYolo) {
   theBallHypothesesYolo.ballSpots.clear();
   theBallHypothesesYolo.ballSpotsUpper.clear();
 
-  execute(true);
-  execute(false);
+  execute();
 
   theBallHypothesesYolo = localBallHypotheses;
 }
@@ -163,228 +202,261 @@ void YoloRobotDetector::update(YoloInput& theYoloInput)
   theYoloInput.imageUpdated = true;
 }
 
-void YoloRobotDetector::execute(const bool& upper)
+void YoloRobotDetector::execute()
 {
-  const Image &image = upper ? (Image&)theImageUpper : theImage;
-  unsigned actualTimeStamp = upper ? timeStampUpper : timeStamp;
-  if (actualTimeStamp != image.timeStamp)
+  const bool upper = prepare(true);
+  const bool lower = prepare(false);
+
+  STOPWATCH("YOLO-Execution")
   {
-    actualTimeStamp = image.timeStamp;
-    if (upper)
+    if(upper && lower && networkThread.isRunning())
     {
-      timeStampUpper = actualTimeStamp;
+      networkStart.post();
+      runNetwork(true);
+      networkDone.wait();
     }
     else
     {
-      timeStamp = actualTimeStamp;
+      if(upper)
+        runNetwork(true);
+      if(lower)
+        runNetwork(false);
     }
+  }
 
-    reset(upper);
+  if(upper)
+    postprocess(true);
+  if(lower)
+    postprocess(false);
+}
 
-    const CameraMatrix &cameraMatrix = upper ? (CameraMatrix&)theCameraMatrixUpper : theCameraMatrix;
-    if (theFallDownState.state != FallDownState::upright || cameraMatrix.isValid == false)
-      return;
+bool YoloRobotDetector::prepare(const bool& upper)
+{
+  const Image &image = upper ? (Image&)theImageUpper : theImage;
+  unsigned &actualTimeStamp = upper ? timeStampUpper : timeStamp;
+  if (actualTimeStamp == image.timeStamp)
+    return false;
+  actualTimeStamp = image.timeStamp;
 
-    RobotsPercept &localPercepts = upper ? (RobotsPercept&)localRobotsPerceptUpper : localRobotsPercept;
-    YoloParameter &localParameter = upper ? (YoloParameter&)yoloParameterUpper : yoloParameter;
-    const CameraInfo &cameraInfo = upper ? (CameraInfo&)theCameraInfoUpper : theCameraInfo;
-    std::vector<float> &input = upper ? (std::vector<float>&)inputVectorUpper : inputVector;
-    std::vector<YoloDetection> &localDetectionVector = upper ? (std::vector<YoloDetection>&)detectionVectorUpper : detectionVector;
-    localDetectionVector.clear();
+  reset(upper);
 
-    YoloResult result(localParameter.output_height, localParameter.output_width, localParameter.num_of_boxes, localParameter.num_of_coords, localParameter.num_of_classes);
+  const CameraMatrix &cameraMatrix = upper ? (CameraMatrix&)theCameraMatrixUpper : theCameraMatrix;
+  if (theFallDownState.state != FallDownState::upright || cameraMatrix.isValid == false)
+    return false;
 
-    STOPWATCH("YOLO-Copy")
-    {
-      if (localParameter.input_channel == 3) {
-        image.copyAndResizeAreaRGBFloat(0, 0, image.width, image.height, localParameter.input_width, localParameter.input_height, &input[0]);
-      }
-      else {
-        image.copyAndResizeAreaFloat(0, 0, image.width, image.height, localParameter.input_width, localParameter.input_height, &input[0]);
-      }
-    }
+  YoloParameter &localParameter = upper ? (YoloParameter&)yoloParameterUpper : yoloParameter;
+  std::vector<float> &input = upper ? (std::vector<float>&)inputVectorUpper : inputVector;
 
-    if (upper) {
-      COMPLEX_IMAGE(YoloDebugImageUpper)
-      {
-        INIT_DEBUG_IMAGE_BLACK(YoloDebugImageUpper, yoloParameterUpper.input_width, yoloParameterUpper.input_height);
-        for (unsigned i = 0; i < yoloParameterUpper.input_height; i++) {
-          for (unsigned j = 0; j < yoloParameterUpper.input_width; j++) {
-
-            if (yoloParameterUpper.input_channel == 3) {
-              float pixely = input[i * yoloParameterUpper.input_width * yoloParameterUpper.input_channel + j * yoloParameterUpper.input_channel + 0] * 255.f;
-              float pixelu = input[i * yoloParameterUpper.input_width * yoloParameterUpper.input_channel + j * yoloParameterUpper.input_channel + 1] * 255.f;
-              float pixelv = input[i * yoloParameterUpper.input_width * yoloParameterUpper.input_channel + j * yoloParameterUpper.input_channel + 2] * 255.f;
-              DEBUG_IMAGE_SET_PIXEL_RGB(YoloDebugImageUpper, j, i, static_cast<unsigned char>(pixely), static_cast<unsigned char>(pixelu), static_cast<unsigned char>(pixelv));
-            }
-            else {
-              float pixel = input[i * yoloParameterUpper.input_width + j] * 255.f;
-              DEBUG_IMAGE_SET_PIXEL_YUV(YoloDebugImageUpper, j, i, static_cast<unsigned char>(pixel), 127, 127);
-            }
+  STOPWATCH("YOLO-Copy")
+  {
+    if (localParameter.input_channel == 3) {
+      image.copyAndResizeAreaRGBFloat(0, 0, image.width, image.height, localParameter.input_width, localParameter.input_height, &input[0]);
+    }
+    else {
+      image.copyAndResizeAreaFloat(0, 0, image.width, image.height, localParameter.input_width, localParameter.input_height, &input[0]);
+    }
+  }
 
+  if (upper) {
+    COMPLEX_IMAGE(YoloDebugImageUpper)
+    {
+      INIT_DEBUG_IMAGE_BLACK(YoloDebugImageUpper, yoloParameterUpper.input_width, yoloParameterUpper.input_height);
+      for (unsigned i = 0; i < yoloParameterUpper.input_height; i++) {
+        for (unsigned j = 0; j < yoloParameterUpper.input_width; j++) {
+
+          if (yoloParameterUpper.input_channel == 3) {
+            float pixely = input[i * yoloParameterUpper.input_width * yoloParameterUpper.input_channel + j * yoloParameterUpper.input_channel + 0] * 255.f;
+            float pixelu = input[i * yoloParameterUpper.input_width * yoloParameterUpper.input_channel + j * yoloParameterUpper.input_channel + 1] * 255.f;
+            float pixelv = input[i * yoloParameterUpper.input_width * yoloParameterUpper.input_channel + j * yoloParameterUpper.input_channel + 2] * 255.f;
+            DEBUG_IMAGE_SET_PIXEL_RGB(YoloDebugImageUpper, j, i, static_cast<unsigned char>(pixely), static_cast<unsigned char>(pixelu), static_cast<unsigned char>(pixelv));
           }
+          else {
+            float pixel = input[i * yoloParameterUpper.input_width + j] * 255.f;
+            DEBUG_IMAGE_SET_PIXEL_YUV(YoloDebugImageUpper, j, i, static_cast<unsigned char>(pixel), 127, 127);
+          }
+
         }
-        SEND_DEBUG_IMAGE(YoloDebugImageUpper);
       }
+      SEND_DEBUG_IMAGE(YoloDebugImageUpper);
     }
-    else {
-      COMPLEX_IMAGE(YoloDebugImage)
-      {
-        INIT_DEBUG_IMAGE_BLACK(YoloDebugImage, yoloParameter.input_width, yoloParameter.input_height);
-        for (unsigned i = 0; i < yoloParameter.input_height; i++) {
-          for (unsigned j = 0; j < yoloParameter.input_width; j++) {
-
-            if (yoloParameter.input_channel == 3) {
-              float pixely = input[i * yoloParameter.input_width * yoloParameter.input_channel + j * yoloParameter.input_channel + 0] * 255.f;
-              float pixelu = input[i * yoloParameter.input_width * yoloParameter.input_channel + j * yoloParameter.input_channel + 1] * 255.f;
-              float pixelv = input[i * yoloParameter.input_width * yoloParameter.input_channel + j * yoloParameter.input_channel + 2] * 255.f;
-              DEBUG_IMAGE_SET_PIXEL_RGB(YoloDebugImage, j, i, static_cast<unsigned char>(pixely), static_cast<unsigned char>(pixelu), static_cast<unsigned char>(pixelv));
-            }
-            else {
-              float pixel = input[i * yoloParameter.input_width + j] * 255.f;
-              DEBUG_IMAGE_SET_PIXEL_YUV(YoloDebugImage, j, i, static_cast<unsigned char>(pixel), 127, 127);
-            }
-
+  }
+  else {
+    COMPLEX_IMAGE(YoloDebugImage)
+    {
+      INIT_DEBUG_IMAGE_BLACK(YoloDebugImage, yoloParameter.input_width, yoloParameter.input_height);
+      for (unsigned i = 0; i < yoloParameter.input_height; i++) {
+        for (unsigned j = 0; j < yoloParameter.input_width; j++) {
+
+          if (yoloParameter.input_channel == 3) {
+            float pixely = input[i * yoloParameter.input_width * yoloParameter.input_channel + j * yoloParameter.input_channel + 0] * 255.f;
+            float pixelu = input[i * yoloParameter.input_width * yoloParameter.input_channel + j * yoloParameter.input_channel + 1] * 255.f;
+            float pixelv = input[i * yoloParameter.input_width * yoloParameter.input_channel + j * yoloParameter.input_channel + 2] * 255.f;
+            DEBUG_IMAGE_SET_PIXEL_RGB(YoloDebugImage, j, i, static_cast<unsigned char>(pixely), static_cast<unsigned char>(pixelu), static_cast<unsigned char>(pixelv));
+          }
+          else {
+            float pixel = input[i * yoloParameter.input_width + j] * 255.f;
+            DEBUG_IMAGE_SET_PIXEL_YUV(YoloDebugImage, j, i, static_cast<unsigned char>(pixel), 127, 127);
           }
+
         }
-        SEND_DEBUG_IMAGE(YoloDebugImage);
       }
+      SEND_DEBUG_IMAGE(YoloDebugImage);
     }
+  }
+
+  return true;
+}
+
+void YoloRobotDetector::runNetwork(const bool& upper)
+{
+  std::vector<float> &input = upper ? inputVectorUpper : inputVector;
+  YoloResult &result = upper ? *yoloResultUpper : *yoloResult;
+  ConvNetwork &localNetwork = upper ? networkUpper : network;
+  if(localNetwork.isLoaded())
+    localNetwork.apply(input.data(), result.result.data());
+  else if(v6)
+  {
+    if(upper)
+      upperV6::cnn(input.data(), result.result.data());
+    else
+      lowerV6::cnn(input.data(), result.result.data());
+  }
+  else
+  {
+    if(upper)
+      upper::cnn(input.data(), result.result.data());
+    else
+      lower::cnn(input.data(), result.result.data());
+  }
+}
 
+void YoloRobotDetector::networkMain()
+{
+  Thread<YoloRobotDetector>::setName("YoloNetwork");
+  BH_TRACE_INIT("YoloNetwork");
 
-    if (upper)
+  while(networkThread.isRunning())
+    if(networkStart.wait(100))
     {
-      STOPWATCH("YOLO-ExecutionUpper")
-      {
-        if(Global::getSettings().naoVersion == RobotConfig::V6)
-        {
-          upperV6::cnn(input.data(), result.result.data());
-        }
-        else
-        {
-          upper::cnn(input.data(), result.result.data());
-        }
-      }
-    }
-    else {
-      STOPWATCH("YOLO-Execution")
-      {
-        if(Global::getSettings().naoVersion == RobotConfig::V6)
-        {
-          lowerV6::cnn(input.data(), result.result.data());
-        }
-        else
-        {
-          lower::cnn(input.data(), result.result.data());
-        }
-      }
+      runNetwork(false);
+      networkDone.post();
     }
+}
 
-    STOPWATCH("YOLO-Postprocessing")
-    {
-      generateNetworkBoxes(1, localDetectionVector, result, upper);
-      std::sort(localDetectionVector.begin(), localDetectionVector.end());
+void YoloRobotDetector::postprocess(const bool& upper)
+{
+  const Image &image = upper ? (Image&)theImageUpper : theImage;
+  const CameraMatrix &cameraMatrix = upper ? (CameraMatrix&)theCameraMatrixUpper : theCameraMatrix;
+  RobotsPercept &localPercepts = upper ? (RobotsPercept&)localRobotsPerceptUpper : localRobotsPercept;
+  const CameraInfo &cameraInfo = upper ? (CameraInfo&)theCameraInfoUpper : theCameraInfo;
+  std::vector<YoloDetection> &localDetectionVector = upper ? (std::vector<YoloDetection>&)detectionVectorUpper : detectionVector;
+  YoloResult &result = upper ? *yoloResultUpper : *yoloResult;
+  localDetectionVector.clear();
+
+  STOPWATCH("YOLO-Postprocessing")
+  {
+    generateNetworkBoxes(1, localDetectionVector, result, upper);
+    std::sort(localDetectionVector.begin(), localDetectionVector.end());
 
-      for (size_t i = 0; i < localDetectionVector.size(); i++) {
-        if (localDetectionVector[i].prob == 0.f) {
-          continue;
-        }
-        else {
-          for (size_t j = i + 1; j < localDetectionVector.size(); j++) {
-            if (iou(localDetectionVector[i].bbox, localDetectionVector[j].bbox, image.height, image.width) >= nmsThreshold) {
-              localDetectionVector[j].prob = 0.f;
-            }
+    for (size_t i = 0; i < localDetectionVector.size(); i++) {
+      if (localDetectionVector[i].prob == 0.f) {
+        continue;
+      }
+      else {
+        for (size_t j = i + 1; j < localDetectionVector.size(); j++) {
+          if (iou(localDetectionVector[i].bbox, localDetectionVector[j].bbox, image.height, image.width) >= nmsThreshold) {
+            localDetectionVector[j].prob = 0.f;
           }
         }
       }
+    }
 
-      for (size_t boxNo = 0; boxNo < localDetectionVector.size(); boxNo++) {
-        const YoloDetection &det = localDetectionVector[boxNo];
+    for (size_t boxNo = 0; boxNo < localDetectionVector.size(); boxNo++) {
+      const YoloDetection &det = localDetectionVector[boxNo];
 
-        if (det.prob > 0.f) 
-        {
-          if (det.sortClass == YoloClasses::Robot) {
-            //// ROBOT ////
-            RobotEstimate re;
-            re.locationOnField.rotation = 0;
-            re.fromUpperImage = upper;
-            re.validity = det.prob;
-            re.timestampFromImage = image.timeStamp;
-
-            Vector2f boxCenter(det.bbox.x * image.width, det.bbox.y * image.height);
-            Vector2f vecBoxCenterToUpperLeft(-(det.bbox.w * image.width) / 2.f, -(det.bbox.h * image.height) / 2);
-            re.imageUpperLeft = (boxCenter + vecBoxCenterToUpperLeft).cast<int>();
-            re.imageLowerRight = (boxCenter - vecBoxCenterToUpperLeft).cast<int>();
-
-            if (Transformation::imageToRobot(Vector2f(boxCenter.x(), re.imageLowerRight.y()), cameraMatrix, cameraInfo,
-              re.locationOnField.translation) &&
-              !(re.locationOnField.translation.x() < 100 && re.locationOnField.translation.y() < 2000) &&
-              re.locationOnField.translation.x() > -1000) {
-
-              re.distance = re.locationOnField.translation.norm();
-              float heightInImage = 0.f;
-              bool localUseYoloHeight = upper ? useYoloHeightUpper : useYoloHeight;
-              if (!localUseYoloHeight) {
-                heightInImage = Geometry::getSizeByDistance(cameraInfo, 550.f, re.distance);
-              }
-              else {
-                heightInImage = det.bbox.h * image.height;
-              }
-              re.imageLowerRight.y() = static_cast<int>(re.imageLowerRight.y());
-              re.imageLowerRight.x() = static_cast<int>(boxCenter.x() + heightInImage / 5.f);
-              re.imageUpperLeft.x() = static_cast<int>(boxCenter.x() - heightInImage / 5.f);
-              re.imageUpperLeft.y() = static_cast<int>(re.imageLowerRight.y() - heightInImage);
+      if (det.prob > 0.f) 
+      {
+        if (det.sortClass == YoloClasses::Robot) {
+          //// ROBOT ////
+          RobotEstimate re;
+          re.locationOnField.rotation = 0;
+          re.fromUpperImage = upper;
+          re.validity = det.prob;
+          re.timestampFromImage = image.timeStamp;
+
+          Vector2f boxCenter(det.bbox.x * image.width, det.bbox.y * image.height);
+          Vector2f vecBoxCenterToUpperLeft(-(det.bbox.w * image.width) / 2.f, -(det.bbox.h * image.height) / 2);
+          re.imageUpperLeft = (boxCenter + vecBoxCenterToUpperLeft).cast<int>();
+          re.imageLowerRight = (boxCenter - vecBoxCenterToUpperLeft).cast<int>();
+
+          if (Transformation::imageToRobot(Vector2f(boxCenter.x(), re.imageLowerRight.y()), cameraMatrix, cameraInfo,
+            re.locationOnField.translation) &&
+            !(re.locationOnField.translation.x() < 100 && re.locationOnField.translation.y() < 2000) &&
+            re.locationOnField.translation.x() > -1000) {
+
+            re.distance = re.locationOnField.translation.norm();
+            float heightInImage = 0.f;
+            bool localUseYoloHeight = upper ? useYoloHeightUpper : useYoloHeight;
+            if (!localUseYoloHeight) {
+              heightInImage = Geometry::getSizeByDistance(cameraInfo, 550.f, re.distance);
+            }
+            else {
+              heightInImage = det.bbox.h * image.height;
+            }
+            re.imageLowerRight.y() = static_cast<int>(re.imageLowerRight.y());
+            re.imageLowerRight.x() = static_cast<int>(boxCenter.x() + heightInImage / 5.f);
+            re.imageUpperLeft.x() = static_cast<int>(boxCenter.x() - heightInImage / 5.f);
+            re.imageUpperLeft.y() = static_cast<int>(re.imageLowerRight.y() - heightInImage);
+            re.robotType = scanForRobotColor(
+              Vector2f(boxCenter.x() - 0.05f*(det.bbox.w * image.width), re.imageLowerRight.y() - heightInImage / 2.f),
+              Vector2f(0.f, -1.f),
+              (int)(2.f * heightInImage / 6.f),
+              upper
+            );
+            if (re.robotType == RobotEstimate::unknownRobot)
+            {
               re.robotType = scanForRobotColor(
-                Vector2f(boxCenter.x() - 0.05f*(det.bbox.w * image.width), re.imageLowerRight.y() - heightInImage / 2.f),
+                Vector2f(boxCenter.x() + 0.05f*(det.bbox.w * image.width), re.imageLowerRight.y() - heightInImage / 2.f),
                 Vector2f(0.f, -1.f),
                 (int)(2.f * heightInImage / 6.f),
                 upper
               );
-              if (re.robotType == RobotEstimate::unknownRobot)
-              {
-                re.robotType = scanForRobotColor(
-                  Vector2f(boxCenter.x() + 0.05f*(det.bbox.w * image.width), re.imageLowerRight.y() - heightInImage / 2.f),
-                  Vector2f(0.f, -1.f),
-                  (int)(2.f * heightInImage / 6.f),
-                  upper
-                );
-              }
-              localPercepts.robots.push_back(re);
             }
+            localPercepts.robots.push_back(re);
           }
-          else if (det.sortClass == YoloClasses::Ball)
-          {
-            //// BALL ////
-            BallSpot bsy;
-            bsy.position = Vector2f(det.bbox.x * image.width, det.bbox.y * image.height).cast<int>();
-            bsy.radiusInImage = std::min<float>((det.bbox.w * image.width) / 2, (det.bbox.h * image.height) / 2);
+        }
+        else if (det.sortClass == YoloClasses::Ball)
+        {
+          //// BALL ////
+          BallSpot bsy;
+          bsy.position = Vector2f(det.bbox.x * image.width, det.bbox.y * image.height).cast<int>();
+          bsy.radiusInImage = std::min<float>((det.bbox.w * image.width) / 2, (det.bbox.h * image.height) / 2);
 
-            bool localUseYoloHeight = upper ? useYoloHeightUpper : useYoloHeight;
+          bool localUseYoloHeight = upper ? useYoloHeightUpper : useYoloHeight;
 
-            if(!localUseYoloHeight)
+          if(!localUseYoloHeight)
+          {
+            // theoretical diameter if cameramatrix is correct
+            Vector2f posOnField;
+            Geometry::Circle expectedCircle;
+            if(Transformation::imageToRobotHorizontalPlane(bsy.position.cast<float>(), theFieldDimensions.ballRadius, cameraMatrix, cameraInfo, posOnField) 
+               && Geometry::calculateBallInImage(posOnField, cameraMatrix, cameraInfo, theFieldDimensions.ballRadius, expectedCircle))
             {
-              // theoretical diameter if cameramatrix is correct
-              Vector2f posOnField;
-              Geometry::Circle expectedCircle;
-              if(Transformation::imageToRobotHorizontalPlane(bsy.position.cast<float>(), theFieldDimensions.ballRadius, cameraMatrix, cameraInfo, posOnField) 
-                 && Geometry::calculateBallInImage(posOnField, cameraMatrix, cameraInfo, theFieldDimensions.ballRadius, expectedCircle))
-              {
-                bsy.radiusInImage = expectedCircle.radius;
-              }
+              bsy.radiusInImage = expectedCircle.radius;
             }
+          }
 
-            bsy.validity = det.prob;
-            bsy.cb = 127;
-            bsy.cr = 127;
-            bsy.y = 0;
-            if (upper)
-            {
-              localBallHypotheses.ballSpotsUpper.push_back(bsy);
-            }
-            else
-            {
-              localBallHypotheses.ballSpots.push_back(bsy);
-            }
+          bsy.validity = det.prob;
+          bsy.cb = 127;
+          bsy.cr = 127;
+          bsy.y = 0;
+          if (upper)
+          {
+            localBallHypotheses.ballSpotsUpper.push_back(bsy);
+          }
+          else
+          {
+            localBallHypotheses.ballSpots.push_back(bsy);
           }
         }
       }
@@ -23,6 +23,10 @@
 #include "Representations/Infrastructure/YoloInput.h"
 #include "Representations/Perception/BallSpots.h"
 #include "Representations/Configuration/FieldDimensions.h"
+#include "Platform/Semaphore.h"
+#include "Platform/Thread.h"
+#include "Tools/NeuralNetwork/ConvNetwork.h"
+#include <memory>
 
 
 STREAMABLE(YUVColor,
@@ -70,6 +74,12 @@ MODULE(YoloRobotDetector,
     (bool)(true) useYoloHeightUpper,
     (YUVColor) ownColor,
     (YUVColor) oppColor,
+    (std::string) upperNetwork, /**< The network file for the upper camera of a V5. The compiled network is used if empty. */
+    (std::string) lowerNetwork, /**< The network file for the lower camera of a V5. The compiled network is used if empty. */
+    (std::string) upperNetworkV6, /**< The network file for the upper camera of a V6. The compiled network is used if empty. */
+    (std::string) lowerNetworkV6, /**< The network file for the lower camera of a V6. The compiled network is used if empty. */
+    (bool)(true) parallelNetworks, /**< Run the network of the lower camera on a separate thread? */
+    (int)(0) networkThreadPriority, /**< The priority of the thread running the network of the lower camera. */
   }),
 });
 
@@ -128,13 +138,14 @@ public:
   DECLARE_DEBUG_IMAGE(YoloDebugImage);
   DECLARE_DEBUG_IMAGE(YoloDebugImageUpper);
   YoloRobotDetector();
+  ~YoloRobotDetector();
 
   void update(RobotsPerceptUpper& theRobotsPerceptUpper);
   void update(RobotsPercept& theRobotsPercept);
   void update(YoloInputUpper& theYoloInputUpper);
   void update(YoloInput& theYoloInput);
   void update(BallHypothesesYolo& theBallHypothesesYolo);
-  void execute(const bool& upper);
+  void execute();
   void reset(const bool& upper);
 private:
   unsigned timeStamp, timeStampUpper; // used to make sure that images are only processed once
@@ -153,6 +164,44 @@ private:
   std::vector<float> inputVectorUpper;
   std::vector<float> inputVector;
 
+  std::unique_ptr<YoloResult> yoloResultUpper;
+  std::unique_ptr<YoloResult> yoloResult;
+
+  ConvNetwork networkUpper; /**< The network for the upper camera if loaded from a file. */
+  ConvNetwork network; /**< The network for the lower camera if loaded from a file. */
+  bool v6 = false; /**< Is this a V6? Read in the constructor, because the network thread cannot access the settings. */
+
+  Thread<YoloRobotDetector> networkThread; /**< Runs the network of the lower camera while the upper one is executed. */
+  Semaphore networkStart; /**< Posted when the input of the lower camera is ready. */
+  Semaphore networkDone; /**< Posted when the network of the lower camera was executed. */
+
+  /**
+   * Loads a network from a file and checks it against the compiled one.
+   * @param fileName The name of the network file. Nothing is loaded if empty.
+   * @param localNetwork The network to load.
+   * @param parameter The parameters of the compiled network.
+   */
+  void loadNetwork(const std::string& fileName, ConvNetwork& localNetwork, const YoloParameter& parameter);
+
+  /**
+   * Checks whether a new image must be processed and prepares the input of the network.
+   * @param upper Process the upper camera?
+   * @return Must the network be executed?
+   */
+  bool prepare(const bool& upper);
+
+  /**
+   * Executes the network for one camera.
+   * @param upper Use the upper camera?
+   */
+  void runNetwork(const bool& upper);
+
+  /** Creates percepts from the output of the network for one camera. */
+  void postprocess(const bool& upper);
+
+  /** The main function of the network thread. */
+  void networkMain();
+
   float iou(YoloRegionBox &box1, YoloRegionBox &box2, int heigth, int width);
 
   /* Fill a single box from network output */
@@ -59,21 +59,56 @@ NaoCameraV6::~NaoCameraV6()
   int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
   VERIFY(ioctl(fd, VIDIOC_STREAMOFF, &type) != -1);
 
+  // the buffers are unmapped and the device is closed when the last reader is gone
+  pool->streaming = false;
+  currentFrame.reset();
+  if (pool.use_count() > 1)
+    OUTPUT_WARNING((upper ? "upper " : "lower ") << "camera : Frame buffers are still held by readers. The device stays open.");
+  pool.reset();
+  free(buf);
+}
+
+NaoCameraV6::FrameBufferPool::~FrameBufferPool()
+{
   // unmap buffers
   for (int i = 0; i < frameBufferCount; ++i)
     munmap(mem[i], memLength[i]);
 
   // close the device
   close(fd);
-  free(buf);
+}
+
+void NaoCameraV6::FrameBufferPool::queue(unsigned index)
+{
+  if (!streaming)
+    return;
+  struct v4l2_buffer buffer;
+  memset(&buffer, 0, sizeof(struct v4l2_buffer));
+  buffer.index = index;
+  buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buffer.memory = V4L2_MEMORY_MMAP;
+  VERIFY(ioctl(fd, VIDIOC_QBUF, &buffer) != -1);
+  ++queued;
+}
+
+void NaoCameraV6::holdDequeuedBuffer()
+{
+  --pool->queued;
+  const unsigned index = buf->index;
+  const std::shared_ptr<FrameBufferPool> pool = this->pool;
+  currentFrame = std::shared_ptr<const unsigned char>(static_cast<const unsigned char*>(pool->mem[index]),
+                                                      [pool, index](const unsigned char*) {pool->queue(index);});
+  timeStamp = static_cast<unsigned long long>(buf->timestamp.tv_sec) * 1000000ll + buf->timestamp.tv_usec;
+  if (pool->queued == 0)
+    OUTPUT_WARNING((upper ? "upper " : "lower ") << "camera : All frame buffers are held by readers. Capturing will stall.");
 }
 
 bool NaoCameraV6::captureNew(NaoCameraV6& cam1, NaoCameraV6& cam2, int timeout, bool& errorCam1, bool& errorCam2)
 {
   NaoCameraV6* cams[2] = { &cam1, &cam2 };
 
-  ASSERT(cam1.currentBuf == nullptr);
-  ASSERT(cam2.currentBuf == nullptr);
+  ASSERT(!cam1.currentFrame);
+  ASSERT(!cam2.currentFrame);
 
   errorCam1 = errorCam2 = false;
 
@@ -108,8 +143,7 @@ bool NaoCameraV6::captureNew(NaoCameraV6& cam1, NaoCameraV6& cam2, int timeout,
       {
         //OUTPUT_ERROR("VIDIOC_DQBUF success revents=" << pollfds[i].revents);
         //ASSERT(buf->bytesused == SIZE);
-        cams[i]->currentBuf = cams[i]->buf;
-        cams[i]->timeStamp = static_cast<unsigned long long>(cams[i]->currentBuf->timestamp.tv_sec) * 1000000ll + cams[i]->currentBuf->timestamp.tv_usec;
+        cams[i]->holdDequeuedBuffer();
 
         if (cams[i]->first)
         {
@@ -141,7 +175,7 @@ bool NaoCameraV6::captureNew(NaoCameraV6& cam1, NaoCameraV6& cam2, int timeout,
 bool NaoCameraV6::captureNew(int timeout)
 {
   // requeue the buffer of the last captured image which is obsolete now
-  ASSERT(currentBuf == nullptr);
+  ASSERT(!currentFrame);
   BH_TRACE;
 
   const unsigned startPollingTimestamp = SystemCall::getCurrentSystemTime();
@@ -170,8 +204,7 @@ bool NaoCameraV6::captureNew(int timeout)
   }
   BH_TRACE;
   //ASSERT(buf->bytesused == SIZE);
-  currentBuf = buf;
-  timeStamp = static_cast<unsigned long long>(currentBuf->timestamp.tv_sec) * 1000000ll + currentBuf->timestamp.tv_usec;
+  holdDequeuedBuffer();
   const unsigned endPollingTimestamp = SystemCall::getCurrentSystemTime();
   timeWaitedForLastImage = endPollingTimestamp - startPollingTimestamp;
 
@@ -186,29 +219,24 @@ bool NaoCameraV6::captureNew(int timeout)
 
 void NaoCameraV6::releaseImage()
 {
-  if (currentBuf)
-  {
-    VERIFY(ioctl(fd, VIDIOC_QBUF, currentBuf) != -1);
-    currentBuf = nullptr;
-  }
+  currentFrame.reset();
 }
 
 const unsigned char* NaoCameraV6::getImage() const
 {
-  return currentBuf ? static_cast<unsigned char*>(mem[currentBuf->index]) : nullptr;
+  return currentFrame.get();
 }
 
 bool NaoCameraV6::hasImage()
 {
-  return !!currentBuf; // true <=> currentBuf != 0
+  return !!currentFrame; // true <=> currentFrame != 0
   //return false;
 }
 
 unsigned long long NaoCameraV6::getTimeStamp() const
 {
-  if (!currentBuf)
+  if (!currentFrame)
     return 0;
-  ASSERT(currentBuf);
   return timeStamp;
 }
 
@@ -656,6 +684,7 @@ void NaoCameraV6::initRequestAndMapBuffers()
   ASSERT(rb.count == frameBufferCount);
 
   // map or prepare the buffers
+  pool = std::make_shared<FrameBufferPool>(fd);
   buf = static_cast<struct v4l2_buffer*>(calloc(1, sizeof(struct v4l2_buffer)));
   for (int i = 0; i < frameBufferCount; ++i)
   {
@@ -663,9 +692,9 @@ void NaoCameraV6::initRequestAndMapBuffers()
     buf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     buf->memory = V4L2_MEMORY_MMAP;
     VERIFY(ioctl(fd, VIDIOC_QUERYBUF, buf) != -1);
-    memLength[i] = buf->length;
-    mem[i] = mmap(0, buf->length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf->m.offset);
-    ASSERT(mem[i] != MAP_FAILED);
+    pool->memLength[i] = buf->length;
+    pool->mem[i] = mmap(0, buf->length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf->m.offset);
+    ASSERT(pool->mem[i] != MAP_FAILED);
   }
 }
 
@@ -673,12 +702,7 @@ void NaoCameraV6::initQueueAllBuffers()
 {
   // queue the buffers
   for (int i = 0; i < frameBufferCount; ++i)
-  {
-    buf->index = i;
-    buf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf->memory = V4L2_MEMORY_MMAP;
-    VERIFY(ioctl(fd, VIDIOC_QBUF, buf) != -1);
-  }
+    pool->queue(i);
 }
 
 void NaoCameraV6::initDefaultControlSettings(bool flip)
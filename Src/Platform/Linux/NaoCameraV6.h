@@ -9,6 +9,8 @@
 #include "Representations/Infrastructure/CameraInfo.h"
 #include "Representations/Infrastructure/CameraSettingsV6.h"
 #include "Representations/Infrastructure/CameraRegisters.h"
+#include <atomic>
+#include <memory>
 
 /**
  * @class NaoCameraV6
@@ -27,7 +29,32 @@ protected:
   unsigned int updateRegisterIndex = 0;
   uint8_t updateRegisterIndexByte = 0;
 
-  enum { frameBufferCount = 3 }; /**< Amount of available frame buffers. */
+  enum { frameBufferCount = 6 }; /**< Amount of available frame buffers. Readers may hold some while the others stay queued. */
+
+  /**
+   * The memory mapped frame buffers of the device. Every dequeued image holds
+   * a reference to the pool, so the buffers stay mapped as long as anyone still
+   * reads one of them, even if the camera itself was already deleted.
+   */
+  struct FrameBufferPool
+  {
+    int fd; /**< The file descriptor for the video device. Closed with the pool. */
+    void* mem[frameBufferCount]; /**< Frame buffer addresses. */
+    int memLength[frameBufferCount]; /**< The length of each frame buffer. */
+    std::atomic<int> queued; /**< The number of buffers currently queued in the driver. */
+    std::atomic<bool> streaming; /**< Are released buffers requeued? Cleared when the camera is deleted. */
+
+    FrameBufferPool(int fd) : fd(fd), queued(0), streaming(true) {}
+
+    /** Unmaps all buffers and closes the device. */
+    ~FrameBufferPool();
+
+    /**
+     * Hands a buffer back to the driver. Can be called from any thread.
+     * @param index The index of the buffer.
+     */
+    void queue(unsigned index);
+  };
 
   unsigned int WIDTH; /**< The width of the yuv 422 image */
   unsigned int HEIGHT; /**< The height of the yuv 422 image */
@@ -35,10 +62,9 @@ protected:
   unsigned int SIZE; /**< The size of an image in bytes */
 #endif
   int fd; /**< The file descriptor for the video device. */
-  void* mem[frameBufferCount]; /**< Frame buffer addresses. */
-  int memLength[frameBufferCount]; /**< The length of each frame buffer. */
+  std::shared_ptr<FrameBufferPool> pool; /**< The frame buffers of this camera. */
   struct v4l2_buffer* buf = nullptr; /**< Reusable parameter struct for some ioctl calls. */
-  struct v4l2_buffer* currentBuf = nullptr; /**< The last dequeued frame buffer. */
+  std::shared_ptr<const unsigned char> currentFrame; /**< The last dequeued frame buffer. It is requeued when its last reader drops it. */
   bool first = true; /**< First image grabbed? */
   unsigned long long timeStamp = 0; /**< Timestamp of the last captured image in microseconds. */
   unsigned frameCounter = 0; /**< FrameCounter, used to write camera settings only after camera had time to start. */
@@ -71,7 +97,8 @@ public:
   static bool captureNew(NaoCameraV6& cam1, NaoCameraV6& cam2, int timeout, bool& errorCam1, bool& errorCam2);
 
   /**
-   * Releases an image that has been captured. That way the buffer can be used to capture another image
+   * Releases an image that has been captured. The buffer is used to capture another image
+   * as soon as no reader obtained through getFrameBuffer() refers to it anymore.
    */
   void releaseImage();
 
@@ -81,6 +108,13 @@ public:
    */
   const unsigned char* getImage() const;
 
+  /**
+   * The last captured image as a buffer shared with the camera. It is not requeued
+   * before all copies of the returned pointer are gone.
+   * @return The shared image data buffer or nullptr if there is no image.
+   */
+  const std::shared_ptr<const unsigned char>& getFrameBuffer() const { return currentFrame; }
+
   /**
    * Whether an image has been captured.
    * @return true if there is one
@@ -161,6 +195,9 @@ protected:
   void initSetImageFormat();
   void initRequestAndMapBuffers();
   void initQueueAllBuffers();
+
+  /** Makes the buffer just dequeued into "buf" the current frame. */
+  void holdDequeuedBuffer();
   void initDefaultControlSettings(bool flip);
   void startCapturing();
 };
@@ -12,7 +12,7 @@
 #include <array>
 #include <memory>
 #include <sstream>
-#ifndef TARGET_TOOL
+#if !defined(TARGET_TOOL) && !defined(HEADLESS)
 #  include "Controller/ConsoleRoboCupCtrl.h"
 #  ifdef WINDOWS
 #    include "Platform/Windows/SoundPlayer.h"
@@ -127,7 +127,7 @@ bool SystemCall::fileExists(const std::string& file)
 
 unsigned SystemCall::getCurrentSystemTime()
 {
-#ifndef TARGET_TOOL
+#if !defined(TARGET_TOOL) && !defined(HEADLESS)
   if(RoboCupCtrl::controller)
     return RoboCupCtrl::controller->getTime();
   else
@@ -218,12 +218,16 @@ const char* SystemCall::getHostAddr()
 
 SystemCall::Mode SystemCall::getMode()
 {
+#ifdef HEADLESS
+  return logfileReplay; // the headless build only replays logs
+#else
 #ifndef TARGET_TOOL
   if(RoboCupCtrl::controller)
     return ((ConsoleRoboCupCtrl*)RoboCupCtrl::controller)->getMode();
   else
 #endif
     return teamRobot;
+#endif
 }
 
 void SystemCall::sleep(unsigned int ms)
@@ -339,6 +343,10 @@ void SystemCall::alignedFree(void* ptr)
 #ifdef TARGET_SIM
 int SystemCall::playSound(const char* name)
 {
+#ifdef HEADLESS
+  return 0;
+#else
   return SoundPlayer::play(name);
+#endif
 }
 #endif
@@ -40,6 +40,7 @@ void Cognition::init()
 	START_MOCAP_COMM;
 #endif // USE_MOCAP
 	moduleManager.load();
+	moduleManager.loadExecutionParameters("Cognition");
 	BH_TRACE_INIT("Cognition");
 
 	// Prepare first frame
@@ -99,8 +100,8 @@ bool Cognition::main()
 		BH_TRACE_MSG("before SEND_TEAM_COMM");
 		if (!theTeamSender.isEmpty())
 		{
-			if (Blackboard::getInstance().exists("TeammateData") &&
-				static_cast<const TeammateData&>(Blackboard::getInstance()["TeammateData"]).sendThisFrame)
+			if (Blackboard::getInstance().exists(idTeammateData) &&
+				static_cast<const TeammateData&>(Blackboard::getInstance()[idTeammateData]).sendThisFrame)
 			{
 				SEND_TEAM_COMM;
 			}
@@ -145,7 +146,7 @@ bool Cognition::main()
 	else if (Global::getDebugRequestTable().poll)
 		--Global::getDebugRequestTable().pollCounter;
 
-	if (Blackboard::getInstance().exists("Image"))
+	if (Blackboard::getInstance().exists(idImage))
 	{
 		if (SystemCall::getMode() == SystemCall::physicalRobot)
 			setPriority(10);
@@ -105,7 +105,7 @@ bool Motion::main()
     OUTPUT(idProcessBegin, bin, 'm');
   }
 
-  if (Blackboard::getInstance().exists("JointSensorData"))
+  if (Blackboard::getInstance().exists(idJointSensorData))
     waitForFrameData();
   else
     SystemCall::sleep(10);
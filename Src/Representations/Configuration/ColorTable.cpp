@@ -9,6 +9,7 @@
 #include "Platform/BHAssert.h"
 #include "Tools/ColorModelConversions.h"
 #include <snappy-c.h>
+#include <emmintrin.h>
 
 /**
  * Tables that map YCbCr color values to HSI or RB color values.
@@ -23,8 +24,8 @@ static const struct ColorSpaceMapper
     unsigned short rb;
   };
 
-  Image::Pixel hsi[32][256][256];
-  RB rb[32][256][256];
+  Image::Pixel hsi[32][64][64];
+  RB rb[32][64][64];
 
   ColorSpaceMapper()
   {
@@ -32,8 +33,8 @@ static const struct ColorSpaceMapper
     RB* q = &rb[0][0][0];
     unsigned char g;
     for(int y = 7; y < 256; y += 8)
-      for(int cb = 0; cb < 256; ++cb)
-        for(int cr = 0; cr < 256; ++cr, ++p, ++q)
+      for(int cb = 2; cb < 256; cb += 4)
+        for(int cr = 2; cr < 256; cr += 4, ++p, ++q)
         {
           ColorModelConversions::fromYCbCrToHSI(static_cast<unsigned char>(y),
                                                 static_cast<unsigned char>(cb),
@@ -94,6 +95,37 @@ void ColorTable::update(const ColorCalibration::WhiteThresholds& thresholds, uns
       dest->colors &= ~color;
 }
 
+void ColorTable::classify(const Image::Pixel* pixels, size_t numOfPixels, Colors* colors) const
+{
+  const Colors* table = &colorTable[0][0][0];
+  const __m128i yMask = _mm_set1_epi32(0x1f << 12);
+  const __m128i cbMask = _mm_set1_epi32(0x3f << 6);
+  alignas(16) int indices[4];
+  size_t i = 0;
+  for(; i + 4 <= numOfPixels; i += 4)
+  {
+    // index = (y >> 3) << 12 | (cb >> 2) << 6 | cr >> 2 for the pixel layout [padding, cb, y, cr]
+    const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+    const __m128i index = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 7), yMask),
+                                                    _mm_and_si128(_mm_srli_epi32(p, 4), cbMask)),
+                                       _mm_srli_epi32(p, 26));
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices), index);
+    colors[i] = table[indices[0]];
+    colors[i + 1] = table[indices[1]];
+    colors[i + 2] = table[indices[2]];
+    colors[i + 3] = table[indices[3]];
+  }
+  for(; i < numOfPixels; ++i)
+    colors[i] = (*this)[pixels[i]];
+}
+
+void ColorTable::classify(const Image& image, std::vector<Colors>& colors) const
+{
+  colors.resize(image.width * image.height);
+  for(int y = 0; y < image.height; ++y)
+    classify(image[y], image.width, colors.data() + y * image.width);
+}
+
 void ColorTable::serialize(In* in, Out* out)
 {
   STREAM_REGISTER_BEGIN;
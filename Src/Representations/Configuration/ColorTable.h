@@ -8,6 +8,7 @@
 
 #include "Representations/Infrastructure/Image.h"
 #include "ColorCalibration.h"
+#include <vector>
 
 struct ColorTable : public Streamable
 {
@@ -27,16 +28,36 @@ struct ColorTable : public Streamable
   };
 
 private:
-  Colors colorTable[32][256][256];
+  /**
+   * The table uses 5 bits of Y and 6 bits of Cb and Cr each, i.e. it has a size of
+   * 128 KB and fits into the L2 cache. Each entry is a bit mask of color classes.
+   */
+  Colors colorTable[32][64][64];
 
 public:
   void fromColorCalibration(const ColorCalibration& colorCalibration, ColorCalibration& prevCalibration);
 
   const Colors& operator[](const Image::Pixel& pixel) const
   {
-    return colorTable[pixel.y >> 3][pixel.cb][pixel.cr];
+    return colorTable[pixel.y >> 3][pixel.cb >> 2][pixel.cr >> 2];
   }
 
+  /**
+   * Classifies a sequence of pixels, e.g. the pixels gathered along a scan line.
+   * The table indices are computed for four pixels at once using SSE.
+   * @param pixels The pixels.
+   * @param numOfPixels The number of pixels.
+   * @param colors The color classes of the pixels. Must provide space for numOfPixels entries.
+   */
+  void classify(const Image::Pixel* pixels, size_t numOfPixels, Colors* colors) const;
+
+  /**
+   * Classifies a whole image.
+   * @param image The image.
+   * @param colors The color classes of all pixels in row-major order. Resized to image.width * image.height.
+   */
+  void classify(const Image& image, std::vector<Colors>& colors) const;
+
 private:
   void update(const ColorCalibration::HSIRanges& ranges, unsigned char color);
   void update(const ColorCalibration::WhiteThresholds& thresholds, unsigned char color);
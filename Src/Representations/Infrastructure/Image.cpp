@@ -4,7 +4,9 @@
  * Implementation of struct Image.
  */
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 #include "Image.h"
 #include "Tools/ColorModelConversions.h"
@@ -51,6 +53,7 @@ Image& Image::operator=(const Image& other)
     // allocate full size image and keep it that way independent of resolution
     image = new Pixel[maxResolutionHeight * maxResolutionWidth * 2];
     isReference = false;
+    sharedBuffer.reset();
   }
 
   const int size = width * sizeof(Pixel)* (isFullSize ? 2 : 1);
@@ -88,6 +91,34 @@ void Image::setImage(Pixel* buffer)
     isReference = true;
   }
   image = buffer;
+  sharedBuffer.reset();
+}
+
+void Image::setImage(const std::shared_ptr<const unsigned char>& buffer)
+{
+  setImage(reinterpret_cast<Pixel*>(const_cast<unsigned char*>(buffer.get())));
+  sharedBuffer = buffer;
+}
+
+void Image::shareImage(const Image& other)
+{
+  if(&other == this)
+    return;
+  setImage(other.image);
+  sharedBuffer = other.sharedBuffer;
+  setResolution(other.width, other.height, other.isFullSize);
+  timeStamp = other.timeStamp;
+}
+
+void Image::unshare()
+{
+  if(!sharedBuffer)
+    return;
+  Pixel* buffer = new Pixel[maxResolutionHeight * maxResolutionWidth * 2];
+  memcpy(buffer, image, height * widthStep * sizeof(Pixel));
+  image = buffer;
+  isReference = false;
+  sharedBuffer.reset();
 }
 
 void Image::setImageBySSECopy(const Image &other, bool halfResolution) {
@@ -228,93 +259,256 @@ void Image::copyAndResizeArea(const int xPos, const int yPos, int sizeX, int siz
   }
 }
 
-void Image::copyAndResizeAreaFloat(const int xPos, const int yPos, int sizeX, int sizeY, int sizeXNew, int sizeYNew, float *result) const
+namespace
 {
-  //ASSERT(result.size() == sizeXNew*sizeYNew);
-  unsigned char* image_ptr = (unsigned char*)image;
-  const int rowStep = widthStep * 4;
-  image_ptr += yPos*rowStep + xPos * 4;
-  unsigned char* row_ptr = image_ptr;
-  float xPrecise = 0.f;
-  const float xStep = static_cast<float>(sizeX) / static_cast<float>(sizeXNew);
-  float yPrecise = 0.f;
-  const float yStep = static_cast<float>(sizeY) / static_cast<float>(sizeYNew);
-  int pixelNo = 0;
-  int lastX = 0;
-  int lastY = 0;
-
-  // precompute x offsets
-  std::vector<int> xIncs(sizeXNew);
-  for (int i = 0; i < sizeXNew; i++)
+  /**
+   * Computes the source pixels of a resize in one dimension, stepping through
+   * the source the same way the original scalar loops did.
+   * @param size The size of the source area.
+   * @param sizeNew The size of the result.
+   * @param begins The offsets of the source pixels of the result pixels,
+   *               padded with the last one to a multiple of 4 entries.
+   * @param ends The ends of the source areas averaged for each result pixel,
+   *             padded the same way.
+   */
+  void computeResizeOffsets(int size, int sizeNew, int* begins, int* ends)
   {
-    xPrecise += xStep;
-    xIncs[i] = static_cast<int>(xPrecise + 0.5) - lastX;
-    lastX += xIncs[i];
+    const int paddedSize = (sizeNew + 3) & ~3;
+    const float step = static_cast<float>(size) / static_cast<float>(sizeNew);
+    float precise = 0.f;
+    int offset = 0;
+    for(int i = 0; i < paddedSize; ++i)
+    {
+      begins[i] = offset;
+      if(i < sizeNew)
+      {
+        precise += step;
+        offset = static_cast<int>(precise + 0.5);
+      }
+      ends[i] = std::max(offset, begins[i] + 1);
+    }
+    for(int i = sizeNew; i < paddedSize; ++i)
+    {
+      begins[i] = begins[sizeNew - 1];
+      ends[i] = ends[sizeNew - 1];
+    }
   }
 
-  for (int y = 0; y < sizeYNew; y++)
+  /**
+   * Reads the channels of the result pixels. Each result pixel is either the
+   * first Y and the Cb/Cr of the source pixel at its offset or the average of
+   * its source area.
+   */
+  class ResizeReader
   {
-    for (int x = 0; x < sizeXNew; x++)
+  public:
+    ResizeReader(const unsigned char* area, int rowStep, int sizeX, int sizeY, int sizeXNew, int sizeYNew, bool average) :
+      area(area), rowStep(rowStep), sizeX(sizeX), average(average)
     {
-      result[pixelNo] = *image_ptr / 255.f;
-      int xInc = xIncs[x];
-      image_ptr += xInc * 4;
-      pixelNo++;
+      const int paddedSizeX = (sizeXNew + 3) & ~3;
+      const int paddedSizeY = (sizeYNew + 3) & ~3;
+      offsets.resize(2 * (paddedSizeX + paddedSizeY));
+      xBegins = offsets.data();
+      xEnds = xBegins + paddedSizeX;
+      yBegins = xEnds + paddedSizeX;
+      yEnds = yBegins + paddedSizeY;
+      computeResizeOffsets(sizeX, sizeXNew, xBegins, xEnds);
+      computeResizeOffsets(sizeY, sizeYNew, yBegins, yEnds);
+      if(average)
+        columnSums.resize(((sizeX + 3) & ~3) * 4);
     }
-    yPrecise += yStep;
-    int yInc = static_cast<int>(yPrecise + 0.5) - lastY;
-    lastY += yInc;
-    row_ptr += yInc * rowStep;
-    image_ptr = row_ptr;
-  }
+
+    /**
+     * Prepares reading a result row. If averaging, the source rows of the
+     * result row are summed up per column.
+     * @param y The index of the result row.
+     */
+    void beginRow(int y)
+    {
+      row = area + yBegins[y] * rowStep;
+      if(!average)
+        return;
+
+      rowCount = yEnds[y] - yBegins[y];
+      const int vectorizedSize = sizeX & ~3;
+      const __m128i zero = _mm_setzero_si128();
+      __m128i* sums = reinterpret_cast<__m128i*>(columnSums.data());
+      for(int x = 0; x < vectorizedSize; x += 4, sums += 4)
+      {
+        __m128i sum0 = zero, sum1 = zero, sum2 = zero, sum3 = zero;
+        for(int firstRow = 0; firstRow < rowCount; firstRow += 128) // 16 bit sums of up to 128 rows cannot overflow
+        {
+          __m128i low = zero;
+          __m128i high = zero;
+          for(const unsigned char* p = row + firstRow * rowStep + x * 4, *pEnd = row + std::min(firstRow + 128, rowCount) * rowStep + x * 4; p < pEnd; p += rowStep)
+          {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            low = _mm_add_epi16(low, _mm_unpacklo_epi8(pixels, zero));
+            high = _mm_add_epi16(high, _mm_unpackhi_epi8(pixels, zero));
+          }
+          sum0 = _mm_add_epi32(sum0, _mm_unpacklo_epi16(low, zero));
+          sum1 = _mm_add_epi32(sum1, _mm_unpackhi_epi16(low, zero));
+          sum2 = _mm_add_epi32(sum2, _mm_unpacklo_epi16(high, zero));
+          sum3 = _mm_add_epi32(sum3, _mm_unpackhi_epi16(high, zero));
+        }
+        _mm_storeu_si128(sums, sum0);
+        _mm_storeu_si128(sums + 1, sum1);
+        _mm_storeu_si128(sums + 2, sum2);
+        _mm_storeu_si128(sums + 3, sum3);
+      }
+      for(int i = vectorizedSize * 4; i < sizeX * 4; ++i)
+      {
+        columnSums[i] = 0;
+        for(const unsigned char* p = row + i, *pEnd = p + rowCount * rowStep; p < pEnd; p += rowStep)
+          columnSums[i] += *p;
+      }
+    }
+
+    /**
+     * @param x The index of the first of four result pixels in the row.
+     * @param yValues The four Y values as 32 bit integers.
+     * @param cb The four Cb values, if not nullptr.
+     * @param cr The four Cr values, if not nullptr.
+     */
+    void read(int x, __m128i& yValues, __m128i* cb, __m128i* cr) const
+    {
+      if(!average)
+      {
+        const __m128i pixels = _mm_setr_epi32(*reinterpret_cast<const int*>(row + xBegins[x] * 4),
+                                              *reinterpret_cast<const int*>(row + xBegins[x + 1] * 4),
+                                              *reinterpret_cast<const int*>(row + xBegins[x + 2] * 4),
+                                              *reinterpret_cast<const int*>(row + xBegins[x + 3] * 4));
+        yValues = _mm_shuffle_epi8(pixels, _mm_setr_epi8(0, -1, -1, -1, 4, -1, -1, -1, 8, -1, -1, -1, 12, -1, -1, -1));
+        if(cb)
+          *cb = _mm_shuffle_epi8(pixels, _mm_setr_epi8(1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1));
+        if(cr)
+          *cr = _mm_shuffle_epi8(pixels, _mm_setr_epi8(3, -1, -1, -1, 7, -1, -1, -1, 11, -1, -1, -1, 15, -1, -1, -1));
+      }
+      else
+      {
+        // the sums of the columns of each result pixel as Y0, Cb, Y1, Cr
+        __m128i sums[4];
+        for(int i = 0; i < 4; ++i)
+        {
+          const __m128i* column = reinterpret_cast<const __m128i*>(columnSums.data()) + xBegins[x + i];
+          const __m128i* columnEnd = reinterpret_cast<const __m128i*>(columnSums.data()) + xEnds[x + i];
+          sums[i] = _mm_loadu_si128(column);
+          while(++column < columnEnd)
+            sums[i] = _mm_add_epi32(sums[i], _mm_loadu_si128(column));
+        }
+        const __m128i y0Cb01 = _mm_unpacklo_epi32(sums[0], sums[1]);
+        const __m128i y0Cb23 = _mm_unpacklo_epi32(sums[2], sums[3]);
+        const __m128i y1Cr01 = _mm_unpackhi_epi32(sums[0], sums[1]);
+        const __m128i y1Cr23 = _mm_unpackhi_epi32(sums[2], sums[3]);
+        const __m128 counts = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(xEnds + x)),
+                                                                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(xBegins + x)))),
+                                         _mm_set1_ps(static_cast<float>(rowCount)));
+        const __m128 factor = _mm_div_ps(_mm_set1_ps(1.f), counts);
+        yValues = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_unpacklo_epi64(y0Cb01, y0Cb23), _mm_unpacklo_epi64(y1Cr01, y1Cr23))),
+                                             _mm_mul_ps(factor, _mm_set1_ps(0.5f))));
+        if(cb)
+          *cb = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi64(y0Cb01, y0Cb23)), factor));
+        if(cr)
+          *cr = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi64(y1Cr01, y1Cr23)), factor));
+      }
+    }
+
+  private:
+    const unsigned char* area;
+    const unsigned char* row = nullptr; /**< The first source row of the current result row. */
+    int rowStep;
+    int sizeX;
+    bool average;
+    int rowCount = 0; /**< The number of source rows averaged for the current result row. */
+    std::vector<int> offsets; /**< The storage of the four arrays below. */
+    int* xBegins;
+    int* xEnds;
+    int* yBegins;
+    int* yEnds;
+    std::vector<int> columnSums; /**< The sums of the channels of each source column over the rows averaged. */
+  };
 }
 
-void Image::copyAndResizeAreaRGBFloat(const int xPos, const int yPos, int sizeX, int sizeY, int sizeXNew, int sizeYNew, float *result) const
+void Image::copyAndResizeAreaFloat(const int xPos, const int yPos, int sizeX, int sizeY, int sizeXNew, int sizeYNew, float *result, bool average) const
 {
-  //ASSERT(result.size() == sizeXNew*sizeYNew);
-  unsigned char* image_ptr = (unsigned char*)image;
   const int rowStep = widthStep * 4;
-  image_ptr += yPos*rowStep + xPos * 4;
-  unsigned char* row_ptr = image_ptr;
-  float xPrecise = 0.f;
-  const float xStep = static_cast<float>(sizeX) / static_cast<float>(sizeXNew);
-  float yPrecise = 0.f;
-  const float yStep = static_cast<float>(sizeY) / static_cast<float>(sizeYNew);
-  int pixelNo = 0;
-  int lastX = 0;
-  int lastY = 0;
+  ResizeReader reader(reinterpret_cast<const unsigned char*>(image) + yPos * rowStep + xPos * 4,
+                            rowStep, sizeX, sizeY, sizeXNew, sizeYNew, average);
+  const __m128 normalize = _mm_set1_ps(1.f / 255.f);
 
-  // precompute x offsets
-  std::vector<int> xIncs(sizeXNew);
-  for (int i = 0; i < sizeXNew; i++)
+  for(int y = 0; y < sizeYNew; ++y)
   {
-    xPrecise += xStep;
-    xIncs[i] = static_cast<int>(xPrecise + 0.5) - lastX;
-    lastX += xIncs[i];
+    reader.beginRow(y);
+    for(int x = 0; x < sizeXNew; x += 4)
+    {
+      __m128i yValues;
+      reader.read(x, yValues, nullptr, nullptr);
+      const __m128 values = _mm_mul_ps(_mm_cvtepi32_ps(yValues), normalize);
+      const int count = std::min(4, sizeXNew - x);
+      if(count == 4)
+        _mm_storeu_ps(result, values);
+      else
+      {
+        alignas(16) float rest[4];
+        _mm_store_ps(rest, values);
+        for(int i = 0; i < count; ++i)
+          result[i] = rest[i];
+      }
+      result += count;
+    }
   }
+}
 
-  unsigned char r, g, b, y, u, v;
-
-  for (int yIndex = 0; yIndex < sizeYNew; yIndex++)
+void Image::copyAndResizeAreaRGBFloat(const int xPos, const int yPos, int sizeX, int sizeY, int sizeXNew, int sizeYNew, float *result, bool average) const
+{
+  const int rowStep = widthStep * 4;
+  ResizeReader reader(reinterpret_cast<const unsigned char*>(image) + yPos * rowStep + xPos * 4,
+                            rowStep, sizeX, sizeY, sizeXNew, sizeYNew, average);
+  const __m128 normalize = _mm_set1_ps(1.f / 255.f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 max = _mm_set1_ps(255.f);
+  const __m128i offset = _mm_set1_epi32(128);
+  // the factors of ColorModelConversions::fromYCbCrToRGB as 32 bit lanes for _mm_madd_epi16
+  const __m128i crToR = _mm_set1_epi32(1436);
+  const __m128i cbToG = _mm_set1_epi32(354);
+  const __m128i crToG = _mm_set1_epi32(732);
+  const __m128i cbToB = _mm_set1_epi32(1814);
+
+  for(int y = 0; y < sizeYNew; ++y)
   {
-    for (int xIndex = 0; xIndex < sizeXNew; xIndex++)
+    reader.beginRow(y);
+    for(int x = 0; x < sizeXNew; x += 4)
     {
-      y = image_ptr[0];
-      u = image_ptr[1];
-      v = image_ptr[3];
-      ColorModelConversions::fromYCbCrToRGB(y, u, v, r, g, b);
-      result[pixelNo++] = r / 255.f;
-      result[pixelNo++] = g / 255.f;
-      result[pixelNo++] = b / 255.f;
-
-      int xInc = xIncs[xIndex];
-      image_ptr += xInc * 4;
+      __m128i yValues, cb, cr;
+      reader.read(x, yValues, &cb, &cr);
+      cb = _mm_sub_epi32(cb, offset);
+      cr = _mm_sub_epi32(cr, offset);
+      const __m128i r = _mm_add_epi32(yValues, _mm_srai_epi32(_mm_madd_epi16(cr, crToR), 10));
+      const __m128i g = _mm_sub_epi32(yValues, _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cb, cbToG), _mm_madd_epi16(cr, crToG)), 10));
+      const __m128i b = _mm_add_epi32(yValues, _mm_srai_epi32(_mm_madd_epi16(cb, cbToB), 10));
+      const __m128 red = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_cvtepi32_ps(r), zero), max), normalize);
+      const __m128 green = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_cvtepi32_ps(g), zero), max), normalize);
+      const __m128 blue = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_cvtepi32_ps(b), zero), max), normalize);
+
+      // interleave to r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3
+      const __m128 rg01 = _mm_unpacklo_ps(red, green);
+      const __m128 rg23 = _mm_unpackhi_ps(red, green);
+      alignas(16) float rgb[12];
+      _mm_store_ps(rgb, _mm_shuffle_ps(rg01, _mm_shuffle_ps(blue, red, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+      _mm_store_ps(rgb + 4, _mm_shuffle_ps(_mm_shuffle_ps(green, blue, _MM_SHUFFLE(1, 1, 1, 1)), rg23, _MM_SHUFFLE(1, 0, 2, 0)));
+      _mm_store_ps(rgb + 8, _mm_shuffle_ps(_mm_shuffle_ps(blue, rg23, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shuffle_ps(rg23, blue, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+      const int count = std::min(4, sizeXNew - x) * 3;
+      if(count == 12)
+      {
+        _mm_storeu_ps(result, _mm_load_ps(rgb));
+        _mm_storeu_ps(result + 4, _mm_load_ps(rgb + 4));
+        _mm_storeu_ps(result + 8, _mm_load_ps(rgb + 8));
+      }
+      else
+        for(int i = 0; i < count; ++i)
+          result[i] = rgb[i];
+      result += count;
     }
-    yPrecise += yStep;
-    int yInc = static_cast<int>(yPrecise + 0.5) - lastY;
-    lastY += yInc;
-    row_ptr += yInc * rowStep;
-    image_ptr = row_ptr;
   }
 }
 
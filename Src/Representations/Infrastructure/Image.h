@@ -7,6 +7,7 @@
 #pragma once
 
 #include "Tools/Streams/Streamable.h"
+#include <memory>
 // TODO: check this warning
 #ifdef __clang__
 #pragma clang diagnostic push
@@ -63,6 +64,7 @@ public:
   bool isFullSize = false; /**< States that the pixels x = [width ... widthStep] should be preserved. */
 
   Pixel* image; /**< The image. Please note that the second half of each row must be ignored. */
+  std::shared_ptr<const unsigned char> sharedBuffer; /**< Keeps the external buffer this image refers to alive, if it is shared. */
 
   /**
    * @param initialize Whether to initialize the image in gray or not
@@ -103,6 +105,26 @@ public:
   void setImage(unsigned char* buffer);
   void setImage(Pixel* image);
 
+  /**
+   * The method sets an external image that is shared with other readers.
+   * The buffer stays valid as long as this image refers to it.
+   * @param buffer The shared image buffer.
+   */
+  void setImage(const std::shared_ptr<const unsigned char>& buffer);
+
+  /**
+   * Refers to the pixels of another image instead of copying them. If the
+   * other image refers to a shared buffer, this image keeps it alive as well.
+   * @param other The image the pixels of which are referenced.
+   */
+  void shareImage(const Image& other);
+
+  /**
+   * If this image refers to a shared buffer, its pixels are copied into a
+   * buffer of its own and the shared buffer is dropped. Otherwise nothing happens.
+   */
+  void unshare();
+
   /**
    * @brief Copies over an Image via SSE.
    * @param [in] other The image to be copied.
@@ -162,8 +184,27 @@ public:
   bool projectIntoImage(int &x, int &y, int sizeX, int sizeY) const;
 
   void copyAndResizeArea(const int xPos, const int yPos, int sizeX, int sizeY, int sizeXNew, int sizeYNew, std::vector<unsigned char> &result) const;
-  void copyAndResizeAreaFloat(const int xPos, const int yPos, int sizeX, int sizeY, int sizeXNew, int sizeYNew, float *result) const;
-  void copyAndResizeAreaRGBFloat(const int xPos, const int yPos, int sizeX, int sizeY, int sizeXNew, int sizeYNew, float *result) const;
+
+  /**
+   * Resizes an area of the Y channel to floats in [0, 1].
+   * @param xPos The left border of the area.
+   * @param yPos The upper border of the area.
+   * @param sizeX The width of the area.
+   * @param sizeY The height of the area.
+   * @param sizeXNew The width of the result.
+   * @param sizeYNew The height of the result.
+   * @param result sizeXNew * sizeYNew floats.
+   * @param average Average the area of each result pixel instead of picking its nearest neighbor?
+   */
+  void copyAndResizeAreaFloat(const int xPos, const int yPos, int sizeX, int sizeY, int sizeXNew, int sizeYNew, float *result, bool average = false) const;
+
+  /**
+   * Resizes an area of the image to RGB floats in [0, 1] in HWC layout.
+   * The parameters are the same as for copyAndResizeAreaFloat, but result
+   * must hold sizeXNew * sizeYNew * 3 floats.
+   */
+  void copyAndResizeAreaRGBFloat(const int xPos, const int yPos, int sizeX, int sizeY, int sizeXNew, int sizeYNew, float *result, bool average = false) const;
+
   void copyAndResizeAreaRGBFloatZeroPadding(const int xPos, const int yPos, int sizeX, int sizeY, int sizeXNew, int sizeYNew, float *result) const;
 protected:
   void serialize(In* in, Out* out);
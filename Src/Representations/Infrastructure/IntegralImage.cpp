@@ -1,153 +1,85 @@
 #include "IntegralImage.h"
+#include <emmintrin.h>
 
-void IntegralImage::createIntegralImage(const Image &source)
+namespace
 {
-  const int factor = source.width / width;
-  const int stepWidth = 4 * factor;
-  const int rowStep = 4 * source.width * factor * 2 - 4 * source.width;
-  //const int fieldColorY = theFieldColorsUpper.fieldColorArray[0].fieldColorOptY;
-  unsigned char* image_ptr = (unsigned char*)source.image;
-  unsigned row = 0;
-  unsigned column = 0;
-  int index = 0;
-  int indexLastRow = (height - 2) * width;
-  for (unsigned x = 0; x < width; x++)
-    ySum[indexLastRow + x] = 0;
-  unsigned lastYSum = 0;
-  unsigned lastIISum = 0;
-  for (; row < height; row++)
+  /** Emphasizes values darker than the gray value, i.e. differences below it count twice. */
+  inline unsigned diffFromGray(const int imageValue, const int grayValue)
   {
-    for (; column < width; column++)
-    {
-      /*int imageValue = *image_ptr;
-      int diffFromGray = imageValue - theFieldColorsUpper.fieldColorArray[0].fieldColorOptY;
-      int diffFromGrayAbs = std::abs(diffFromGray);
-      imageValue = diffFromGrayAbs + (diffFromGrayAbs / 2) * -(sgn(diffFromGray) - 1);*/
-
-      lastYSum = ySum[indexLastRow + column];
-      ySum[index] = (lastYSum + *image_ptr);
-      image[index] = lastIISum + ySum[index];
-      lastIISum = image[index];
-      index++;
-      image_ptr += stepWidth;
-    }
-    lastIISum = 0;
-    column = 0;
-    indexLastRow = width * row;
-    image_ptr += rowStep;
+    const int diffFromGray = imageValue - grayValue;
+    const int diffFromGrayAbs = std::abs(diffFromGray);
+    return diffFromGrayAbs + (diffFromGrayAbs / 2) * -(sgn(diffFromGray) - 1);
   }
 }
 
-void IntegralImage::createIntegralImageDiffFromGray(const Image &source, const unsigned grayValue)
+void IntegralImage::createIntegralImage(const Image &source)
 {
   const int factor = source.width / width;
-  const int stepWidth = 4 * factor;
-  const int rowStep = 4 * source.width * factor * 2 - 4 * source.width;
-  //const int fieldColorY = theFieldColorsUpper.fieldColorArray[0].fieldColorOptY;
-  unsigned char* image_ptr = (unsigned char*)source.image;
-  unsigned row = 0;
-  unsigned column = 0;
-  int index = 0;
-  int indexLastRow = (height - 2) * width;
-  for (unsigned x = 0; x < width; x++)
-    ySum[indexLastRow + x] = 0;
-  unsigned lastYSum = 0;
-  unsigned lastIISum = 0;
-  for (; row < height; row++)
-  {
-    for (; column < width; column++)
-    {
-      int imageValue = *image_ptr;
-      int diffFromGray = imageValue - grayValue;
-      int diffFromGrayAbs = std::abs(diffFromGray);
-      imageValue = diffFromGrayAbs + (diffFromGrayAbs / 2) * -(sgn(diffFromGray) - 1);
+  create(reinterpret_cast<const unsigned char*>(source.image), 4 * factor, 4 * source.width * factor * 2 - 4 * source.width,
+         [](unsigned char value) -> unsigned {return value;});
+}
 
-      lastYSum = ySum[indexLastRow + column];
-      ySum[index] = (lastYSum + imageValue);
-      image[index] = lastIISum + ySum[index];
-      lastIISum = image[index];
-      index++;
-      image_ptr += stepWidth;
-    }
-    lastIISum = 0;
-    column = 0;
-    indexLastRow = width * row;
-    image_ptr += rowStep;
-  }
+void IntegralImage::createIntegralImageDiffFromGray(const Image &source, const unsigned grayValue)
+{
+  const int factor = source.width / width;
+  create(reinterpret_cast<const unsigned char*>(source.image), 4 * factor, 4 * source.width * factor * 2 - 4 * source.width,
+         [grayValue](unsigned char value) {return diffFromGray(value, grayValue);});
 }
 
 void IntegralImage::createIntegralImageSobel(const SobelImage &source)
 {
   const int factor = source.width / width;
-  const int stepWidth = factor;
-  const int rowStep = source.width * factor - source.width;
-  //const int fieldColorY = theFieldColorsUpper.fieldColorArray[0].fieldColorOptY;
-  unsigned const char* image_ptr = source.magnitude.data();
-  unsigned row = 0;
-  unsigned column = 0;
-  int index = 0;
-  int indexLastRow = (height - 2) * width;
-  for (unsigned x = 0; x < width; x++)
-    ySum[indexLastRow + x] = 0;
-  unsigned lastYSum = 0;
-  unsigned lastIISum = 0;
-  for (; row < height; row++)
-  {
-    for (; column < width; column++)
-    {
-      /*int imageValue = *image_ptr;
-      int diffFromGray = imageValue - theFieldColorsUpper.fieldColorArray[0].fieldColorOptY;
-      int diffFromGrayAbs = std::abs(diffFromGray);
-      imageValue = diffFromGrayAbs + (diffFromGrayAbs / 2) * -(sgn(diffFromGray) - 1);*/
-
-      lastYSum = ySum[indexLastRow + column];
-      ySum[index] = (lastYSum + *image_ptr);
-      image[index] = lastIISum + ySum[index];
-      lastIISum = image[index];
-      index++;
-      image_ptr += stepWidth;
-    }
-    lastIISum = 0;
-    column = 0;
-    indexLastRow = width * row;
-    image_ptr += rowStep;
-  }
+  create(source.magnitude.data(), factor, source.width * factor - source.width,
+         [](unsigned char value) -> unsigned {return value;});
 }
 
 void IntegralImage::createIntegralImageDiffFromGraySobel(const SobelImage &source, const unsigned grayValue)
 {
   const int factor = source.width / width;
-  const int stepWidth = factor;
-  const int rowStep = source.width * factor - source.width;
-  //const int fieldColorY = theFieldColorsUpper.fieldColorArray[0].fieldColorOptY;
-  unsigned const char* image_ptr = source.magnitude.data();
-  unsigned row = 0;
-  unsigned column = 0;
-  int index = 0;
-  int indexLastRow = (height - 2) * width;
-  for (unsigned x = 0; x < width; x++)
-    ySum[indexLastRow + x] = 0;
-  unsigned lastYSum = 0;
-  unsigned lastIISum = 0;
-  for (; row < height; row++)
+  create(source.magnitude.data(), factor, source.width * factor - source.width,
+         [grayValue](unsigned char value) {return diffFromGray(value, grayValue);});
+}
+
+template<typename Transform> void IntegralImage::create(const unsigned char* source, int stepWidth, int rowStep, Transform transform)
+{
+  row.resize(width);
+  for(unsigned y = 0; y < height; y++)
   {
-    for (; column < width; column++)
-    {
-      int imageValue = *image_ptr;
-      int diffFromGray = imageValue - grayValue;
-      int diffFromGrayAbs = std::abs(diffFromGray);
-      imageValue = diffFromGrayAbs + (diffFromGrayAbs / 2) * -(sgn(diffFromGray) - 1);
+    for(unsigned x = 0; x < width; x++, source += stepWidth)
+      row[x] = transform(*source);
+    source += rowStep;
+    accumulateRow(y);
+  }
+}
+
+void IntegralImage::accumulateRow(unsigned y)
+{
+  const unsigned* values = row.data();
+  const unsigned* lastYSum = y ? ySum.data() + (y - 1) * width : nullptr;
+  unsigned* currentYSum = ySum.data() + y * width;
+  unsigned* integral = image.data() + y * width;
+  unsigned x = 0;
 
-      lastYSum = ySum[indexLastRow + column];
-      ySum[index] = (lastYSum + imageValue);
-      image[index] = lastIISum + ySum[index];
-      lastIISum = image[index];
-      index++;
-      image_ptr += stepWidth;
-    }
-    lastIISum = 0;
-    column = 0;
-    indexLastRow = width * row;
-    image_ptr += rowStep;
+  // Column sums are a vertical addition. The row sums are a prefix sum within
+  // four lanes plus the carry of all lanes to the left.
+  __m128i carry = _mm_setzero_si128();
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + x));
+    if(lastYSum)
+      sum = _mm_add_epi32(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(lastYSum + x)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(currentYSum + x), sum);
+    sum = _mm_add_epi32(sum, _mm_slli_si128(sum, 4));
+    sum = _mm_add_epi32(sum, _mm_slli_si128(sum, 8));
+    sum = _mm_add_epi32(sum, carry);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(integral + x), sum);
+    carry = _mm_shuffle_epi32(sum, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  unsigned lastIISum = static_cast<unsigned>(_mm_cvtsi128_si32(carry));
+  for(; x < width; x++)
+  {
+    currentYSum[x] = values[x] + (lastYSum ? lastYSum[x] : 0);
+    lastIISum += currentYSum[x];
+    integral[x] = lastIISum;
   }
 }
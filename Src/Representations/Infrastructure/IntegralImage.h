@@ -20,20 +20,36 @@ STREAMABLE(IntegralImage,
   void init(const int w = 320, const int h = 240)
   {
     width = w; height = h;
-    image.reserve(width * height);
-    ySum.reserve(width * height);
-    for (unsigned int x = 0; x < width; x++)
-      for (unsigned int y = 0; y < height; y++)
-      {
-        ySum.push_back(0);
-        image.push_back(0);
-      }
+    image.assign(width * height, 0);
+    ySum.assign(width * height, 0);
+    row.resize(width);
   }
   int getPixelAt(const int x, const int y) const { return (int)image[y * width + x]; }
   void createIntegralImage(const Image &source);
   void createIntegralImageDiffFromGray(const Image &source, const unsigned grayValue);
   void createIntegralImageSobel(const SobelImage &source);
   void createIntegralImageDiffFromGraySobel(const SobelImage &source, const unsigned grayValue);
+
+private:
+  std::vector<unsigned> row; /**< The values of the row currently accumulated. */
+
+  /**
+   * Creates the integral image from every stepWidth-th byte of the source.
+   * @param source The first value.
+   * @param stepWidth The distance between two values of a row in bytes.
+   * @param rowStep The bytes skipped at the end of each row.
+   * @param transform Maps a source value to the value that is summed up.
+   */
+  template<typename Transform> void create(const unsigned char* source, int stepWidth, int rowStep, Transform transform);
+
+  /**
+   * Accumulates the values in row and writes the column sums and the
+   * integral image of that row using SSE.
+   * @param y The row.
+   */
+  void accumulateRow(unsigned y);
+
+public:
   ,
   (unsigned) width,
   (unsigned) height,
@@ -7,7 +7,6 @@
 #include "Platform/BHAssert.h"
 #include "JPEGImage.h"
 #include "Tools/SIMD.h"
-#include "Platform/SystemCall.h"
 #include <cstddef>
 
 JPEGImage::JPEGImage(const Image& image)
@@ -17,20 +16,19 @@ JPEGImage::JPEGImage(const Image& image)
 
 JPEGImage& JPEGImage::operator=(const Image& src)
 {
-  setResolution(src.width, src.height, src.isFullSize);
-  timeStamp = src.timeStamp;
-
-  unsigned char* aiboAlignedImage = nullptr;
-  if(!isFullSize)
-  {
-    aiboAlignedImage = (unsigned char*)SystemCall::alignedMalloc(width * height * 3, 16);
-    toAiboAlignment((const unsigned char*)src[0], aiboAlignedImage);
-  }
-
   jpeg_compress_struct cInfo;
   jpeg_error_mgr jem;
   cInfo.err = jpeg_std_error(&jem);
   jpeg_create_compress(&cInfo);
+  compress(src, 75, cInfo);
+  jpeg_destroy_compress(&cInfo);
+  return *this;
+}
+
+void JPEGImage::compress(const Image& src, int quality, jpeg_compress_struct& cInfo)
+{
+  setResolution(src.width, src.height, src.isFullSize);
+  timeStamp = src.timeStamp;
 
   if(!cInfo.dest)
     cInfo.dest = (jpeg_destination_mgr*)
@@ -48,23 +46,28 @@ JPEGImage& JPEGImage::operator=(const Image& src)
   cInfo.jpeg_color_space = JCS_GRAYSCALE;
   jpeg_set_defaults(&cInfo);
   cInfo.dct_method = JDCT_FASTEST;
-  jpeg_set_quality(&cInfo, 75, true);
+  jpeg_set_quality(&cInfo, quality, true);
 
   jpeg_start_compress(&cInfo, true);
 
+  // rows are converted one at a time, so there is no copy of the whole image
+  alignas(16) unsigned char aiboAlignedRow[maxResolutionWidth * 3];
+  ASSERT(isFullSize || width <= maxResolutionWidth);
   while(cInfo.next_scanline < cInfo.image_height)
   {
-    JSAMPROW rowPointer = const_cast<JSAMPROW>(isFullSize ? (unsigned char*)src[cInfo.next_scanline] : &aiboAlignedImage[cInfo.next_scanline * cInfo.image_width]);
+    JSAMPROW rowPointer;
+    if(isFullSize)
+      rowPointer = const_cast<JSAMPROW>((const unsigned char*)src[cInfo.next_scanline]);
+    else
+    {
+      toAiboAlignment((const unsigned char*)src[cInfo.next_scanline], aiboAlignedRow);
+      rowPointer = aiboAlignedRow;
+    }
     jpeg_write_scanlines(&cInfo, &rowPointer, 1);
   }
 
   jpeg_finish_compress(&cInfo);
   size = unsigned((char unsigned*)cInfo.dest->next_output_byte - (unsigned char*)(*this)[0]);
-  jpeg_destroy_compress(&cInfo);
-  if(!isFullSize)
-    SystemCall::alignedFree(aiboAlignedImage);
-
-  return *this;
 }
 
 void JPEGImage::toImage(Image& dest) const
@@ -171,32 +174,29 @@ void JPEGImage::toAiboAlignment(const unsigned char* src, unsigned char* dst) co
   __m128i mLowCr;
   __m128i mHighCr;
 
-  for(int y = 0; y < height; ++y)
+  pSrc = (const __m128i*)src;
+  pSrcLineEnd = (const __m128i*)(src + width * 4);
+  pDst = (__m128i*)dst;
+  for(; pSrc < pSrcLineEnd; pSrc += 4, ++pDst)
   {
-    pSrc = (__m128i*)(src + y * widthStep * 4);
-    pSrcLineEnd = (__m128i*)(src + y * widthStep * 4 + (width * 4));
-    pDst = (__m128i*)(dst + y * width * 3);
-    for(; pSrc < pSrcLineEnd; pSrc += 4, ++pDst)
-    {
-      p0 = _mm_loadu_si128(pSrc);     // yPadd1 cb1 y1 cr1 yPadd2 cb2 y2 cr2 yPadd3 cb3 y3 cr3 yPadd4 cb4 y4 cr4
-      p1 = _mm_loadu_si128(pSrc + 1); // yPadd5 cb5 y5 cr5 yPadd6 cb6 y6 cr6 yPadd7 cb7 y7 cr7 yPadd8 cb8 y8 cr8
-      p2 = _mm_loadu_si128(pSrc + 2); // yPadd9 cb9 y9 cr9 yPadd10 cb10 y10 cr10 yPadd11 cb11 y11 cr11 yPadd12 cb12 y12 cr12
-      p3 = _mm_loadu_si128(pSrc + 3); // yPadd13 cb13 y13 cr13 yPadd14 cb14 y14 cr14 yPadd15 cb15 y15 cr15 yPadd16 cb16 y16 cr16
-
-      p0 = SHUFFLE(p0, mMask); // cb1 cb2 cb3 cb4 y1 y2 y3 y4 cr1 cr2 cr3 cr4 0 0 0 0
-      p1 = SHUFFLE(p1, mMask); // cb5 cb6 cb7 cb8 y5 y6 y7 y8 cr5 cr6 cr7 cr8 0 0 0 0
-      p2 = SHUFFLE(p2, mMask); // cb9 cb10 cb11 cb12 y9 y10 y11 y12 cr9 cr10 cr11 cr12 0 0 0 0
-      p3 = SHUFFLE(p3, mMask); // cb13 cb14 cb15 cb16 y13 y14 y15 y16 cr13 cr14 cr15 cr16 0 0 0 0
-
-      mLowCbY = _mm_unpacklo_epi32(p0, p1);  // cb1 cb2 cb3 cb4 cb5 cb6 cb7 cb8 y1 y2 y3 y4 y5 y6 y7 y8
-      mHighCbY = _mm_unpacklo_epi32(p2, p3); // cb9 cb10 cb11 cb12 cb13 cb14 cb15 cb16 y9 y10 y11 y12 y13 y14 y15 y16
-      mLowCr = _mm_unpackhi_epi32(p0, p1);   // cr1 cr2 cr3 cr4 cr5 cr6 cr7 cr8 0 0 0 0 0 0 0 0
-      mHighCr = _mm_unpackhi_epi32(p2, p3);  // cr9 cr10 cr11 cr12 cr13 cr14 cr15 cr16 0 0 0 0 0 0 0 0
-
-      pDst[0] = _mm_unpacklo_epi64(mLowCbY, mHighCbY);
-      pDst[width / 16] = _mm_unpackhi_epi64(mLowCbY, mHighCbY);
-      pDst[width / 8] = _mm_unpacklo_epi64(mLowCr, mHighCr);
-    }
+    p0 = _mm_loadu_si128(pSrc);     // yPadd1 cb1 y1 cr1 yPadd2 cb2 y2 cr2 yPadd3 cb3 y3 cr3 yPadd4 cb4 y4 cr4
+    p1 = _mm_loadu_si128(pSrc + 1); // yPadd5 cb5 y5 cr5 yPadd6 cb6 y6 cr6 yPadd7 cb7 y7 cr7 yPadd8 cb8 y8 cr8
+    p2 = _mm_loadu_si128(pSrc + 2); // yPadd9 cb9 y9 cr9 yPadd10 cb10 y10 cr10 yPadd11 cb11 y11 cr11 yPadd12 cb12 y12 cr12
+    p3 = _mm_loadu_si128(pSrc + 3); // yPadd13 cb13 y13 cr13 yPadd14 cb14 y14 cr14 yPadd15 cb15 y15 cr15 yPadd16 cb16 y16 cr16
+
+    p0 = SHUFFLE(p0, mMask); // cb1 cb2 cb3 cb4 y1 y2 y3 y4 cr1 cr2 cr3 cr4 0 0 0 0
+    p1 = SHUFFLE(p1, mMask); // cb5 cb6 cb7 cb8 y5 y6 y7 y8 cr5 cr6 cr7 cr8 0 0 0 0
+    p2 = SHUFFLE(p2, mMask); // cb9 cb10 cb11 cb12 y9 y10 y11 y12 cr9 cr10 cr11 cr12 0 0 0 0
+    p3 = SHUFFLE(p3, mMask); // cb13 cb14 cb15 cb16 y13 y14 y15 y16 cr13 cr14 cr15 cr16 0 0 0 0
+
+    mLowCbY = _mm_unpacklo_epi32(p0, p1);  // cb1 cb2 cb3 cb4 cb5 cb6 cb7 cb8 y1 y2 y3 y4 y5 y6 y7 y8
+    mHighCbY = _mm_unpacklo_epi32(p2, p3); // cb9 cb10 cb11 cb12 cb13 cb14 cb15 cb16 y9 y10 y11 y12 y13 y14 y15 y16
+    mLowCr = _mm_unpackhi_epi32(p0, p1);   // cr1 cr2 cr3 cr4 cr5 cr6 cr7 cr8 0 0 0 0 0 0 0 0
+    mHighCr = _mm_unpackhi_epi32(p2, p3);  // cr9 cr10 cr11 cr12 cr13 cr14 cr15 cr16 0 0 0 0 0 0 0 0
+
+    pDst[0] = _mm_unpacklo_epi64(mLowCbY, mHighCbY);
+    pDst[width / 16] = _mm_unpackhi_epi64(mLowCbY, mHighCbY);
+    pDst[width / 8] = _mm_unpacklo_epi64(mLowCr, mHighCr);
   }
 }
 
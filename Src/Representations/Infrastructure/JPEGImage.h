@@ -57,6 +57,14 @@ public:
    */
   JPEGImage& operator=(const Image& src);
 
+  /**
+   * Compresses an image reusing the state of a compressor.
+   * @param src The image to compress.
+   * @param quality The JPEG quality (0 .. 100).
+   * @param cInfo A compressor created with jpeg_create_compress. Its error manager must be set.
+   */
+  void compress(const Image& src, int quality, jpeg_compress_struct& cInfo);
+
   /**
    * Uncompress image.
    * @param dest Will receive the uncompressed image.
@@ -75,10 +83,10 @@ private:
   //!@}
 
   /**
-   * Convert image from Nao's alignment (YUV422) to Aibo's alignment (one channel per line)
-   * destination is asserted to be allocated
-   * @param src Pointer to the source image in Nao's alignment
-   * @param dst Pointer to the destination image
+   * Convert a row from Nao's alignment (YUV422) to Aibo's alignment (one channel per line)
+   * destination is asserted to be allocated and 16 byte aligned
+   * @param src Pointer to the source row in Nao's alignment
+   * @param dst Pointer to the destination row (width * 3 bytes)
    */
   void toAiboAlignment(const unsigned char* src, unsigned char* dst) const;
 
@@ -99,6 +99,7 @@ public:
   std::vector<PoseHypothesis> poseHypothesis; /**< Possible poses in absolute field coordinates (for unique poses, i.e. at least one crossing). */
   std::vector<PoseHypothesisInterval> poseHypothesisIntervals; /**< Possible poses in absolute field coordinates (for pose intervals, i.e. only two parallel lines). */
   bool onlyObservedOneFieldLine;
+  unsigned timestamp = 0; /**< The frame time this result was computed in. It is older if the LineMatcher was skipped. */
 private:
   std::vector<FieldLine> observationsSphericalCoords;
 
@@ -127,6 +128,7 @@ public:
       STREAM(poseHypothesis);
       STREAM(poseHypothesisIntervals);
       STREAM(onlyObservedOneFieldLine);
+      STREAM(timestamp);
     STREAM_REGISTER_FINISH;
   }
 
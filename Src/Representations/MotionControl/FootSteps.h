@@ -6,7 +6,8 @@
 #define _FOOTSTEPS_H
 
 #include "Modules/MotionControl/DortmundWalkingEngine/StepData.h"
-#include <vector>
+#include "Representations/MotionControl/FLIPMParams.h"
+#include "Tools/RingBuffer.h"
 #include "Platform/BHAssert.h"
 
 #ifndef WALKING_SIMULATOR
@@ -15,8 +16,8 @@
 #include "bhumanstub.h"
 #endif
 
-/** Maximum number of possible foot steps in buffer */
-#define MAX_STEPS	300
+/** Maximum number of possible foot steps in buffer. Custom steps can extend the preview beyond PREVIEW_LENGTH. */
+#define MAX_STEPS	(3 * PREVIEW_LENGTH)
 
 /**
  * @class Robot
@@ -56,7 +57,7 @@ public :
 	};
 
 	/** Constructor */
-	FootSteps() : steps(MAX_STEPS)
+	FootSteps()
 	{
 		running=false;
 		emergencyStop=false;
@@ -84,33 +85,47 @@ public :
     return steps.empty();
   }
 
-	void addStep(Footposition newstep)
+	void addStep(const Footposition& newstep)
 	{
-		steps.push_back(newstep);
+    ASSERT(!steps.full());
+		steps.push_front(newstep);
 	}
 
-	Footposition getStep(unsigned int i) const
+  /**
+   * Access to a step in the buffer.
+   * @param i The index of the step. Step 0 is the oldest one.
+   */
+	const Footposition& getStep(unsigned int i) const
 	{
-    ASSERT(!steps.empty());
-		return steps[i];
+    ASSERT(i < steps.size());
+		return steps[steps.size() - 1 - i];
 	}
 
-  void popStep()
+	Footposition& getStep(unsigned int i)
+	{
+    ASSERT(i < steps.size());
+		return steps[steps.size() - 1 - i];
+	}
+
+  /** Removes the oldest step. */
+  void popFront()
   {
     steps.pop_back();
   }
 
-  void popFront()
+  /** Removes all steps. */
+  void clear()
   {
-    steps.erase(steps.begin());
+    steps.clear();
   }
 
+private:
 	/** 
 	 *	Buffer for target foot steps. There might be more than one step
 	 *	per frame to fill the preview buffer needed by the preview controller
-	 *	ZMP/IP-Controller 
+	 *	ZMP/IP-Controller. The buffer is allocated once, so adding and removing
+	 *	steps does not touch the heap.
 	 */
-
-	std::vector<Footposition> steps;
+	RingBuffer<Footposition, MAX_STEPS> steps;
 };
 #endif
@@ -0,0 +1,75 @@
+/**
+ * @file Tools/Debugging/AllocationCounter.cpp
+ *
+ * Replaces the global operators new and delete by versions that count the
+ * allocations per thread.
+ */
+
+#include "AllocationCounter.h"
+
+#ifndef NDEBUG
+
+#include "Platform/SystemCall.h"
+#include <cstdlib>
+#include <new>
+
+static PROCESS_LOCAL unsigned allocations = 0;
+
+unsigned AllocationCounter::getCount()
+{
+  return allocations;
+}
+
+static void* allocate(std::size_t size)
+{
+  ++allocations;
+  return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size)
+{
+  void* p = allocate(size);
+  if(!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](std::size_t size)
+{
+  void* p = allocate(size);
+  if(!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) throw()
+{
+  return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) throw()
+{
+  return allocate(size);
+}
+
+void operator delete(void* p) throw()
+{
+  std::free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+  std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw()
+{
+  std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw()
+{
+  std::free(p);
+}
+
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @file Tools/Debugging/AllocationCounter.h
+ *
+ * Counts the heap allocations of the calling thread. This allows checking
+ * that real-time code does not allocate memory. The global operators new
+ * are only replaced if NDEBUG is not defined. Otherwise, the count is
+ * always 0.
+ *
+ * Usage:
+ *   const unsigned allocations = AllocationCounter::getCount();
+ *   ...
+ *   PLOT("module:Module:allocations", AllocationCounter::getCount() - allocations);
+ */
+
+#pragma once
+
+namespace AllocationCounter
+{
+  /**
+   * Returns the number of allocations done with operator new by the calling
+   * thread so far. The value may wrap around, but differences stay valid.
+   */
+#ifndef NDEBUG
+  unsigned getCount();
+#else
+  inline unsigned getCount() {return 0;}
+#endif
+}
@@ -19,10 +19,12 @@
  * ANNOTATION("Behavior", "Kickin'!");
  * ANNOTATION("TacticProvider", "Changed Tactic from " << oldTactic << " to " << newTactic << ".");
  * </pre>
+ * Providers executed in parallel share the annotation manager, so it is locked.
  */
 #define ANNOTATION(name, message) \
   do \
   { \
+    SYNC_WITH(Global::getAnnotationManager()); \
     Global::getAnnotationManager().addAnnotation(); \
     Global::getAnnotationManager().getOut().out.text << name << message; \
     Global::getAnnotationManager().getOut().out.finishMessage(idAnnotation); \
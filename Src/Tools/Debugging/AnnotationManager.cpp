@@ -20,9 +20,9 @@ AnnotationManager::AnnotationManager() : lastGameState(STATE_INITIAL)
 
 void AnnotationManager::signalProcessStart()
 {
-  if(Blackboard::getInstance().exists("GameInfo"))
+  if(Blackboard::getInstance().exists(idGameInfo))
   {
-    const GameInfo& gameInfo = static_cast<const GameInfo&>(Blackboard::getInstance()["GameInfo"]);
+    const GameInfo& gameInfo = static_cast<const GameInfo&>(Blackboard::getInstance()[idGameInfo]);
     if(gameInfo.state == STATE_READY || gameInfo.state == STATE_SET || gameInfo.state == STATE_PLAYING)
       ++currentFrame;
 
@@ -44,9 +44,9 @@ void AnnotationManager::clear()
   }
   else
   {
-    if(Blackboard::getInstance().exists("GameInfo"))
+    if(Blackboard::getInstance().exists(idGameInfo))
     {
-      const GameInfo& gameInfo = static_cast<const GameInfo&>(Blackboard::getInstance()["GameInfo"]);
+      const GameInfo& gameInfo = static_cast<const GameInfo&>(Blackboard::getInstance()[idGameInfo]);
       if(gameInfo.state == STATE_READY || gameInfo.state == STATE_SET || gameInfo.state == STATE_PLAYING)
         outData.clear();
     }
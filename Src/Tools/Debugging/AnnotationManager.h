@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "Platform/Thread.h"
 #include "Tools/MessageQueue/MessageQueue.h"
 
 #include <vector>
@@ -19,10 +20,13 @@ private:
   unsigned lastGameState;
 
   friend class Process;
+  friend class LogReplay;
 
   AnnotationManager(); // private so only Process can access it.
 
 public:
+  DECLARE_SYNC; /**< Locked by the macro ANNOTATION. */
+
   void signalProcessStart();
   void clear();
 
@@ -30,6 +30,7 @@ private:
 
   friend class Process; /**< A process is allowed to create the instance. */
   friend class Framework; /**< A framework is allowed to create the instance. */
+  friend class LogReplay; /**< The log replay is allowed to create the instance. */
 
   /**
    * No other instance of this class is allowed except the one accessible via getDebugDataTable
@@ -67,6 +67,7 @@ private:
   friend class Process;
   friend class RobotConsole;
   friend class DrawingManager3D;
+  friend class LogReplay;
   friend class Framework;
   friend In& operator>>(In& stream, DrawingManager&);
   friend Out& operator<<(Out& stream, const DrawingManager&);
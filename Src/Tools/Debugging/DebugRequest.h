@@ -70,6 +70,7 @@ public:
 private:
   friend class Process;
   friend class RobotConsole;
+  friend class LogReplay;
 
   /**
    * Default constructor.
@@ -21,16 +21,23 @@ inline void _plot(const char* id, unsigned time)
   DEBUG_RESPONSE(id) OUTPUT(idPlot, bin, (id + 5) << static_cast<float>(time) * 0.001f);
 }
 
+/**
+ * Determines the id of a stop watch only once.
+ * @param eventID The name of the stop watch. It must be a string literal.
+ */
+#define _STOPWATCH_ID(eventID) \
+  [] {static const unsigned short _id = TimingManager::getWatchId(eventID); return _id;}()
+
 /**
  * Allows the measurement the execution time of the following block.
  * @param eventID The id of the stop watch.
  */
 #define STOPWATCH(eventID) \
-  for(bool _start = true; (_start ? Global::getTimingManager().startTiming(eventID) : (void) Global::getTimingManager().stopTiming(eventID)), _start; _start ^= true)
+  for(unsigned short _watchId = _STOPWATCH_ID(eventID), _start = 1; (_start ? Global::getTimingManager().startTiming(_watchId) : (void) Global::getTimingManager().stopTiming(_watchId)), _start; _start = 0)
 
 /**
  * Allows the measurement the execution time of the following block and plot the measurements.
  * @param eventID The id of the stop watch.
  */
 #define STOPWATCH_WITH_PLOT(eventID) \
-  for(bool _start = true; (_start ? Global::getTimingManager().startTiming(eventID) : _plot("plot:stopwatch:" eventID, Global::getTimingManager().stopTiming(eventID))), _start; _start ^= true)
+  for(unsigned short _watchId = _STOPWATCH_ID(eventID), _start = 1; (_start ? Global::getTimingManager().startTiming(_watchId) : _plot("plot:stopwatch:" eventID, Global::getTimingManager().stopTiming(_watchId))), _start; _start = 0)
@@ -6,42 +6,176 @@
  */
 
 #include "TimingManager.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define TIMING_USE_TSC
+#elif defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#define TIMING_USE_TSC
+#endif
 #include "Platform/BHAssert.h"
 #include "Platform/SystemCall.h"
+#include "Platform/Thread.h"
 #include "Debugging.h"
 #include "Tools/MessageQueue/MessageQueue.h"
 
 using namespace std;
 
-struct TimingManager::Pimpl
+namespace
 {
+  const unsigned short maxNumOfWatches = 1024; /**< The maximum number of stopwatch ids. */
+  const unsigned short stopFlag = 0x8000; /**< Marks events that stop a stopwatch. */
+
   /**
-   * NOTE: the hashmaps only work because the compiler uses a string table and
-   *       allocates only one address for all const string literals with the same value.
-   *       If this ever changes you have to replace the key with std::string
+   * Reads the time stamp counter, which is much cheaper than a system call.
+   * On other architectures, the steady clock is used instead.
+   * @return The time in ticks.
    */
+  inline unsigned long long readTicks()
+  {
+#ifdef TIMING_USE_TSC
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
 
   /**
-   * Key: name of the timer
-   * value: If timer has been started but not stopped, yet: the start time.
-   *        Else: the time between start and stop.
+   * Converts ticks into ns. The rate of the time stamp counter is calibrated
+   * against the steady clock. The calibration is refined at the beginning of
+   * every frame, because it becomes more precise the longer it runs.
    */
-  unordered_map<const char*, unsigned long long> timing;
-  unordered_map<const char*, unsigned short> idTable; /**< Key: name of the stopwatch. Value: the id that is used when sending timing data over the network */
+  class Clock
+  {
+  private:
+    unsigned long long startTicks;
+    chrono::steady_clock::time_point startTime;
+    atomic<double> nanosecondsPerTick;
+
+  public:
+    Clock() :
+      startTicks(readTicks()),
+      startTime(chrono::steady_clock::now()),
+      nanosecondsPerTick(1.0)
+    {
+#ifdef TIMING_USE_TSC
+      // A first estimate is required before the first stopwatch is stopped.
+      while(chrono::steady_clock::now() - startTime < chrono::milliseconds(2));
+      calibrate();
+#endif
+    }
+
+    void calibrate()
+    {
+#ifdef TIMING_USE_TSC
+      const unsigned long long ticks = readTicks();
+      const chrono::duration<double, nano> time = chrono::steady_clock::now() - startTime;
+      if(ticks > startTicks)
+        nanosecondsPerTick.store(time.count() / static_cast<double>(ticks - startTicks), memory_order_relaxed);
+#endif
+    }
+
+    double getNanosecondsPerTick() const {return nanosecondsPerTick.load(memory_order_relaxed);}
+
+    unsigned long long toNanoseconds(unsigned long long ticks) const
+    {
+      return static_cast<unsigned long long>(static_cast<double>(ticks - startTicks) * getNanosecondsPerTick());
+    }
+  };
+
+  Clock& getClock()
+  {
+    static Clock clock;
+    return clock;
+  }
+
+  /** The names of all stopwatches of all processes. The index is the id. */
+  struct WatchRegistry
+  {
+    unordered_map<string, unsigned short> ids;
+    deque<string> names; /**< A deque, because the names must not move. */
+    DECLARE_SYNC;
+  };
+
+  WatchRegistry& getWatchRegistry()
+  {
+    static WatchRegistry registry;
+    return registry;
+  }
+
+  atomic<unsigned> numOfInstances(0); /**< Distinguishes timing managers that were created at the same address. */
+}
+
+/**
+ * The starts and stops of stopwatches in a single thread. Only that thread writes
+ * to the buffer and only the thread of the process reads from it. If the
+ * process does not read the events fast enough, the oldest ones are overwritten.
+ */
+struct TimingManager::EventBuffer
+{
+  struct Event
+  {
+    unsigned long long ticks;
+    unsigned short id; /**< The id of the stopwatch. Stops are marked by stopFlag. */
+  };
+
+  static const unsigned capacity = 4096;
+  Event events[capacity];
+  atomic<unsigned> written; /**< The number of events written. Only changed by the thread owning the buffer. */
+  unsigned read = 0; /**< The number of events read. Only changed by the thread of the process. */
+  const thread::id owner; /**< The thread writing to this buffer. */
+  const unsigned char index; /**< The index of the thread in this process in the order the threads started to use stopwatches. */
+
+  EventBuffer(unsigned char index) : written(0), owner(this_thread::get_id()), index(index) {}
+
+  void record(unsigned short id, unsigned long long ticks)
+  {
+    const unsigned w = written.load(memory_order_relaxed);
+    Event& event = events[w % capacity];
+    event.ticks = ticks;
+    event.id = id;
+    written.store(w + 1, memory_order_release);
+  }
+};
+
+struct TimingManager::Pimpl
+{
+  unsigned long long startTicks[maxNumOfWatches]; /**< The time the stopwatches were started. */
+  unsigned durations[maxNumOfWatches]; /**< The time between start and stop in us. 0 if not stopped in this frame. */
+  atomic<bool> used[maxNumOfWatches]; /**< Has the stopwatch been used in this process? */
+  vector<unsigned short> watchIds; /**< The ids of the stopwatches used by this process in the order of their first use. */
+  vector<const char*> watchNames; /**< Contains the names of the stopwatches in the same order. */
+  vector<unique_ptr<EventBuffer>> eventBuffers; /**< The event buffers of all threads using stopwatches in this process. */
+  const unsigned instance = ++numOfInstances; /**< Identifies the event buffers belonging to this timing manager. */
   unsigned currentProcessStartTime = 0; /**< Timestamp of the current process iteration */
   unsigned frameNo = 0; /**<  Number of the current frame*/
-  vector<const char*> watchNames; /**< Contains the names of the stopwatches */
   MessageQueue data; /**< Contains the timing data in streamable format inbetween frames */
   bool processRunning = false; /**< Is a process iteration running right now? */
-  bool dataPrepared = false; /**< True if data hs already been prepared this frame */
-  int watchNameIndex = 0; /**< Every frame a few watch names are transmitted. This is the index of the watchname that is to be transmitted next */
+  atomic<bool> dataPrepared; /**< True if data hs already been prepared this frame */
+  bool trace = false; /**< Add the trace of this frame to the data? */
+  size_t watchNameIndex = 0; /**< Every frame a few watch names are transmitted. This is the index of the watchname that is to be transmitted next */
+  DECLARE_SYNC; /**< Stopwatches can be used by the worker threads of the module manager in parallel. */
+
+  Pimpl() : dataPrepared(false)
+  {
+    for(atomic<bool>& u : used)
+      u.store(false, memory_order_relaxed);
+  }
 };
 
 TimingManager::TimingManager() : prvt(new TimingManager::Pimpl)
 {
   prvt->data.setSize(500000);
+  getClock();
 }
 
 TimingManager::~TimingManager()
@@ -49,26 +183,74 @@ TimingManager::~TimingManager()
   delete prvt;
 }
 
-void TimingManager::startTiming(const char* identifier)
+unsigned short TimingManager::getWatchId(const char* identifier)
 {
-  unsigned long long startTime = SystemCall::getCurrentThreadTime();
-  if(prvt->timing.find(identifier) == prvt->timing.end())
-  { //create new entry
-    prvt->watchNames.push_back(identifier);
-    prvt->idTable[identifier] = (unsigned short)prvt->idTable.size(); //NOTE: this assumes that an unsigned short will always be big big enough to count the timers...
+  WatchRegistry& registry = getWatchRegistry();
+  SYNC_WITH(registry);
+  auto i = registry.ids.find(identifier);
+  if(i != registry.ids.end())
+    return i->second;
+  ASSERT(registry.names.size() < maxNumOfWatches);
+  const unsigned short id = static_cast<unsigned short>(registry.names.size());
+  registry.names.emplace_back(identifier);
+  registry.ids[identifier] = id;
+  return id;
+}
+
+void TimingManager::startTiming(unsigned short id)
+{
+  ASSERT(id < maxNumOfWatches);
+  if(!prvt->used[id].load(memory_order_acquire))
+  {
+    WatchRegistry& registry = getWatchRegistry();
+    SYNC_WITH(*prvt);
+    if(!prvt->used[id].load(memory_order_relaxed))
+    {
+      {
+        SYNC_WITH(registry);
+        prvt->watchNames.push_back(registry.names[id].c_str());
+      }
+      prvt->watchIds.push_back(id);
+      prvt->durations[id] = 0;
+      prvt->used[id].store(true, memory_order_release);
+    }
   }
-  prvt->timing[identifier] = startTime;
-  prvt->dataPrepared = false;
+  const unsigned long long ticks = readTicks();
+  prvt->startTicks[id] = ticks;
+  getEventBuffer().record(id, ticks);
 }
 
-unsigned TimingManager::stopTiming(const char* identifier)
+unsigned TimingManager::stopTiming(unsigned short id)
 {
-  const unsigned long long stopTime = SystemCall::getCurrentThreadTime();
-  const unsigned diff = unsigned(stopTime - prvt->timing[identifier]);
-  prvt->timing[identifier] = diff;
+  const unsigned long long ticks = readTicks();
+  getEventBuffer().record(id | stopFlag, ticks);
+  const unsigned diff = static_cast<unsigned>(static_cast<double>(ticks - prvt->startTicks[id]) * getClock().getNanosecondsPerTick() / 1000.0);
+  prvt->durations[id] = diff;
+  prvt->dataPrepared.store(false, memory_order_relaxed);
   return diff;
 }
 
+TimingManager::EventBuffer& TimingManager::getEventBuffer()
+{
+  thread_local unsigned eventBufferInstance = 0; // The timing manager the event buffer of this thread belongs to.
+  thread_local EventBuffer* eventBuffer = nullptr;
+  if(eventBufferInstance != prvt->instance)
+  {
+    SYNC_WITH(*prvt);
+    eventBuffer = nullptr;
+    for(const unique_ptr<EventBuffer>& buffer : prvt->eventBuffers)
+      if(buffer->owner == this_thread::get_id())
+        eventBuffer = buffer.get();
+    if(!eventBuffer)
+    {
+      prvt->eventBuffers.emplace_back(new EventBuffer(static_cast<unsigned char>(prvt->eventBuffers.size())));
+      eventBuffer = prvt->eventBuffers.back().get();
+    }
+    eventBufferInstance = prvt->instance;
+  }
+  return *eventBuffer;
+}
+
 void TimingManager::signalProcessStart()
 {
   prvt->currentProcessStartTime = SystemCall::getCurrentSystemTime();
@@ -76,6 +258,16 @@ void TimingManager::signalProcessStart()
   prvt->processRunning = true;
   prvt->data.clear();
   prvt->dataPrepared = false;
+  prvt->trace = false;
+  DEBUG_RESPONSE("timing:trace") prvt->trace = true;
+  getClock().calibrate();
+
+  // Only the times and events of the frame starting now are of interest.
+  SYNC_WITH(*prvt);
+  for(unsigned short id : prvt->watchIds)
+    prvt->durations[id] = 0;
+  for(const unique_ptr<EventBuffer>& buffer : prvt->eventBuffers)
+    buffer->read = buffer->written.load(memory_order_acquire);
 }
 
 void TimingManager::signalProcessStop()
@@ -83,6 +275,15 @@ void TimingManager::signalProcessStop()
   prvt->processRunning = false;
 }
 
+void TimingManager::requestTrace()
+{
+  if(!prvt->trace)
+  {
+    prvt->trace = true;
+    prvt->dataPrepared = false;
+  }
+}
+
 MessageQueue& TimingManager::getData()
 {
   ASSERT(!prvt->processRunning);
@@ -110,26 +311,61 @@ void TimingManager::prepareData()
    * unsigned : timestamp at which the last iteration started.
    * unsigned : frame number of the current frame
    */
+  prvt->data.clear();
   OutBinaryMessage& out = prvt->data.out.bin;
+  SYNC_WITH(*prvt);
 
   // every frame we send 3 watch names
-  out << (unsigned short)3; //number of names to follow
-  for(int i = 0; i < 3; ++i, prvt->watchNameIndex = (prvt->watchNameIndex + 1) % prvt->watchNames.size())
-  {
-    const char* watchName = prvt->watchNames[prvt->watchNameIndex];
-    out << prvt->idTable[watchName] << watchName;
-  }
+  const unsigned short numOfNames = static_cast<unsigned short>(std::min(prvt->watchNames.size(), size_t(3)));
+  out << numOfNames; //number of names to follow
+  for(int i = 0; i < numOfNames; ++i, prvt->watchNameIndex = (prvt->watchNameIndex + 1) % prvt->watchNames.size())
+    out << prvt->watchIds[prvt->watchNameIndex] << prvt->watchNames[prvt->watchNameIndex];
 
   // now write the data of all watches
-  out << (unsigned short)prvt->timing.size();
-  for(const pair<const char*, unsigned long long>& it : prvt->timing)
+  out << static_cast<unsigned short>(prvt->watchIds.size());
+  for(unsigned short id : prvt->watchIds)
   {
-    out << prvt->idTable[it.first];
-    out << (unsigned)it.second; // the cast is ok because the time between start and stop will never be bigger than an int...
-    prvt->timing[it.first] = 0;
+    out << id << prvt->durations[id];
   }
   out << prvt->currentProcessStartTime;
   out << prvt->frameNo;
   if(!prvt->data.out.finishMessage(idStopwatch))
     OUTPUT_WARNING("TimingManager: queue is full!!!");
+
+  if(prvt->trace)
+    prepareTrace();
+}
+
+void TimingManager::prepareTrace()
+{
+  /** Protocol:
+   * unsigned : frame number of the current frame
+   * unsigned char : number of threads
+   * for each thread:
+   *  unsigned char : index of the thread in this process
+   *  unsigned : number of events
+   *  unsigned long long : time of the first event in ns. It is consistent between processes.
+   *  for each event:
+   *   unsigned short : id of the stopwatch. The highest bit is set if the stopwatch was stopped.
+   *   unsigned : time since the first event in ns
+   */
+  OutBinaryMessage& out = prvt->data.out.bin;
+  const Clock& clock = getClock();
+  out << prvt->frameNo << static_cast<unsigned char>(prvt->eventBuffers.size());
+  for(const unique_ptr<EventBuffer>& buffer : prvt->eventBuffers)
+  {
+    const unsigned written = buffer->written.load(memory_order_acquire);
+    if(written - buffer->read > EventBuffer::capacity)
+      buffer->read = written - EventBuffer::capacity;
+    const unsigned numOfEvents = written - buffer->read;
+    const uint64_t baseTime = numOfEvents ? clock.toNanoseconds(buffer->events[buffer->read % EventBuffer::capacity].ticks) : 0;
+    out << buffer->index << numOfEvents << baseTime;
+    for(unsigned i = buffer->read; i != written; ++i)
+    {
+      const EventBuffer::Event& event = buffer->events[i % EventBuffer::capacity];
+      out << event.id << static_cast<unsigned>(clock.toNanoseconds(event.ticks) - baseTime);
+    }
+  }
+  if(!prvt->data.out.finishMessage(idStopwatchTrace))
+    OUTPUT_WARNING("TimingManager: queue is full!!!");
 }
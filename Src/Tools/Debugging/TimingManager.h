@@ -15,23 +15,45 @@ class MessageQueue;
  * It always belongs to exactly one process and should only be created/destroyed
  * by that process.
  * There should be exactly one TimingManager per process.
+ *
+ * Stopwatches are identified by ids that are shared by all processes. Besides
+ * the time between start and stop, every thread records the starts and stops
+ * as events into a ring buffer of its own. If requested, the events of a frame
+ * are streamed as idStopwatchTrace, which allows to reconstruct the nesting of
+ * the stopwatches of all threads over time, e.g. as a Chrome trace.
  */
 class TimingManager
 {
 private:
   struct Pimpl;
+  struct EventBuffer;
   Pimpl* prvt;
 
   friend class Process;
+  friend class LogReplay;
   TimingManager(); // private so only Process can access it.
   ~TimingManager();
 
 public:
+  /**
+   * Returns the id of a stopwatch. The ids are shared by all processes.
+   * The macro STOPWATCH only determines the id once per stopwatch.
+   * @param identifier The name of the stopwatch.
+   * @return The id of the stopwatch.
+   */
+  static unsigned short getWatchId(const char* identifier);
+
+  /** Start the stopwatch with the specified id. */
+  void startTiming(unsigned short id);
+
+  /** Stops the stopwatch with the specified id and returns the time in us. */
+  unsigned stopTiming(unsigned short id);
+
   /** Start the stopwatch for the specified identifier. */
-  void startTiming(const char* identifier);
+  void startTiming(const char* identifier) {startTiming(getWatchId(identifier));}
 
   /** Stops the stopwatch for the specified identifier and returns the time in us. */
-  unsigned stopTiming(const char* identifier);
+  unsigned stopTiming(const char* identifier) {return stopTiming(getWatchId(identifier));}
 
   /**
    * The TimingManager has a special stopwatch that is used to keep track
@@ -44,6 +66,12 @@ public:
   /** Tells the TimingManager that the current process iteration is over. */
   void signalProcessStop();
 
+  /**
+   * Adds the trace of the current frame to the timing data. It is also added
+   * if the debug request "timing:trace" is active. Call this method before getData().
+   */
+  void requestTrace();
+
   /**
    * Returns a message queue that contains all timing data from this frame.
    * Call this method in between signalProcessStop() and signalProcessStart.
@@ -51,6 +79,12 @@ public:
   MessageQueue& getData();
 
 private:
+  /** Returns the event buffer of the calling thread. */
+  EventBuffer& getEventBuffer();
+
   /** Prepares timing data for streaming. */
   void prepareData();
+
+  /** Streams the events recorded in this frame. */
+  void prepareTrace();
 };
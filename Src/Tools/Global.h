@@ -121,4 +121,6 @@ public:
   friend class ConsoleRoboCupCtrl; // The class ConsoleRoboCupCtrl can set theStreamHandler.
   friend class RobotConsole; // The class RobotConsole can set theDebugOut.
   friend class Framework;
+  friend class ParallelExecutor; // The class ParallelExecutor copies the pointers to its worker threads.
+  friend class LogReplay; // The class LogReplay replaces the process when replaying logs without the simulator.
 };
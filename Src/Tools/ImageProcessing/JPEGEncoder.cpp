@@ -0,0 +1,97 @@
+/**
+ * @file JPEGEncoder.cpp
+ *
+ * Implementation of a class that compresses images for the debug connection in
+ * a thread of its own.
+ */
+
+#include "JPEGEncoder.h"
+#include "Platform/SystemCall.h"
+#include "Tools/Global.h"
+#include "Tools/MessageQueue/OutMessage.h"
+#include <algorithm>
+
+JPEGEncoder::JPEGEncoder(int minQuality, int maxQuality) :
+  minQuality(minQuality), maxQuality(maxQuality), quality(maxQuality), source(false)
+{
+  cInfo.err = jpeg_std_error(&jem);
+  jpeg_create_compress(&cInfo);
+  thread.start(this, &JPEGEncoder::run);
+}
+
+JPEGEncoder::~JPEGEncoder()
+{
+  thread.announceStop();
+  imageAvailable.post();
+  thread.stop();
+  jpeg_destroy_compress(&cInfo);
+}
+
+void JPEGEncoder::stream(const Image& image, MessageID id)
+{
+  State state;
+  {
+    SYNC;
+    state = this->state;
+  }
+
+  if(state == busy)
+    return; // drop the image, the encoder cannot keep up
+
+  if(state == done)
+  {
+    Global::getDebugOut().bin << result;
+    if(Global::getDebugOut().finishMessage(id))
+      quality = std::min(quality + 1, maxQuality);
+    else
+      quality = std::max(quality - 10, minQuality);
+  }
+
+  if(image.sharedBuffer)
+    source.shareImage(image);
+  else
+    source = image;
+  sourceQuality = quality;
+  {
+    SYNC;
+    this->state = busy;
+  }
+  imageAvailable.post();
+}
+
+void JPEGEncoder::release()
+{
+  for(;;)
+  {
+    {
+      SYNC;
+      if(state != busy)
+        break;
+    }
+    SystemCall::sleep(1);
+  }
+  source.sharedBuffer.reset();
+}
+
+void JPEGEncoder::run()
+{
+  Thread<JPEGEncoder>::setName("JPEGEncoder");
+
+  while(thread.isRunning())
+  {
+    if(!imageAvailable.wait(100)) // wait 100 ms for an image, then check again if we should quit
+      continue;
+
+    {
+      SYNC;
+      if(state != busy)
+        continue;
+    }
+
+    result.compress(source, sourceQuality, cInfo);
+    source.sharedBuffer.reset(); // hand the camera buffer back as early as possible
+
+    SYNC;
+    state = done;
+  }
+}
@@ -0,0 +1,80 @@
+/**
+ * @file JPEGEncoder.h
+ *
+ * Declaration of a class that compresses images for the debug connection in a
+ * thread of its own.
+ */
+
+#pragma once
+
+#include "Representations/Infrastructure/JPEGImage.h"
+#include "Tools/MessageQueue/MessageIDs.h"
+#include "Platform/Semaphore.h"
+#include "Platform/Thread.h"
+
+/**
+ * The encoder compresses images in a background thread, so streaming them does
+ * not extend the frame of the thread providing them. The thread keeps its
+ * compressor between images. An image is sent in the frame after it was handed
+ * over. Images handed over while the previous one is still compressed are
+ * dropped. Whenever the debug queue cannot take an image, the quality is
+ * reduced, and it slowly recovers while images fit.
+ */
+class JPEGEncoder
+{
+private:
+  enum State
+  {
+    idle, /**< The encoder thread waits for an image. */
+    busy, /**< The encoder thread compresses the source image. */
+    done /**< The compressed image can be sent. */
+  };
+
+  const int minQuality; /**< The quality is never reduced below this value. */
+  const int maxQuality; /**< The quality is never increased beyond this value. */
+  int quality; /**< The quality used for the next image. */
+
+  State state = idle; /**< The state of the encoder thread. Protected by SYNC. */
+  DECLARE_SYNC;
+
+  // Owned by the encoder thread while busy, otherwise by the thread streaming images.
+  Image source; /**< The image compressed. Refers to the camera buffer if it is shared. */
+  int sourceQuality = 0; /**< The quality the source image is compressed with. */
+  JPEGImage result; /**< The compressed image. */
+
+  // Only used by the encoder thread.
+  jpeg_compress_struct cInfo; /**< The compressor that is reused for all images. */
+  jpeg_error_mgr jem;
+
+  Thread<JPEGEncoder> thread;
+  Semaphore imageAvailable; /**< Wakes up the encoder thread. */
+
+public:
+  /**
+   * Constructor. Starts the encoder thread.
+   * @param minQuality The minimum JPEG quality (0 .. 100).
+   * @param maxQuality The maximum JPEG quality (0 .. 100), which is also the initial quality.
+   */
+  JPEGEncoder(int minQuality = 30, int maxQuality = 75);
+
+  /** Destructor. Stops the encoder thread. */
+  ~JPEGEncoder();
+
+  /**
+   * Sends the image compressed last, if there is one, to the debug queue and
+   * hands the image over to the encoder thread if it is idle.
+   * @param image The image to compress. If it refers to a shared buffer, only the reference is kept.
+   * @param id The message id the compressed image is sent with.
+   */
+  void stream(const Image& image, MessageID id);
+
+  /**
+   * Waits until the image currently compressed is done and drops the reference
+   * to its shared buffer, so the buffer can be handed back to its owner.
+   */
+  void release();
+
+private:
+  /** The main function of the encoder thread. */
+  void run();
+};
@@ -45,7 +45,9 @@ template <class P = Point> struct BSpline
     P calcxyz;
     int output_index;
 
-    u = new int[n + t + 1];
+    // Typical splines have only a few knots, which fit onto the stack.
+    int knots[32];
+    u = n + t + 1 <= 32 ? knots : new int[n + t + 1];
     compute_intervals(u, n, t);
 
     increment = (float)(n - t + 2) / (num_output - 1);  // how much parameter goes up each time
@@ -59,7 +61,8 @@ template <class P = Point> struct BSpline
     }
     output[num_output - 1] = control[n];   // put in the last point
 
-    delete[] u;
+    if (u != knots)
+      delete[] u;
   }
   static float blend(int k, int t, int *u, float v)  // calculate the blending value
   {
@@ -15,4 +15,5 @@ ENUM(LogFileFormat,
   logFileCompressed,
   logFileMessageIDs,
   logFileStreamSpecification,
+  logFileCompressedWithIndex, /**< Like logFileCompressed, but followed by a LogFileIndex. */
 });
@@ -0,0 +1,144 @@
+/**
+ * @file LogFileIndex.cpp
+ * Implementation of an index of the compressed blocks of a log file.
+ */
+
+#include "LogFileIndex.h"
+#include "Platform/BHAssert.h"
+#include "Tools/Streams/InStreams.h"
+#include "Tools/Streams/OutStreams.h"
+#include <algorithm>
+#include <cstring>
+
+constexpr char LogFileIndex::magic[4];
+constexpr unsigned char LogFileIndex::version;
+
+void LogFileIndex::clear()
+{
+  blocks.clear();
+  frameIndex.clear();
+  numberOfFrames = 0;
+  numberOfMessagesWithinCompleteFrames = 0;
+  currentProcess = 0;
+}
+
+void LogFileIndex::addBlock(unsigned compressedSize, const char* data, size_t size,
+                            unsigned char processBegin, unsigned char processFinished)
+{
+  ASSERT(size >= 2 * sizeof(unsigned));
+  const int firstMessage = getNumberOfMessages();
+  blocks.emplace_back();
+  Block& block = blocks.back();
+  block.compressedSize = compressedSize;
+  block.firstMessage = firstMessage;
+  block.numberOfMessages = 0;
+
+  // Only the used size is relevant. The number of messages is -1 in appendable queues.
+  const unsigned usedSize = *reinterpret_cast<const unsigned*>(data);
+  const char* p = data + 2 * sizeof(unsigned);
+  const char* end = p + std::min(static_cast<size_t>(usedSize), size - 2 * sizeof(unsigned));
+  while(p + 4 <= end)
+  {
+    const unsigned char id = static_cast<unsigned char>(p[0]);
+    const unsigned messageSize = (*reinterpret_cast<const unsigned*>(p) >> 8) + 4;
+    if(id == processBegin)
+    {
+      if(messageSize > 4)
+        currentProcess = p[4];
+      frameIndex.push_back(firstMessage + block.numberOfMessages);
+    }
+    else if(id == processFinished)
+    {
+      ++numberOfFrames;
+      numberOfMessagesWithinCompleteFrames = firstMessage + block.numberOfMessages + 1;
+    }
+
+    auto s = std::find_if(block.statistics.begin(), block.statistics.end(), [&](const MessageStatistics& entry)
+    {
+      return entry.id == id && entry.processIdentifier == currentProcess;
+    });
+    if(s == block.statistics.end())
+    {
+      block.statistics.emplace_back();
+      s = block.statistics.end() - 1;
+      s->processIdentifier = currentProcess;
+      s->id = id;
+    }
+    ++s->count;
+    s->size += messageSize;
+
+    ++block.numberOfMessages;
+    p += messageSize;
+  }
+}
+
+int LogFileIndex::findBlock(int message) const
+{
+  ASSERT(message >= 0 && message < getNumberOfMessages());
+  return static_cast<int>(std::upper_bound(blocks.begin(), blocks.end(), message, [](int message, const Block& block)
+  {
+    return message < block.firstMessage;
+  }) - blocks.begin()) - 1;
+}
+
+void LogFileIndex::write(Out& stream) const
+{
+  OutBinarySize size;
+  writeIndex(size);
+  writeIndex(stream);
+  stream << static_cast<unsigned>(size.getSize());
+  stream.write(magic, sizeof(magic));
+}
+
+bool LogFileIndex::read(const char* data, size_t size, size_t& indexStart)
+{
+  clear();
+  if(size < sizeof(unsigned) + sizeof(magic) || std::memcmp(data + size - sizeof(magic), magic, sizeof(magic)))
+    return false;
+  unsigned indexSize;
+  std::memcpy(&indexSize, data + size - sizeof(magic) - sizeof(unsigned), sizeof(unsigned));
+  if(indexSize > size - sizeof(unsigned) - sizeof(magic))
+    return false;
+  indexStart = size - sizeof(magic) - sizeof(unsigned) - indexSize;
+  InBinaryMemory stream(data + indexStart, indexSize);
+  unsigned char fileVersion;
+  stream >> fileVersion;
+  if(fileVersion != version)
+    return false;
+  readIndex(stream);
+  return true;
+}
+
+void LogFileIndex::writeIndex(Out& stream) const
+{
+  stream << version << static_cast<unsigned>(blocks.size());
+  for(const Block& block : blocks)
+  {
+    stream << block.compressedSize << block.firstMessage << block.numberOfMessages << static_cast<unsigned>(block.statistics.size());
+    for(const MessageStatistics& s : block.statistics)
+      stream << s.processIdentifier << s.id << s.count << s.size;
+  }
+  stream << static_cast<unsigned>(frameIndex.size());
+  for(int message : frameIndex)
+    stream << message;
+  stream << numberOfFrames << numberOfMessagesWithinCompleteFrames;
+}
+
+void LogFileIndex::readIndex(In& stream)
+{
+  unsigned size;
+  stream >> size;
+  blocks.resize(size);
+  for(Block& block : blocks)
+  {
+    stream >> block.compressedSize >> block.firstMessage >> block.numberOfMessages >> size;
+    block.statistics.resize(size);
+    for(MessageStatistics& s : block.statistics)
+      stream >> s.processIdentifier >> s.id >> s.count >> s.size;
+  }
+  stream >> size;
+  frameIndex.resize(size);
+  for(int& message : frameIndex)
+    stream >> message;
+  stream >> numberOfFrames >> numberOfMessagesWithinCompleteFrames;
+}
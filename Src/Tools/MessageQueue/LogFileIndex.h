@@ -0,0 +1,92 @@
+/**
+ * @file LogFileIndex.h
+ * Declaration of an index of the compressed blocks of a log file. It is
+ * appended to log files in the format logFileCompressedWithIndex and allows
+ * to access frames and to compute statistics without decompressing the whole
+ * log file. The index is stored behind the last block:
+ * | index | size of index (4 bytes) | "BHLI" |
+ */
+
+#pragma once
+
+#include "MessageIDs.h"
+#include <cstddef>
+#include <vector>
+
+class In;
+class Out;
+
+class LogFileIndex
+{
+public:
+  /** The number and the size of the messages of a type that a process logged in a block. */
+  struct MessageStatistics
+  {
+    char processIdentifier; /**< The process that logged the messages. 0 for messages before the first frame. */
+    unsigned char id; /**< The message id as it is stored in the file, i.e. before it is mapped. */
+    unsigned count = 0; /**< The number of messages. */
+    unsigned size = 0; /**< The size of the messages in bytes, including their headers. */
+  };
+
+  /** A compressed block, i.e. a streamed message queue. */
+  struct Block
+  {
+    unsigned compressedSize; /**< The size of the compressed block, not including its size. */
+    int firstMessage; /**< The number of the first message in this block. */
+    int numberOfMessages; /**< The number of messages in this block. */
+    std::vector<MessageStatistics> statistics;
+  };
+
+  std::vector<Block> blocks;
+  std::vector<int> frameIndex; /**< The message numbers the frames start at. */
+  int numberOfFrames = 0; /**< The number of complete frames. */
+  int numberOfMessagesWithinCompleteFrames = 0; /**< Messages behind that number are not part of a complete frame. */
+
+  /** Removes all blocks. */
+  void clear();
+
+  /**
+   * Adds a block to the index.
+   * @param compressedSize The size of the compressed block.
+   * @param data The uncompressed block, i.e. a streamed message queue.
+   * @param size The size of the uncompressed block.
+   * @param processBegin The id of idProcessBegin as it is stored in the block.
+   * @param processFinished The id of idProcessFinished as it is stored in the block.
+   */
+  void addBlock(unsigned compressedSize, const char* data, size_t size,
+                unsigned char processBegin = idProcessBegin, unsigned char processFinished = idProcessFinished);
+
+  /** Returns the number of messages in all blocks. */
+  int getNumberOfMessages() const {return blocks.empty() ? 0 : blocks.back().firstMessage + blocks.back().numberOfMessages;}
+
+  /**
+   * Returns the block that contains a certain message.
+   * @param message The number of the message.
+   * @return The index of the block.
+   */
+  int findBlock(int message) const;
+
+  /**
+   * Writes the index including its size and the magic bytes.
+   * @param stream The stream the index is appended to.
+   */
+  void write(Out& stream) const;
+
+  /**
+   * Reads the index from the end of a log file.
+   * @param data The contents of the log file.
+   * @param size The size of the log file.
+   * @param indexStart The offset of the index in the log file, i.e. the end of the last block.
+   * @return Was an index found?
+   */
+  bool read(const char* data, size_t size, size_t& indexStart);
+
+private:
+  static constexpr char magic[4] = {'B', 'H', 'L', 'I'};
+  static constexpr unsigned char version = 1;
+
+  char currentProcess = 0; /**< The process of the last frame that was begun. */
+
+  void writeIndex(Out& stream) const;
+  void readIndex(In& stream);
+};
@@ -107,6 +107,7 @@ ENUM(MessageID,
   idFootPositions,
   idMotionSelection,
   idMotionState,
+  idStopwatchTrace,
 
   numOfDataMessageIDs, /**< everything below this does not belong into log files */
 
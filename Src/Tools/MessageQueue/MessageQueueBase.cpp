@@ -64,13 +64,7 @@ void MessageQueueBase::setSize(unsigned size, unsigned reserveForInfrastructure)
 
 void MessageQueueBase::clear()
 {
-  usedSize = 0;
-  numberOfMessages = 0;
-  writePosition = 0;
-  writingOfLastMessageFailed = false;
-  selectedMessageForReadingPosition = 0;
-  readPosition = 0;
-  lastMessage = 0;
+  clearMessages();
   numOfMappedIDs = 0;
   if(mappedIDs)
   {
@@ -78,6 +72,17 @@ void MessageQueueBase::clear()
     mappedIDs = 0;
     delete[] mappedIDNames;
   }
+}
+
+void MessageQueueBase::clearMessages()
+{
+  usedSize = 0;
+  numberOfMessages = 0;
+  writePosition = 0;
+  writingOfLastMessageFailed = false;
+  selectedMessageForReadingPosition = 0;
+  readPosition = 0;
+  lastMessage = 0;
   freeIndex();
 }
 
@@ -277,6 +282,7 @@ void MessageQueueBase::removeRepetitions()
 
       // data only from latest frame
       case idStopwatch:
+      case idStopwatchTrace:
       case idDebugImage:
       case idDebugJPEGImage:
       case idDebugDrawing:
@@ -340,12 +346,6 @@ void MessageQueueBase::removeRepetitions()
   lastMessage = 0;
 }
 
-MessageID MessageQueueBase::getMessageID() const
-{
-  MessageID id = MessageID(buf[selectedMessageForReadingPosition]);
-  return id < numOfMappedIDs ? mappedIDs[id] : id;
-}
-
 void MessageQueueBase::setSelectedMessageForReading(int message)
 {
   ASSERT(message >= 0);
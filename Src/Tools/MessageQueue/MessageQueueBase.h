@@ -69,6 +69,11 @@ public:
    */
   void clear();
 
+  /**
+   * The method removes all messages from the queue, but keeps the message id mapping.
+   */
+  void clearMessages();
+
   /**
    * The method removes a message from the queue.
    * @param message The number of the message.
@@ -119,7 +124,14 @@ public:
    * The method returns the message id of the currently selected message for reading.
    * @return The message id.
    */
-  MessageID getMessageID() const;
+  MessageID getMessageID() const {return mapID(static_cast<unsigned char>(buf[selectedMessageForReadingPosition]));}
+
+  /**
+   * The method maps a message id as it is stored in the queue to the id used internally.
+   * @param id The id as stored in the queue, e.g. the id read from a log file.
+   * @return The message id.
+   */
+  MessageID mapID(unsigned char id) const {return id < numOfMappedIDs ? mappedIDs[id] : static_cast<MessageID>(id);}
 
   /**
    * The method returns the message size of the currently selected message for reading.
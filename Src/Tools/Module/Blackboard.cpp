@@ -5,16 +5,63 @@
  */
 
 #include "Blackboard.h"
+#include "Tools/MessageQueue/MessageIDs.h"
 #include "Tools/Streams/Streamable.h"
 #include "Platform/BHAssert.h"
 #include "Platform/SystemCall.h"
+#include "Platform/Thread.h"
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 /** The instance of the blackboard of the current process. */
 static PROCESS_LOCAL Blackboard* theInstance = nullptr;
 
-/** The actual type of the map for all entries. */
-class Blackboard::Entries : public std::unordered_map<std::string, Blackboard::Entry> {};
+/** The actual type of the table of all entries. */
+class Blackboard::Entries : public std::vector<Blackboard::Entry> {};
+
+/**
+ * The mapping from representation names to slots. It is shared by all
+ * processes, because the processes can be threads in the same address space.
+ */
+class Slots
+{
+private:
+  std::unordered_map<std::string, int> slots;
+  DECLARE_SYNC;
+
+  Slots()
+  {
+    // Representations with a message id use it as their slot.
+    for(int i = 0; i < numOfDataMessageIDs; ++i)
+      slots[::getName(static_cast<MessageID>(i)) + 2] = i;
+  }
+
+public:
+  static Slots& getInstance()
+  {
+    static Slots instance;
+    return instance;
+  }
+
+  int get(const char* representation)
+  {
+    SYNC;
+    auto i = slots.find(representation);
+    if(i != slots.end())
+      return i->second;
+    const int slot = static_cast<int>(slots.size());
+    slots[representation] = slot;
+    return slot;
+  }
+
+  int find(const char* representation)
+  {
+    SYNC;
+    auto i = slots.find(representation);
+    return i == slots.end() ? -1 : i->second;
+  }
+};
 
 Blackboard::Blackboard() :
   entries(*new Entries)
@@ -26,47 +73,65 @@ Blackboard::~Blackboard()
 {
   ASSERT(theInstance == this);
   theInstance = 0;
-  ASSERT(entries.size() == 0);
+#ifndef NDEBUG
+  for(const Entry& entry : entries)
+    ASSERT(entry.counter == 0);
+#endif
   delete &entries;
 }
 
-Blackboard::Entry& Blackboard::get(const char* representation)
+int Blackboard::getSlot(const char* representation)
 {
-  return entries[representation];
+  return Slots::getInstance().get(representation);
 }
 
-const Blackboard::Entry& Blackboard::get(const char* representation) const
+Blackboard::Entry& Blackboard::get(int slot)
 {
-  return entries.find(representation)->second;
+  if(slot >= static_cast<int>(entries.size()))
+    entries.resize(slot + 1);
+  return entries[slot];
 }
 
 bool Blackboard::exists(const char* representation) const
 {
-  return entries.find(representation) != entries.end();
+  return exists(Slots::getInstance().find(representation));
+}
+
+bool Blackboard::exists(int slot) const
+{
+  return slot >= 0 && slot < static_cast<int>(entries.size()) && entries[slot].counter > 0;
 }
 
 Streamable& Blackboard::operator[](const char* representation)
 {
-  Entry& entry = get(representation);
-  ASSERT(entry.data);
-  return *entry.data;
+  return (*this)[Slots::getInstance().find(representation)];
 }
 
 const Streamable& Blackboard::operator[](const char* representation) const
 {
-  const Entry& entry = get(representation);
-  ASSERT(entry.data);
-  return *entry.data;
+  return (*this)[Slots::getInstance().find(representation)];
+}
+
+Streamable& Blackboard::operator[](int slot)
+{
+  ASSERT(exists(slot));
+  return *entries[slot].data;
+}
+
+const Streamable& Blackboard::operator[](int slot) const
+{
+  ASSERT(exists(slot));
+  return *entries[slot].data;
 }
 
 void Blackboard::free(const char* representation)
 {
-  Entry& entry = get(representation);
+  Entry& entry = get(getSlot(representation));
   ASSERT(entry.counter > 0);
   if(--entry.counter == 0)
   {
     delete entry.data;
-    entries.erase(representation);
+    entry.data = nullptr;
     ++version;
   }
 }
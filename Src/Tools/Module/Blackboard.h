@@ -3,6 +3,13 @@
  * representations used in a process.
  * The file will be included by all modules and therefore avoids including
  * headers by itself.
+ *
+ * Each representation name is mapped to a dense slot index when it is
+ * registered for the first time. Representations that have a data message id
+ * use that id as their slot. The slots are the same in all processes, so they
+ * can be determined once and stored, e.g. in a static variable. Accessing the
+ * blackboard through a slot is a plain table lookup. Access through names is
+ * only meant for the initialization and debugging.
  * @author Thomas Röfer
  */
 
@@ -20,8 +27,8 @@ private:
     int counter = 0; /**< How many modules requested its existance? */
   };
 
-  class Entries; /**< Type of the map for all entries. */
-  Entries& entries; /**< All entries of the blackboard. */
+  class Entries; /**< Type of the table of all entries. */
+  Entries& entries; /**< All entries of the blackboard, indexed by their slot. */
   int version = 0; /**< A version that is increased with each configuration change. */
 
   /**
@@ -31,15 +38,15 @@ private:
    */
   static void setInstance(Blackboard& instance);
   friend class Process;
+  friend class ParallelExecutor;
 
   /**
-   * Retrieve the blackboard entry for the name of a representation.
-   * @param representation The name of the representation.
+   * Retrieve the blackboard entry for the slot of a representation.
+   * @param slot The slot of the representation.
    * @return The blackboard entry. If it does not exist, the it will
    * be created, but not the representation.
    */
-  Entry& get(const char* representation);
-  const Entry& get(const char* representation) const;
+  Entry& get(int slot);
 
 public:
   /**
@@ -54,6 +61,14 @@ public:
    */
   ~Blackboard();
 
+  /**
+   * Determine the slot of a representation. It is assigned when a name is
+   * requested for the first time and is the same in all processes.
+   * @param representation The name of the representation.
+   * @return The slot of the representation.
+   */
+  static int getSlot(const char* representation);
+
   /**
    * Does a certain representation exist?
    * @param representation The name of the representation.
@@ -61,6 +76,13 @@ public:
    */
   bool exists(const char* representation) const;
 
+  /**
+   * Does a certain representation exist?
+   * @param slot The slot of the representation.
+   * @return Does it exist in this blackboard?
+   */
+  bool exists(int slot) const;
+
   /**
    * Allocate a new blackboard entry for a representation of a
    * certain type and name. The representation is only created
@@ -71,13 +93,13 @@ public:
    */
   template<typename T> T& alloc(const char* representation)
   {
-    Entry& entry = get(representation);
+    Entry& entry = get(getSlot(representation));
     if(entry.counter++ == 0)
     {
       entry.data = new T;
       ++version;
     }
-    return *dynamic_cast<T*>(entry.data);
+    return *static_cast<T*>(entry.data);
   }
 
   /**
@@ -97,6 +119,15 @@ public:
   Streamable& operator[](const char* representation);
   const Streamable& operator[](const char* representation) const;
 
+  /**
+   * Access a representation in a certain slot. The representation
+   * must already exist.
+   * @param slot The slot of the representation.
+   * @return The instance of the representation in the blackboard.
+   */
+  Streamable& operator[](int slot);
+  const Streamable& operator[](int slot) const;
+
   /**
    * Return the current version.
    * It can be used to determine whether the configuration of the
@@ -60,7 +60,20 @@ Logger::Logger(const std::string& processName, char processIdentifier, int frame
 Logger::~Logger()
 {
   if(frameCounter)
-    framesToWrite.post();
+  { // Hand over the incomplete block. The writer thread writes all remaining blocks before it stops.
+    // If the buffer is full, publishing the block would make the buffer look empty, so the writer must free a block first.
+    const int nextWriteIndex = (shared.writeIndex.load(std::memory_order_relaxed) + 1) % parameters.maxBufferSize;
+    while(nextWriteIndex == shared.readIndex.load(std::memory_order_acquire) && writerThread.isRunning())
+    {
+      framesToWrite.post();
+      SystemCall::sleep(10);
+    }
+    if(nextWriteIndex != shared.readIndex.load(std::memory_order_acquire))
+    {
+      shared.writeIndex.store(nextWriteIndex, std::memory_order_release);
+      framesToWrite.post();
+    }
+  }
   writerThread.stop();
   for(MessageQueue* m : buffer)
     delete m;
@@ -76,14 +89,11 @@ void Logger::execute()
       for(const std::string& representation : parameters.representations)
         if(Blackboard::getInstance().exists(representation.c_str()))
         {
-          int i;
-          for(i = 0; i < numOfDataMessageIDs; ++i)
-            if(getName(static_cast<MessageID>(i)) == "id" + representation)
-            {
-              loggables.push_back(Loggable(&Blackboard::getInstance()[representation.c_str()], static_cast<MessageID>(i)));
-              break;
-            }
-          if(i == numOfDataMessageIDs)
+          // Representations with a message id use it as their blackboard slot.
+          const int slot = Blackboard::getSlot(representation.c_str());
+          if(slot < numOfDataMessageIDs)
+            loggables.push_back(Loggable(&Blackboard::getInstance()[slot], static_cast<MessageID>(slot)));
+          else
             OUTPUT_WARNING(processName << "Logger: " << representation << " has no message id.");
         }
         else
@@ -152,13 +162,15 @@ void Logger::createStreamSpecification()
 
 void Logger::logFrame()
 {
-  if(writeIndex == (readIndex + parameters.maxBufferSize - 1) % parameters.maxBufferSize)
+  const int currentWriteIndex = shared.writeIndex.load(std::memory_order_relaxed);
+  if(currentWriteIndex == (shared.readIndex.load(std::memory_order_acquire) + parameters.maxBufferSize - 1) % parameters.maxBufferSize)
   { // Buffer is full, can't do anything this frame
     OUTPUT_WARNING(processName << "Logger: Writer thread too slow, discarding frame.");
     return;
   }
 
-  OutMessage& out = buffer[writeIndex]->out;
+  MessageQueue& queue = *buffer[currentWriteIndex];
+  OutMessage& out = queue.out;
 
   out.bin << processIdentifier;
   out.finishMessage(idProcessBegin);
@@ -174,13 +186,15 @@ void Logger::logFrame()
     }
 
     // Append annotations
-    Global::getAnnotationManager().getOut().copyAllMessages(*buffer[writeIndex]);
+    Global::getAnnotationManager().getOut().copyAllMessages(queue);
   }
 
   // Append timing data if any
+  if(parameters.logTrace)
+    Global::getTimingManager().requestTrace();
   MessageQueue& timingData = Global::getTimingManager().getData();
   if(timingData.getNumberOfMessages() > 0)
-    timingData.copyAllMessages(*buffer[writeIndex]);
+    timingData.copyAllMessages(queue);
   else
     OUTPUT_WARNING(processName << "Logger: No timing data available.");
 
@@ -191,12 +205,13 @@ void Logger::logFrame()
   // Thus one block is used per second.
   if(++frameCounter == framesPerSecond)
   {
-    // The next call to logFrame will use a new block.
-    writeIndex = (writeIndex + 1) % parameters.maxBufferSize;
-    framesToWrite.post(); // Signal to the writer thread that another block is ready
+    // The next call to logFrame will use a new block. Publishing the index hands over the current one.
+    const int nextWriteIndex = (currentWriteIndex + 1) % parameters.maxBufferSize;
+    shared.writeIndex.store(nextWriteIndex, std::memory_order_release);
+    framesToWrite.post(); // Wake up the writer thread
     if(parameters.debugStatistics)
       OUTPUT_WARNING(processName << "Logger buffer is "
-                     << ((parameters.maxBufferSize + readIndex - writeIndex) % parameters.maxBufferSize) /
+                     << ((parameters.maxBufferSize + shared.readIndex.load(std::memory_order_relaxed) - nextWriteIndex) % parameters.maxBufferSize) /
                         static_cast<float>(parameters.maxBufferSize) * 100.f
                      << "% free.");
     frameCounter = 0;
@@ -211,55 +226,79 @@ void Logger::writeThread()
   const size_t compressedSize = snappy_max_compressed_length(parameters.blockSize + 2 * sizeof(unsigned));
   std::vector<char> compressedBuffer(compressedSize + sizeof(unsigned)); // Also reserve 4 bytes for header
 
-  while(writerThread.isRunning()) // Check if we are expecting more data
-    if(framesToWrite.wait(100)) // Wait 100 ms for new data then check again if we should quit
+  bool running = true;
+  do
+  {
+    // Blocks that were handed over before the thread was stopped are still written unless the disk is full
+    running = writerThread.isRunning();
+    if((!running && !shared.diskFull) || framesToWrite.wait(100)) // Wait 100 ms for new data then check again if we should quit
     {
-      writerIdle = false;
-      MessageQueue& queue = *buffer[readIndex];
-      if(queue.getNumberOfMessages() > 0)
+      // Write all blocks that are ready, independent of how often the semaphore was posted
+      int currentReadIndex = shared.readIndex.load(std::memory_order_relaxed);
+      while(currentReadIndex != shared.writeIndex.load(std::memory_order_acquire))
       {
-        size_t size = compressedSize;
-        VERIFY(snappy_compress(queue.getStreamedData(), queue.getStreamedSize(),
-                               compressedBuffer.data() + sizeof(unsigned), &size) == SNAPPY_OK);
-        (unsigned&)compressedBuffer[0] = static_cast<unsigned>(size);
-        if(!file)
-        {
-          // find next free log filename
-          std::string num = "";
-          for(int i = 0; i < 100; ++i)
-          {
-            if(i)
-            {
-              char buf[6];
-              sprintf(buf, "_(%02d)", i);
-              num = buf;
-            }
-            InBinaryFile stream(logFilename + num + ".log");
-            if(!stream.exists())
-              break;
-          }
-          logFilename += num + ".log";
-
-          file = new OutBinaryFile(logFilename);
-          ASSERT(file->exists());
-          *file << logFileMessageIDs;
-          queue.writeMessageIDs(*file);
-          *file << logFileStreamSpecification;
-          file->write(streamSpecification.data(), streamSpecification.size());
-          *file << logFileCompressed; // Write magic byte that indicates a compressed log file
-        }
-        file->write(compressedBuffer.data(), size + sizeof(unsigned));
-        queue.clear();
+        shared.writerIdle = false;
+        writeBlock(*buffer[currentReadIndex], compressedBuffer);
+        currentReadIndex = (currentReadIndex + 1) % parameters.maxBufferSize;
+        shared.readIndex.store(currentReadIndex, std::memory_order_release); // Hand the empty queue back
       }
-      readIndex = (readIndex + 1) % parameters.maxBufferSize;
     }
-    else if(!writerIdle)
+    else if(!shared.writerIdle)
     {
-      writerIdle = true;
-      writerIdleStart = SystemCall::getCurrentSystemTime();
+      shared.writerIdleStart = SystemCall::getCurrentSystemTime();
+      shared.writerIdle = true;
     }
+  }
+  while(running);
 
   if(file)
+  {
+    index.write(*file);
     delete file;
+  }
 }
 
+void Logger::writeBlock(MessageQueue& queue, std::vector<char>& compressedBuffer)
+{
+  if(queue.getNumberOfMessages() == 0)
+    return;
+
+  size_t size = compressedBuffer.size() - sizeof(unsigned);
+  VERIFY(snappy_compress(queue.getStreamedData(), queue.getStreamedSize(),
+                         compressedBuffer.data() + sizeof(unsigned), &size) == SNAPPY_OK);
+  (unsigned&)compressedBuffer[0] = static_cast<unsigned>(size);
+  if(!file)
+  {
+    // find next free log filename
+    std::string num = "";
+    for(int i = 0; i < 100; ++i)
+    {
+      if(i)
+      {
+        char buf[6];
+        sprintf(buf, "_(%02d)", i);
+        num = buf;
+      }
+      InBinaryFile stream(logFilename + num + ".log");
+      if(!stream.exists())
+        break;
+    }
+    logFilename += num + ".log";
+
+    file = new OutBinaryFile(logFilename);
+    ASSERT(file->exists());
+    *file << logFileMessageIDs;
+    queue.writeMessageIDs(*file);
+    *file << logFileStreamSpecification;
+    file->write(streamSpecification.data(), streamSpecification.size());
+    *file << logFileCompressedWithIndex; // Write magic byte that indicates a compressed log file with an index at its end
+    index.clear();
+  }
+  file->write(compressedBuffer.data(), size + sizeof(unsigned));
+  index.addBlock(static_cast<unsigned>(size), queue.getStreamedData(), queue.getStreamedSize());
+  queue.clear();
+
+  // Checking the free space here keeps the system call away from the logged thread
+  if(SystemCall::getFreeDiskSpace(logFilename.c_str()) >> 20 < parameters.minFreeSpace)
+    shared.diskFull = true;
+}
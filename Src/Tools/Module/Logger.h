@@ -30,6 +30,8 @@
 #include "Representations/Infrastructure/RobotInfo.h"
 #include "Representations/MotionControl/MotionRequest.h"
 #include "Tools/Cabsl.h"
+#include "Tools/MessageQueue/LogFileIndex.h"
+#include <atomic>
 
 class Logger : public Cabsl<Logger>
 {
@@ -44,6 +46,7 @@ private:
     (int) writePriority,
     (bool) debugStatistics,
     (unsigned) minFreeSpace, /**< Minimum free space left on the device in MB. */
+    (bool)(false) logTrace, /**< Log the starts and stops of all stopwatches of all threads? */
   });
 
   STREAMABLE(TeamList,
@@ -72,17 +75,40 @@ private:
   TeamList teamList; /**< The list of all teams for naming the log file after the opponent. */
   int blackboardVersion = 0; /**< The blackboard version the logger is currently configured for. */
   std::vector<Loggable> loggables; /**< The representations that should be logged. */
-  std::vector<MessageQueue*> buffer; /**< Ring buffer of message queues. Shared with the writer thread. */
+  /**
+   * The state shared with the writer thread. Cabsl collects its options by
+   * assigning a behavior to itself, so an assignment operator is provided
+   * that atomics do not have.
+   */
+  struct SharedState
+  {
+    std::atomic<int> readIndex{0}; /**< The first index of the buffer that should be read by the writer thread. */
+    std::atomic<int> writeIndex{0}; /**< Index of the buffer that is currently used for writing. */
+    std::atomic<bool> writerIdle{true}; /**< Is true if the writer thread has nothing to do. */
+    std::atomic<unsigned> writerIdleStart{0}; /**< The system time at which the writer thread went idle. */
+    std::atomic<bool> diskFull{false}; /**< Did the writer thread detect that less than minFreeSpace is left on the device? */
+
+    SharedState() = default;
+    SharedState& operator=(const SharedState&) {return *this;}
+  };
+
+  /**
+   * Ring buffer of preallocated message queues. Shared with the writer thread.
+   * The main thread is the only one that fills queues and advances writeIndex,
+   * the writer thread is the only one that empties queues and advances readIndex.
+   * Each index is published with release semantics after the queue it passes
+   * was completely filled or emptied, and read with acquire semantics by the
+   * other thread, so no lock is needed.
+   */
+  std::vector<MessageQueue*> buffer;
   std::string logFilename; /**< Path and name of the log file. Set in initial state. */
   bool receivedGameControllerPacket = false; /**< Ever received a packet from the GameController? */
-  volatile int readIndex = 0; /**< The first index of the buffer that should be read by the writer thread. */
-  volatile int writeIndex = 0; /**< Index of the buffer that is currently used for writing. */
+  SharedState shared;
   int frameCounter = 0; /**< Number of frames that are already in the current message queue. */
   Thread<Logger> writerThread;/**< Used to write the buffer to disk in the background */
-  Semaphore framesToWrite; /**< How many frames the writer thread should write? */
-  volatile bool writerIdle = true; /**< Is true if the writer thread has nothing to do. */
-  volatile unsigned writerIdleStart = 0; /**< The system time at which the writer thread went idle. */
+  Semaphore framesToWrite; /**< Only wakes up the writer thread. The queues to write are determined by the indices. */
   OutBinaryFile* file = nullptr; /**< The stream that writes the log file. */
+  LogFileIndex index; /**< The index of the blocks written. Appended to the log file when the writer thread ends. */
   std::vector<char> streamSpecification; /**< Streamed specification created in main thread and used in logger thread. */
   std::string processName; /**< The name of the process this logger is part of. */
   char processIdentifier; /**< The identifier of the logged process. */
@@ -105,19 +131,27 @@ private:
   /** Write contents of buffers to disk in the background. */
   void writeThread();
 
+  /**
+   * Compresses a block and writes it to the log file. Opens the file if
+   * this is the first block.
+   * @param queue The block.
+   * @param compressedBuffer Space for the compressed block and its size.
+   */
+  void writeBlock(MessageQueue& queue, std::vector<char>& compressedBuffer);
+
 
 
   /** Minimal behavior to handle logging. */
   option(Root)
   {
-    ASSERT(Blackboard::getInstance().exists("GameInfo"));
-    const GameInfo& gameInfo = static_cast<const GameInfo&>(Blackboard::getInstance()["GameInfo"]);
+    ASSERT(Blackboard::getInstance().exists(idGameInfo));
+    const GameInfo& gameInfo = static_cast<const GameInfo&>(Blackboard::getInstance()[idGameInfo]);
     receivedGameControllerPacket |= static_cast<const RoboCup::RoboCupGameControlData&>(gameInfo).packetNumber != 0 || gameInfo.secsRemaining != 0;
 
-    ASSERT(Blackboard::getInstance().exists("RobotInfo"));
-    const RobotInfo& robotInfo = static_cast<const RobotInfo&>(Blackboard::getInstance()["RobotInfo"]);
-    ASSERT(Blackboard::getInstance().exists("MotionInfo"));
-    const MotionRequest& motionInfo = static_cast<const MotionRequest&>(Blackboard::getInstance()["MotionInfo"]);
+    ASSERT(Blackboard::getInstance().exists(idRobotInfo));
+    const RobotInfo& robotInfo = static_cast<const RobotInfo&>(Blackboard::getInstance()[idRobotInfo]);
+    ASSERT(Blackboard::getInstance().exists(idMotionInfo));
+    const MotionRequest& motionInfo = static_cast<const MotionRequest&>(Blackboard::getInstance()[idMotionInfo]);
 
     const bool isInactive =
       robotInfo.penalty != PENALTY_NONE
@@ -175,7 +209,7 @@ private:
           goto delayPlaySound;
         else if (isInactive)
           goto paused;
-        else if(file && SystemCall::getFreeDiskSpace(logFilename.c_str()) >> 20 < parameters.minFreeSpace)
+        else if(shared.diskFull)
           goto error;
       }
       action
@@ -192,7 +226,7 @@ private:
           goto delayPlaySound;
         else if (!isInactive)
           goto running;
-        else if (file && SystemCall::getFreeDiskSpace(logFilename.c_str()) >> 20 < parameters.minFreeSpace)
+        else if (shared.diskFull)
           goto error;
       }
     }
@@ -203,7 +237,7 @@ private:
       {
         if(gameInfo.state == STATE_READY || gameInfo.state == STATE_SET || gameInfo.state == STATE_PLAYING)
           goto running;
-        else if(writerIdle && SystemCall::getTimeSince(writerIdleStart) > 5000 && state_time > 500)
+        else if(shared.writerIdle && SystemCall::getTimeSince(shared.writerIdleStart) > 5000 && state_time > 500)
           goto playSound;
       }
     }
@@ -142,6 +142,7 @@ private:
   const char* name; /**< The name of the module that can be created by this instance. */
   Category category; /**< The category of this module. */
   const Info* info; /**< Information about the requirements and provisions of the module. */
+  const char* const* uses; /**< The names of all representations used, but not required. Terminated by nullptr. */
 
 protected:
   /**
@@ -155,14 +156,23 @@ public:
    * Constructor.
    * @param name The name of the module that can be created by this instance.
    * @param category The category of this module.
+   * @param info Information about the requirements and provisions of the module.
+   * @param uses The names of all representations used, but not required.
    */
-  ModuleBase(const char* name, Category category, const Info* info) :
-    next(first), name(name), category(category), info(info)
+  ModuleBase(const char* name, Category category, const Info* info, const char* const* uses) :
+    next(first), name(name), category(category), info(info), uses(uses)
   {
     first = this;
+
+    // Assign the blackboard slots of all representations when the module is registered.
+    for(const Info* i = info; i->representation; ++i)
+      Blackboard::getSlot(i->representation);
+    for(const char* const* i = uses; *i; ++i)
+      Blackboard::getSlot(*i);
   }
 
   friend class ModuleManager; /**< The ModuleManager gathers all private data. */
+  friend class LogReplay; /**< The LogReplay determines which representations can be replayed from a log. */
 };
 
 /**
@@ -199,7 +209,7 @@ public:
    * @param category The category of this module.
    */
   Module(const char* name, Category category) :
-    ModuleBase(name, category, B::getModuleInfo())
+    ModuleBase(name, category, B::getModuleInfo(), B::getModuleUses())
   {}
 };
 
@@ -351,8 +361,8 @@ void loadModuleParameters(Streamable& parameters, const char* moduleName, const
     _MODULE_UNWRAP header; \
     _STREAM_STREAMABLE_I(_STREAM_TUPLE_SIZE(__VA_ARGS__), name, streamBase, __VA_ARGS__)
 #else
-#define _MODULE_PARAMETERS__MODULE_DEFINES_PARAMETERS(header, ...) _STREAM_STREAMABLE(Params, Streamable, , header, __VA_ARGS__); typedef Params NoParameters;
-#define _MODULE_PARAMETERS__MODULE_LOADS_PARAMETERS(header, ...) _STREAM_STREAMABLE(Params, Streamable, , header, __VA_ARGS__); typedef Params NoParameters;
+#define _MODULE_PARAMETERS__MODULE_DEFINES_PARAMETERS(header, ...) _STREAM_STREAMABLE(Params, Streamable, , , header, __VA_ARGS__); typedef Params NoParameters;
+#define _MODULE_PARAMETERS__MODULE_LOADS_PARAMETERS(header, ...) _STREAM_STREAMABLE(Params, Streamable, , , header, __VA_ARGS__); typedef Params NoParameters;
 #endif
 
 /**
@@ -411,6 +421,19 @@ void loadModuleParameters(Streamable& parameters, const char* moduleName, const
 #define _MODULE_INFO__MODULE_DEFINES_PARAMETERS(...)
 #define _MODULE_INFO__MODULE_LOADS_PARAMETERS(...)
 
+/**
+ * The following macros generate the list of all representations that are used,
+ * but not required. They filter out all other macro names.
+ * @param x The type name of a representation or the set of all parameters.
+ */
+#define _MODULE_USED(x) _MODULE_JOIN(_MODULE_USED_, x)
+#define _MODULE_USED_PROVIDES(type)
+#define _MODULE_USED_PROVIDES_WITHOUT_MODIFY(type)
+#define _MODULE_USED_REQUIRES(type)
+#define _MODULE_USED_USES(type) #type,
+#define _MODULE_USED__MODULE_DEFINES_PARAMETERS(...)
+#define _MODULE_USED__MODULE_LOADS_PARAMETERS(...)
+
 /**
  * Assign message id for a representation.
  * @param type The type of the representation the id of which is assigned.
@@ -449,14 +472,14 @@ void loadModuleParameters(Streamable& parameters, const char* moduleName, const
  * @param n The number of entries in the third parameter.
  * @param ... The requirementes, provided representations and parameter definitions.
  */
-#define _MODULE_I(name, n, ...) _MODULE_II(name, n, (_MODULE_PARAMETERS, __VA_ARGS__), (_MODULE_LOAD, __VA_ARGS__), (_MODULE_DECLARE, __VA_ARGS__), (_MODULE_FREE, __VA_ARGS__), (_MODULE_INFO, __VA_ARGS__))
+#define _MODULE_I(name, n, ...) _MODULE_II(name, n, (_MODULE_PARAMETERS, __VA_ARGS__), (_MODULE_LOAD, __VA_ARGS__), (_MODULE_DECLARE, __VA_ARGS__), (_MODULE_FREE, __VA_ARGS__), (_MODULE_INFO, __VA_ARGS__), (_MODULE_USED, __VA_ARGS__))
 
 /**
  * Generates the actual code of the module's base class.
  * It create all the code and fills in data from the requirements, representations,
  * provided, and parameters defined.
  */
-#define _MODULE_II(name, n, params, load, declare, free, info) \
+#define _MODULE_II(name, n, params, load, declare, free, info, used) \
   namespace name##Module \
   { \
     _MODULE_ATTR_##n params \
@@ -482,6 +505,15 @@ void loadModuleParameters(Streamable& parameters, const char* moduleName, const
       }; \
       return infos; \
     } \
+    static const char* const* getModuleUses() \
+    { \
+      static const char* const uses[] = \
+      { \
+        _MODULE_ATTR_##n used \
+        nullptr \
+      }; \
+      return uses; \
+    } \
     friend class Module<name, name##Base>; \
     _MODULE_ATTR_##n declare \
   public: \
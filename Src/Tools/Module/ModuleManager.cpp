@@ -6,7 +6,10 @@
 
 #include "ModuleManager.h"
 #include "Platform/BHAssert.h"
+#include "Tools/Debugging/AllocationCounter.h"
+#include "Tools/Debugging/DebugDrawings.h"
 #include <algorithm>
+#include <cstring>
 
 ModuleManager::Configuration::RepresentationProvider::RepresentationProvider(const std::string& representation,
                                                                              const std::string& provider) :
@@ -144,6 +147,9 @@ bool ModuleManager::calcShared(const Configuration& config, const std::string& r
 
 void ModuleManager::update(In& stream, unsigned timeStamp)
 {
+  taskGraphValid = false;
+  budgetsValid = false;
+
   std::list<Provider> providersBackup(providers);
   std::list<const char*> sentBackup(sent),
                          receivedBackup(received);
@@ -289,37 +295,247 @@ void ModuleManager::load()
   update(stream, 0xffffffff);
 }
 
-int interpolationFrameCounter = 0;
+void ModuleManager::loadExecutionParameters(const std::string& processName)
+{
+  InMapFile stream("moduleManager" + processName + ".cfg");
+  if(stream.exists())
+    stream >> executionParameters;
 
-void ModuleManager::execute()
+  if(executionParameters.parallel)
+  {
+    executor = std::unique_ptr<ParallelExecutor>(new ParallelExecutor(processName));
+    executor->start(executionParameters.numOfWorkers, executionParameters.workerPriority);
+  }
+  else
+    executor = nullptr;
+  taskGraphValid = false;
+  budgetsValid = false;
+}
+
+void ModuleManager::assignBudgets()
 {
-  interpolationFrameCounter++;
-  // Execute all providers in the given sequence
+  const std::vector<ProviderBudget>& budgets = executionParameters.providerBudgets;
+  for(auto& p : providers)
+  {
+    p.budget = -1;
+    for(size_t i = 0; i < budgets.size(); ++i)
+      if(budgets[i].representation == p.representation)
+        p.budget = static_cast<int>(i);
+  }
+  budgetsValid = true;
+}
+
+void ModuleManager::calcReserves()
+{
+  float reserve = 0.f;
+  for(auto p = providers.rbegin(); p != providers.rend(); ++p)
+    if(p->moduleState->required)
+    {
+      p->reserve = reserve;
+      if(p->budget == -1 || executionParameters.providerBudgets[p->budget].budgetClass == ProviderBudget::essential)
+        reserve += p->averageDuration;
+    }
+}
+
+void ModuleManager::updateBudgetState()
+{
+  budgetState.frameDuration = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+  budgetState.numOfSkipped = 0;
+  size_t numOfProviders = 0;
+  for(const auto& p : providers)
+    if(p.moduleState->required && p.budget != -1)
+    {
+      if(numOfProviders == budgetState.providers.size())
+        budgetState.providers.emplace_back();
+      BudgetState::ProviderState& state = budgetState.providers[numOfProviders++];
+      state.representation = p.representation;
+      state.averageDuration = p.averageDuration;
+      state.budget = executionParameters.providerBudgets[p.budget].budget;
+      state.overruns = p.overruns;
+      state.skippedFrames = p.skippedFrames;
+      if(p.skippedFrames)
+        ++budgetState.numOfSkipped;
+    }
+  budgetState.providers.resize(numOfProviders);
+
+  MODIFY("module:ModuleManager:budgets", budgetState);
+  PLOT("module:ModuleManager:frameDuration", budgetState.frameDuration);
+  PLOT("module:ModuleManager:numOfSkipped", budgetState.numOfSkipped);
+}
+
+void ModuleManager::createTaskGraph()
+{
+  scheduled.clear();
   for(auto& p : providers)
     if(p.moduleState->required)
+      scheduled.push_back(&p);
+
+  const std::vector<std::string>& unsafe = executionParameters.threadUnsafeModules;
+  const std::vector<std::string>& perCameraModules = executionParameters.perCameraModules;
+  const size_t size = scheduled.size();
+  std::vector<bool> threadUnsafe(size);
+  std::vector<bool> perCamera(size);
+  for(size_t i = 0; i < size; ++i)
+  {
+    threadUnsafe[i] = std::find(unsafe.begin(), unsafe.end(), scheduled[i]->moduleState->module->name) != unsafe.end();
+    perCamera[i] = std::find(perCameraModules.begin(), perCameraModules.end(), scheduled[i]->moduleState->module->name) != perCameraModules.end();
+  }
+
+  // Does a module read a certain representation?
+  auto readsFromModule = [](const ModuleBase* module, const char* representation)
+  {
+    for(const ModuleBase::Info* i = module->info; i->representation; ++i)
+      if(!i->update && !strcmp(i->representation, representation))
+        return true;
+    for(const char* const* i = module->uses; *i; ++i)
+      if(!strcmp(*i, representation))
+        return true;
+    return false;
+  };
+
+  // Is a representation one of the upper camera?
+  auto isUpper = [](const char* representation)
+  {
+    const size_t length = strlen(representation);
+    return length > 5 && !strcmp(representation + length - 5, "Upper");
+  };
+
+  // Does a provider read a certain representation? The provider of a per-camera module
+  // does not read the representations of the other camera. A representation without
+  // the suffix "Upper" belongs to the lower camera if its upper counterpart is read as well.
+  auto reads = [&](size_t provider, const char* representation)
+  {
+    const ModuleBase* module = scheduled[provider]->moduleState->module;
+    if(!readsFromModule(module, representation))
+      return false;
+    else if(!perCamera[provider])
+      return true;
+    else if(isUpper(scheduled[provider]->representation))
+      return isUpper(representation) || !readsFromModule(module, (std::string(representation) + "Upper").c_str());
+    else
+      return !isUpper(representation);
+  };
+
+  // Do two providers of the same module share state?
+  auto shareState = [&](size_t i, size_t j)
+  {
+    return scheduled[i]->moduleState == scheduled[j]->moduleState &&
+           (!perCamera[i] || isUpper(scheduled[i]->representation) == isUpper(scheduled[j]->representation));
+  };
+
+  // reachable[j][i]: Provider j (transitively) depends on provider i.
+  std::vector<std::vector<bool>> reachable(size, std::vector<bool>(size));
+  std::vector<ParallelExecutor::Task> tasks(size);
+  for(size_t j = 0; j < size; ++j)
+  {
+    std::vector<size_t> predecessors;
+    for(size_t i = j; i-- > 0;)
+    {
+      if(!reachable[j][i] &&
+         (threadUnsafe[i] || threadUnsafe[j] || shareState(i, j) ||
+          reads(j, scheduled[i]->representation) || reads(i, scheduled[j]->representation)))
+      {
+        // Searching backwards, everything i depends on is already reached through i.
+        predecessors.push_back(i);
+        reachable[j][i] = true;
+        for(size_t k = 0; k < i; ++k)
+          if(reachable[i][k])
+            reachable[j][k] = true;
+      }
+    }
+    for(size_t i : predecessors)
+      tasks[i].successors.push_back(static_cast<int>(j));
+    tasks[j].numOfPredecessors = static_cast<int>(predecessors.size());
+    tasks[j].processThreadOnly = threadUnsafe[j];
+  }
+
+  executor->setTasks(tasks, [this](int task) {execute(*scheduled[task]);});
+  taskGraphValid = true;
+}
+
+int interpolationFrameCounter = 0;
+
+void ModuleManager::execute(Provider& p)
+{
+  if(!p.moduleState->instance)
+    p.moduleState->instance = p.moduleState->module->createNew(); // returns 0 if provided by "default"
+
+  // Skip optional providers if the essential ones would not be finished in time otherwise.
+  // Providers that were never executed are not skipped, because nothing is known about them.
+  const ProviderBudget* budget = p.budget == -1 ? nullptr : &executionParameters.providerBudgets[p.budget];
+  if(budget && budget->budgetClass == ProviderBudget::optional && executionParameters.frameBudget > 0.f &&
+     p.skippedFrames < budget->maxSkippedFrames && p.averageDuration > 0.f)
+  {
+    const float elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    if(elapsed + p.averageDuration + p.reserve > executionParameters.frameBudget)
     {
-      if(!p.moduleState->instance)
-        p.moduleState->instance = p.moduleState->module->createNew(); // returns 0 if provided by "default"
+      ++p.skippedFrames;
+      return;
+    }
+  }
+  p.skippedFrames = 0;
+
+  const unsigned allocations = AllocationCounter::getCount();
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 #ifdef TARGET_ROBOT
-      unsigned timeStamp = SystemCall::getCurrentSystemTime();
+  unsigned timeStamp = SystemCall::getCurrentSystemTime();
 #endif
-      if(p.moduleState->instance)
-        p.update(*p.moduleState->instance);
+  if(p.moduleState->instance)
+    p.update(*p.moduleState->instance);
+  const float providerDuration = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if(p.averageDuration > 0.f)
+    p.averageDuration += (providerDuration - p.averageDuration) * executionParameters.averagingFactor;
+  else
+    p.averageDuration = providerDuration;
+  if(budget && budget->budget > 0.f && providerDuration > budget->budget)
+    ++p.overruns;
+  if(observer && p.moduleState->instance)
+    observer->providerExecuted(p.representation, p.moduleState->module->name, providerDuration,
+                               AllocationCounter::getCount() - allocations);
 #ifdef TARGET_ROBOT
-      int duration = SystemCall::getTimeSince(timeStamp);
-      if(timeStamp > 20000 &&
-         ((duration > 100 &&
-           !Global::getDebugRequestTable().isActive("representation:JPEGImage") &&
-           !Global::getDebugRequestTable().isActive("representation:JPEGImageUpper") &&
-           !Global::getDebugRequestTable().isActive("representation:Image") &&
-           !Global::getDebugRequestTable().isActive("representation:ImageUpper")) ||
-          duration > 500))
-        TRACE("TIMING: providing %s took %d ms at %d s after base",
-              p.representation, duration, timeStamp / 1000 - 10);
+  int duration = SystemCall::getTimeSince(timeStamp);
+  if(timeStamp > 20000 &&
+     ((duration > 100 &&
+       !Global::getDebugRequestTable().isActive("representation:JPEGImage") &&
+       !Global::getDebugRequestTable().isActive("representation:JPEGImageUpper") &&
+       !Global::getDebugRequestTable().isActive("representation:Image") &&
+       !Global::getDebugRequestTable().isActive("representation:ImageUpper")) ||
+      duration > 500))
+    TRACE("TIMING: providing %s took %d ms at %d s after base",
+          p.representation, duration, timeStamp / 1000 - 10);
 #endif
-    }
+}
+
+void ModuleManager::execute()
+{
+  interpolationFrameCounter++;
+
+  frameStart = std::chrono::steady_clock::now();
+  if(!budgetsValid)
+    assignBudgets();
+  calcReserves();
+
+  // The debugging infrastructure is not thread-safe. Therefore, providers are only
+  // executed in parallel as long as no debug requests are active. The first frame
+  // after a configuration change is always executed serially, because it creates
+  // the modules and allocates their representations in the blackboard.
+  if(executor && taskGraphValid &&
+     !Global::getDebugRequestTable().poll && Global::getDebugRequestTable().currentNumberOfDebugRequests == 0)
+    executor->execute();
+  else
+  {
+    // Execute all providers in the given sequence
+    for(auto& p : providers)
+      if(p.moduleState->required)
+        execute(p);
+
+    if(executor && !taskGraphValid)
+      createTaskGraph();
+  }
   BH_TRACE;
 
+  updateBudgetState();
+
   if(!timeStamp) // Configuration changed recently?
   { // all representations must be constructed now, so we can receive data
     timeStamp = nextTimeStamp;
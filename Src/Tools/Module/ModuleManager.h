@@ -7,9 +7,12 @@
 #pragma once
 
 #include "Module.h"
+#include "ParallelExecutor.h"
 #include "Tools/Streams/AutoStreamable.h"
+#include <chrono>
 #include <list>
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -54,6 +57,11 @@ private:
     const char* representation; /**< The representation that will be provided. */
     ModuleState* moduleState; /**< The moduleState that will give access to the module that provides the information. */
     void (*update)(Streamable&); /**< The update handler within the module. */
+    int budget = -1; /**< The index of the budget of this provider in the execution parameters. -1 if it has none. */
+    float averageDuration = 0.f; /**< The average time the provider needed in ms. */
+    float reserve = 0.f; /**< The average time the essential providers executed after this one need in ms. */
+    unsigned skippedFrames = 0; /**< The number of consecutive frames this provider was skipped. */
+    unsigned overruns = 0; /**< The number of frames the provider exceeded its budget. */
 
     /**
      * Constructor.
@@ -96,6 +104,79 @@ public:
     (std::vector<RepresentationProvider>) representationProviders,
   });
 
+  /**
+   * An interface for observing the execution of the providers, e.g. for benchmarking.
+   * If providers are executed in parallel, it is called from the worker threads.
+   */
+  class Observer
+  {
+  public:
+    virtual ~Observer() = default;
+
+    /**
+     * The method is called after a provider was executed.
+     * @param representation The name of the representation provided.
+     * @param module The name of the module that provided it.
+     * @param duration The time the provider needed in ms.
+     * @param allocations The number of heap allocations done by the provider.
+     *                    Always 0 if NDEBUG is defined.
+     */
+    virtual void providerExecuted(const char* representation, const char* module, float duration, unsigned allocations) = 0;
+  };
+
+  /**
+   * The budget of a provider.
+   */
+  STREAMABLE(ProviderBudget,
+  {
+    /** How providers are treated if a frame is running late. */
+    ENUM(BudgetClass,
+    {,
+      essential, /**< The provider is always executed. */
+      optional, /**< The provider is skipped if the frame is running late. Its representation then keeps last frame's contents. */
+    }),
+
+    (std::string) representation, /**< The representation provided. */
+    (float)(0.f) budget, /**< The soft budget in ms. Exceeding it is counted. 0 if there is none. */
+    (BudgetClass)(essential) budgetClass,
+    (unsigned)(2) maxSkippedFrames, /**< An optional provider is executed at least every maxSkippedFrames + 1 frames. */
+  });
+
+  /**
+   * The parameters for executing independent providers in parallel.
+   */
+  STREAMABLE(ExecutionParameters,
+  {,
+    (bool)(false) parallel, /**< Execute providers that do not depend on each other in parallel? */
+    (unsigned)(2) numOfWorkers, /**< The number of worker threads in addition to the process thread. */
+    (int)(0) workerPriority, /**< The priority of the worker threads. */
+    (std::vector<std::string>) threadUnsafeModules, /**< Modules that are executed in serial order in the process thread. */
+    (std::vector<std::string>) perCameraModules, /**< Modules whose providers for the upper and the lower camera are independent. */
+    (float)(0.f) frameBudget, /**< The time available for executing all providers in ms. 0 disables skipping. */
+    (float)(0.1f) averagingFactor, /**< The weight of the latest duration in the average durations of the providers. */
+    (std::vector<ProviderBudget>) providerBudgets,
+  });
+
+  /**
+   * The state of all providers that have a budget. It is updated every frame
+   * and can be inspected with "vd module:ModuleManager:budgets".
+   */
+  STREAMABLE(BudgetState,
+  {
+    STREAMABLE(ProviderState,
+    {,
+      (std::string) representation,
+      (float)(0.f) averageDuration, /**< The average time the provider needed in ms. */
+      (float)(0.f) budget, /**< The soft budget in ms. */
+      (unsigned)(0) overruns, /**< The number of frames the provider exceeded its budget. */
+      (unsigned)(0) skippedFrames, /**< The number of consecutive frames the provider was skipped. 0 if executed in this frame. */
+    }),
+
+    (float)(0.f) frameDuration, /**< The time needed to execute all providers in the last frame in ms. */
+    (unsigned)(0) numOfSkipped, /**< The number of providers skipped in the last frame. */
+    (std::vector<ProviderState>) providers,
+  });
+
 private:
   Configuration config; /**< The last configuration set. It may not work. */
   std::list<Provider> providers; /**< The list of providers that will be executed. */
@@ -107,6 +188,14 @@ private:
   std::vector<Streamable*> toReceive; /**< The list of all representations received from the other process */
   unsigned timeStamp = 0; /**< The timestamp of the last module request. Communication is only possible if both sides use the same timestamp. */
   unsigned nextTimeStamp = 0; /**< The next timestamp used to verify communication. */
+  ExecutionParameters executionParameters; /**< The parameters for the parallel execution of providers. */
+  std::unique_ptr<ParallelExecutor> executor; /**< Executes the providers in parallel if enabled. */
+  std::vector<Provider*> scheduled; /**< The providers executed in parallel in their serial order. */
+  bool taskGraphValid = false; /**< Does the task graph of the executor match the current providers? */
+  bool budgetsValid = false; /**< Are the budgets assigned to the current providers? */
+  std::chrono::steady_clock::time_point frameStart; /**< When the execution of the providers started in this frame. */
+  BudgetState budgetState; /**< The state of all providers that have a budget. */
+  Observer* observer = nullptr; /**< Is informed about every provider executed. Not owned. */
 
 public:
   /**
@@ -128,6 +217,15 @@ public:
    */
   void load();
 
+  /**
+   * The method loads the parameters for the parallel execution of providers
+   * from the file "moduleManager<processName>.cfg" and starts the worker threads
+   * if parallel execution is enabled. Without such a file, all providers are
+   * executed in serial order.
+   * @param processName The name of the process this module manager belongs to.
+   */
+  void loadExecutionParameters(const std::string& processName);
+
   /**
    * The method destroys all modules. It can be called to destroy the modules
    * before the constructor is called.
@@ -146,6 +244,12 @@ public:
    */
   void execute();
 
+  /**
+   * The method sets an observer that is informed about every provider executed.
+   * @param observer The observer or nullptr to remove the current one.
+   */
+  void setObserver(Observer* observer) {this->observer = observer;}
+
   /**
    * The method reads a package from a stream.
    * @param stream A stream containing representations received from another process.
@@ -199,6 +303,43 @@ private:
    */
   bool sortProviders(const std::list<std::string>& providedByDefault);
 
+  /**
+   * The method executes a single provider. Optional providers are skipped
+   * if they would delay the essential ones beyond the frame budget.
+   * @param p The provider.
+   */
+  void execute(Provider& p);
+
+  /**
+   * The method assigns the budgets from the execution parameters to the providers.
+   */
+  void assignBudgets();
+
+  /**
+   * The method determines for all providers how much time the essential
+   * providers executed after them will need.
+   */
+  void calcReserves();
+
+  /**
+   * The method updates the budget state and its debug output after a frame.
+   */
+  void updateBudgetState();
+
+  /**
+   * The method creates the task graph for the parallel execution of all
+   * providers currently required. A provider depends on all earlier ones it
+   * shares its module with, that provide a representation it requires or uses,
+   * or that require or use a representation it provides. Thereby, all
+   * representations are still written only once per frame and read in the
+   * same state as in serial execution. Providers of thread-unsafe modules
+   * depend on all earlier providers and all later providers depend on them.
+   * Per-camera modules are treated as two modules, one per camera. Their
+   * providers of one camera neither depend on those of the other camera nor
+   * on the representations of the other camera they require.
+   */
+  void createTaskGraph();
+
   /**
    * The method restores a previous module configuration.
    * It is called after it was determined that the new configuration is invalid.
@@ -0,0 +1,240 @@
+/**
+ * @file ParallelExecutor.cpp
+ * Implementation of a class that executes a fixed graph of tasks on a small pool of
+ * worker threads.
+ */
+
+#include "ParallelExecutor.h"
+#include "Blackboard.h"
+#include "Tools/Global.h"
+
+/** A message handler that appends all messages it receives to an output queue. */
+class MessageForwarder : public MessageHandler
+{
+private:
+  OutMessage& out; /**< The queue the messages are appended to. */
+  std::vector<char> buffer; /**< The contents of the message copied. */
+
+public:
+  MessageForwarder(OutMessage& out) : out(out) {}
+
+  bool handleMessage(InMessage& message) override
+  {
+    buffer.resize(message.getMessageSize());
+    message.bin.read(buffer.data(), buffer.size());
+    out.bin.write(buffer.data(), buffer.size());
+    return out.finishMessage(message.getMessageID());
+  }
+};
+
+ParallelExecutor::Worker::Worker(ParallelExecutor& executor, int index) :
+  executor(executor), index(index)
+{
+  if(index)
+    debugOut.setSize(1000000);
+}
+
+ParallelExecutor::ParallelExecutor(const std::string& name) :
+  name(name)
+{}
+
+ParallelExecutor::~ParallelExecutor()
+{
+  stop();
+}
+
+void ParallelExecutor::start(unsigned numOfWorkers, int priority)
+{
+  stop();
+  for(int i = 0; i <= static_cast<int>(numOfWorkers); ++i)
+    workers.emplace_back(new Worker(*this, i));
+  for(size_t i = 1; i < workers.size(); ++i)
+  {
+    workers[i]->thread.setPriority(priority);
+    workers[i]->thread.start(workers[i].get(), &Worker::main);
+  }
+}
+
+void ParallelExecutor::stop()
+{
+  for(size_t i = 1; i < workers.size(); ++i)
+    workers[i]->thread.announceStop();
+  for(size_t i = 1; i < workers.size(); ++i)
+    workAvailable.post();
+  for(size_t i = 1; i < workers.size(); ++i)
+    workers[i]->thread.stop();
+  workers.clear();
+}
+
+void ParallelExecutor::setTasks(const std::vector<Task>& tasks, const std::function<void(int)>& run)
+{
+  this->tasks = tasks;
+  this->run = run;
+  pending.reset(new std::atomic<int>[tasks.size()]);
+}
+
+void ParallelExecutor::execute()
+{
+  ++frame;
+  globals.annotationManager = Global::theAnnotationManager;
+  globals.debugOut = Global::theDebugOut;
+  globals.teamOut = Global::theTeamOut;
+  globals.settings = Global::theSettings;
+  globals.debugRequestTable = Global::theDebugRequestTable;
+  globals.debugDataTable = Global::theDebugDataTable;
+  globals.streamHandler = Global::theStreamHandler;
+  globals.drawingManager = Global::theDrawingManager;
+  globals.drawingManager3D = Global::theDrawingManager3D;
+  globals.timingManager = Global::theTimingManager;
+  globals.ntp = Global::theNTP;
+  globals.blackboard = &Blackboard::getInstance();
+
+  // Wake ups from the previous frame are obsolete.
+  while(processThreadWakeUp.tryWait());
+
+  remaining = static_cast<int>(tasks.size());
+  for(size_t i = 0; i < tasks.size(); ++i)
+    pending[i] = tasks[i].numOfPredecessors;
+
+  // Distribute the tasks without predecessors over all workers.
+  size_t next = 0;
+  for(size_t i = 0; i < tasks.size(); ++i)
+    if(!tasks[i].numOfPredecessors)
+    {
+      push(*workers[next], static_cast<int>(i), true);
+      next = (next + 1) % workers.size();
+    }
+
+  Worker& self = *workers[0];
+  while(remaining > 0)
+    if(!executeNext(self))
+      processThreadWakeUp.wait();
+
+  forwardDebugOut();
+}
+
+void ParallelExecutor::forwardDebugOut()
+{
+  MessageForwarder forwarder(*globals.debugOut);
+  for(size_t i = 1; i < workers.size(); ++i)
+    if(!workers[i]->debugOut.isEmpty())
+    {
+      workers[i]->debugOut.handleAllMessages(forwarder);
+      workers[i]->debugOut.clear();
+    }
+}
+
+bool ParallelExecutor::executeNext(Worker& worker)
+{
+  int task = -1;
+  if(worker.index == 0)
+  {
+    SYNC;
+    if(!processThreadReady.empty())
+    {
+      task = processThreadReady.front();
+      processThreadReady.pop_front();
+    }
+  }
+
+  if(task < 0)
+  {
+    SYNC_WITH(worker);
+    if(!worker.ready.empty())
+    {
+      task = worker.ready.back();
+      worker.ready.pop_back();
+    }
+  }
+
+  for(size_t i = 1; task < 0 && i < workers.size(); ++i)
+  {
+    Worker& victim = *workers[(worker.index + i) % workers.size()];
+    SYNC_WITH(victim);
+    if(!victim.ready.empty())
+    {
+      task = victim.ready.front();
+      victim.ready.pop_front();
+    }
+  }
+
+  if(task < 0)
+    return false;
+
+  execute(worker, task);
+  return true;
+}
+
+void ParallelExecutor::execute(Worker& worker, int task)
+{
+  if(worker.index != 0 && worker.frame != frame)
+  {
+    setGlobals(worker);
+    worker.frame = frame;
+  }
+
+  run(task);
+
+  // The first successor that becomes ready is executed by this worker next,
+  // so only the others need to wake up someone else.
+  bool notify = false;
+  for(int successor : tasks[task].successors)
+    if(--pending[successor] == 0)
+    {
+      push(worker, successor, notify || tasks[successor].processThreadOnly);
+      notify |= !tasks[successor].processThreadOnly;
+    }
+
+  if(--remaining == 0)
+    processThreadWakeUp.post();
+}
+
+void ParallelExecutor::push(Worker& worker, int task, bool notify)
+{
+  if(tasks[task].processThreadOnly)
+  {
+    {
+      SYNC;
+      processThreadReady.push_back(task);
+    }
+    processThreadWakeUp.post();
+  }
+  else
+  {
+    {
+      SYNC_WITH(worker);
+      worker.ready.push_back(task);
+    }
+    if(notify)
+    {
+      workAvailable.post();
+      processThreadWakeUp.post();
+    }
+  }
+}
+
+void ParallelExecutor::setGlobals(Worker& worker) const
+{
+  Global::theAnnotationManager = globals.annotationManager;
+  Global::theDebugOut = &worker.debugOut.out;
+  Global::theTeamOut = globals.teamOut;
+  Global::theSettings = globals.settings;
+  Global::theDebugRequestTable = globals.debugRequestTable;
+  Global::theDebugDataTable = globals.debugDataTable;
+  Global::theStreamHandler = globals.streamHandler;
+  Global::theDrawingManager = globals.drawingManager;
+  Global::theDrawingManager3D = globals.drawingManager3D;
+  Global::theTimingManager = globals.timingManager;
+  Global::theNTP = globals.ntp;
+  Blackboard::setInstance(*globals.blackboard);
+}
+
+void ParallelExecutor::Worker::main()
+{
+  Thread<Worker>::setName(executor.name + "Worker" + std::to_string(index));
+  BH_TRACE_INIT((executor.name + "Worker" + std::to_string(index)).c_str());
+
+  while(thread.isRunning())
+    if(executor.workAvailable.wait(100))
+      while(executor.executeNext(*this));
+}
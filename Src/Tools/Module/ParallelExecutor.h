@@ -0,0 +1,167 @@
+/**
+ * @file ParallelExecutor.h
+ * Declaration of a class that executes a fixed graph of tasks on a small pool of
+ * worker threads. Every worker owns a deque of tasks that are ready to be executed.
+ * It takes work from the back of its own deque and steals from the front of the
+ * deques of the other workers if it ran out of work. The thread calling execute()
+ * takes part as worker 0.
+ */
+
+#pragma once
+
+#include "Platform/Semaphore.h"
+#include "Platform/Thread.h"
+#include "Tools/MessageQueue/MessageQueue.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class AnnotationManager;
+class Blackboard;
+class DebugDataTable;
+class DebugRequestTable;
+class DrawingManager;
+class DrawingManager3D;
+class NTP;
+class StreamHandler;
+class TeamDataOut;
+class TimingManager;
+struct Settings;
+
+class ParallelExecutor
+{
+public:
+  /** A node of the task graph. */
+  struct Task
+  {
+    std::vector<int> successors; /**< The tasks that have to wait for this one. */
+    int numOfPredecessors = 0; /**< The number of tasks this one has to wait for. */
+    bool processThreadOnly = false; /**< Must this task be executed by the thread that calls execute()? */
+  };
+
+private:
+  /** The state of a single worker. */
+  class Worker
+  {
+  public:
+    ParallelExecutor& executor; /**< The executor this worker belongs to. */
+    const int index; /**< The index of this worker. 0 is the thread that calls execute(). */
+    std::deque<int> ready; /**< The tasks ready to run. The owner works at the back, thieves at the front. */
+    DECLARE_SYNC; /**< Protects "ready". */
+    Thread<Worker> thread; /**< The thread of this worker. Not started for worker 0. */
+    unsigned frame = 0; /**< The frame the process globals were copied for the last time. */
+    MessageQueue debugOut; /**< The debug messages sent in this frame. Forwarded to the process after the frame. Not used by worker 0. */
+
+    Worker(ParallelExecutor& executor, int index);
+
+    /** The main function of the worker thread. */
+    void main();
+  };
+
+  /** The pointers to the globals of the process that are copied to the worker threads. */
+  struct Globals
+  {
+    AnnotationManager* annotationManager;
+    OutMessage* debugOut;
+    TeamDataOut* teamOut;
+    Settings* settings;
+    DebugRequestTable* debugRequestTable;
+    DebugDataTable* debugDataTable;
+    StreamHandler* streamHandler;
+    DrawingManager* drawingManager;
+    DrawingManager3D* drawingManager3D;
+    TimingManager* timingManager;
+    NTP* ntp;
+    Blackboard* blackboard;
+  };
+
+  std::string name; /**< The name of the process. Used to name the worker threads. */
+  std::vector<std::unique_ptr<Worker>> workers; /**< All workers. Worker 0 is the thread that calls execute(). */
+  std::vector<Task> tasks; /**< The task graph. */
+  std::unique_ptr<std::atomic<int>[]> pending; /**< The number of predecessors each task still waits for in this frame. */
+  std::atomic<int> remaining; /**< The number of tasks not finished in this frame. */
+  std::deque<int> processThreadReady; /**< The tasks ready to run that must be executed by worker 0. */
+  DECLARE_SYNC; /**< Protects "processThreadReady". */
+  Semaphore workAvailable; /**< Posted when a task was added that any worker can execute. */
+  Semaphore processThreadWakeUp; /**< Posted when worker 0 might have something to do. */
+  std::function<void(int)> run; /**< The function that executes a task. */
+  Globals globals; /**< The globals of the process in the current frame. */
+  unsigned frame = 0; /**< The number of the current frame. */
+
+  /**
+   * Take a task from the worker's own deque or steal one from another worker
+   * and execute it.
+   * @param worker The worker looking for work.
+   * @return Was a task executed?
+   */
+  bool executeNext(Worker& worker);
+
+  /**
+   * Execute a task and make its successors ready if they do not wait for
+   * anything else anymore.
+   * @param worker The worker executing the task.
+   * @param task The index of the task.
+   */
+  void execute(Worker& worker, int task);
+
+  /**
+   * Add a task to the tasks ready to run.
+   * @param worker The worker the deque of which receives the task.
+   * @param task The index of the task.
+   * @param notify Wake up other workers that could execute the task?
+   */
+  void push(Worker& worker, int task, bool notify);
+
+  /**
+   * Copy the globals of the process to the calling worker thread. The worker
+   * gets its own debug output, because the message queue is not thread-safe.
+   * @param worker The worker the calling thread belongs to.
+   */
+  void setGlobals(Worker& worker) const;
+
+  /** Append the debug messages the worker threads sent in this frame to the ones of the process. */
+  void forwardDebugOut();
+
+public:
+  /**
+   * Constructor.
+   * @param name The name of the process. Used to name the worker threads.
+   */
+  ParallelExecutor(const std::string& name);
+
+  /** Destructor. Stops all worker threads. */
+  ~ParallelExecutor();
+
+  /**
+   * Start the worker threads. Stops the ones running before.
+   * @param numOfWorkers The number of worker threads in addition to the calling thread.
+   * @param priority The priority of the worker threads.
+   */
+  void start(unsigned numOfWorkers, int priority);
+
+  /** Stop all worker threads. */
+  void stop();
+
+  /**
+   * Is the executor ready to execute the task graph?
+   * @return Were workers started and tasks set?
+   */
+  bool isReady() const {return !workers.empty() && !tasks.empty();}
+
+  /**
+   * Replace the task graph.
+   * @param tasks The new tasks. Successors must always have higher indices
+   *              than their predecessors.
+   * @param run The function that executes a task given its index.
+   */
+  void setTasks(const std::vector<Task>& tasks, const std::function<void(int)>& run);
+
+  /**
+   * Execute all tasks once and wait until they are finished. Must always
+   * be called from the same thread.
+   */
+  void execute();
+};
@@ -0,0 +1,385 @@
+/**
+ * @file ConvNetwork.cpp
+ * Implementation of a small inference engine for the convolutional networks of the
+ * YOLO detectors.
+ */
+
+#include "ConvNetwork.h"
+#include "Platform/BHAssert.h"
+#include "Tools/Streams/InStreams.h"
+#include <algorithm>
+#include <cstring>
+#include <emmintrin.h>
+#include <limits>
+
+namespace
+{
+  /**
+   * Computes up to 4 * blocks output channels of a row of pixels as the product
+   * of their im2col patches with the weight matrix. The accumulators stay in
+   * registers. Two pixels share the weights loaded if there are at most two
+   * blocks, so no more than 8 SSE registers are needed (32 bit targets).
+   * @param patches The im2col patches of the pixels.
+   * @param pixels The number of pixels.
+   * @param size The number of elements of a patch.
+   * @param weights The first weights of the channels computed.
+   * @param stride The distance between the weights of two patch elements.
+   * @param bias The biases of the channels computed.
+   * @param output The first output channel computed of the first pixel.
+   * @param outputStride The distance between the outputs of two pixels.
+   * @param channels The number of output channels actually stored.
+   * @param activation Apply a leaky ReLU?
+   * @param alpha The slope of the leaky ReLU.
+   */
+  template<int blocks>
+  void gemm(const float* patches, unsigned pixels, unsigned size, const float* weights, unsigned stride,
+            const float* bias, float* output, unsigned outputStride, unsigned channels, bool activation, float alpha)
+  {
+    const __m128 a = _mm_set1_ps(alpha);
+    float result[8 * blocks];
+    unsigned x = 0;
+    if(blocks <= 2)
+      for(; x + 2 <= pixels; x += 2, patches += 2 * size, output += 2 * outputStride)
+      {
+        __m128 acc0[blocks];
+        __m128 acc1[blocks];
+        for(int b = 0; b < blocks; ++b)
+          acc0[b] = acc1[b] = _mm_loadu_ps(bias + 4 * b);
+        const float* w = weights;
+        for(unsigned i = 0; i < size; ++i, w += stride)
+        {
+          const __m128 x0 = _mm_set1_ps(patches[i]);
+          const __m128 x1 = _mm_set1_ps(patches[size + i]);
+          for(int b = 0; b < blocks; ++b)
+          {
+            const __m128 wb = _mm_loadu_ps(w + 4 * b);
+            acc0[b] = _mm_add_ps(acc0[b], _mm_mul_ps(x0, wb));
+            acc1[b] = _mm_add_ps(acc1[b], _mm_mul_ps(x1, wb));
+          }
+        }
+        for(int b = 0; b < blocks; ++b)
+        {
+          if(activation)
+          {
+            acc0[b] = _mm_max_ps(acc0[b], _mm_mul_ps(acc0[b], a));
+            acc1[b] = _mm_max_ps(acc1[b], _mm_mul_ps(acc1[b], a));
+          }
+          _mm_storeu_ps(result + 4 * b, acc0[b]);
+          _mm_storeu_ps(result + 4 * (blocks + b), acc1[b]);
+        }
+        std::memcpy(output, result, channels * sizeof(float));
+        std::memcpy(output + outputStride, result + 4 * blocks, channels * sizeof(float));
+      }
+
+    for(; x < pixels; ++x, patches += size, output += outputStride)
+    {
+      __m128 acc[blocks];
+      for(int b = 0; b < blocks; ++b)
+        acc[b] = _mm_loadu_ps(bias + 4 * b);
+      const float* w = weights;
+      for(unsigned i = 0; i < size; ++i, w += stride)
+      {
+        const __m128 x0 = _mm_set1_ps(patches[i]);
+        for(int b = 0; b < blocks; ++b)
+          acc[b] = _mm_add_ps(acc[b], _mm_mul_ps(x0, _mm_loadu_ps(w + 4 * b)));
+      }
+      for(int b = 0; b < blocks; ++b)
+      {
+        if(activation)
+          acc[b] = _mm_max_ps(acc[b], _mm_mul_ps(acc[b], a));
+        _mm_storeu_ps(result + 4 * b, acc[b]);
+      }
+      std::memcpy(output, result, channels * sizeof(float));
+    }
+  }
+
+  /**
+   * Applies a leaky ReLU in place.
+   * @param data The values.
+   * @param size The number of values.
+   * @param alpha The slope for negative values.
+   */
+  void activate(float* data, unsigned size, float alpha)
+  {
+    const __m128 a = _mm_set1_ps(alpha);
+    unsigned i = 0;
+    for(; i + 4 <= size; i += 4)
+    {
+      const __m128 value = _mm_loadu_ps(data + i);
+      _mm_storeu_ps(data + i, _mm_max_ps(value, _mm_mul_ps(value, a)));
+    }
+    for(; i < size; ++i)
+      data[i] = std::max(data[i], data[i] * alpha);
+  }
+
+  bool readFloats(InBinaryFile& stream, std::vector<float>& values)
+  {
+    unsigned size;
+    stream >> size;
+    if(stream.eof() && size)
+      return false;
+    values.resize(size);
+    for(float& value : values)
+      stream >> value;
+    return true;
+  }
+}
+
+bool ConvNetwork::load(const std::string& fileName)
+{
+  layers.clear();
+  InBinaryFile stream(fileName);
+  if(!stream.exists())
+    return false;
+
+  unsigned version, numOfLayers;
+  stream >> version;
+  if(version != 1)
+    return false;
+  stream >> inputShape.height >> inputShape.width >> inputShape.channels >> numOfLayers;
+
+  Shape shape = inputShape;
+  size_t maxSize = shape.size();
+  size_t maxPatches = 0;
+  for(unsigned i = 0; i < numOfLayers; ++i)
+  {
+    Layer layer;
+    unsigned type;
+    stream >> type;
+    layer.type = static_cast<LayerType>(type);
+    layer.input = shape;
+    layer.output = shape;
+    switch(layer.type)
+    {
+      case conv:
+      case depthwise:
+      case maxPool:
+        stream >> layer.kernelHeight >> layer.kernelWidth >> layer.strideHeight >> layer.strideWidth
+               >> layer.paddingTop >> layer.paddingLeft >> layer.output.height >> layer.output.width;
+        break;
+      case leakyRelu:
+        stream >> layer.alpha;
+        break;
+      default:
+        layers.clear();
+        return false;
+    }
+
+    if(layer.type == conv || layer.type == depthwise)
+    {
+      std::vector<float> weights;
+      unsigned channels;
+      stream >> channels;
+      if(!readFloats(stream, weights) || !readFloats(stream, layer.bias))
+      {
+        layers.clear();
+        return false;
+      }
+      const unsigned patchSize = layer.kernelHeight * layer.kernelWidth * shape.channels;
+      if(layer.type == depthwise)
+      {
+        layer.multiplier = channels;
+        layer.output.channels = shape.channels * channels;
+        layer.weights = weights;
+        if(layer.bias.empty())
+          layer.bias.resize(layer.output.channels, 0.f);
+      }
+      else
+      {
+        // Pad the output channels to full SSE registers.
+        layer.output.channels = channels;
+        layer.weightStride = (channels + 3) & ~3u;
+        layer.weights.resize(patchSize * layer.weightStride, 0.f);
+        if(weights.size() == patchSize * channels)
+          for(unsigned j = 0; j < patchSize; ++j)
+            std::copy(weights.begin() + j * channels, weights.begin() + (j + 1) * channels, layer.weights.begin() + j * layer.weightStride);
+        layer.bias.resize(layer.weightStride, 0.f);
+        maxPatches = std::max(maxPatches, static_cast<size_t>(layer.output.width * patchSize));
+      }
+      if(weights.size() != patchSize * channels || layer.bias.size() < layer.output.channels)
+      {
+        layers.clear();
+        return false;
+      }
+    }
+
+    // Fuse activations into the preceding layer. This also works for max pooling,
+    // because the leaky ReLU is monotonic.
+    if(layer.type == leakyRelu && !layers.empty() && layers.back().type != leakyRelu && !layers.back().activation)
+    {
+      layers.back().activation = true;
+      layers.back().alpha = layer.alpha;
+    }
+    else
+      layers.push_back(layer);
+    shape = layer.output;
+    maxSize = std::max(maxSize, static_cast<size_t>(shape.size()));
+  }
+
+  buffers[0].resize(maxSize);
+  buffers[1].resize(maxSize);
+  patches.resize(maxPatches);
+  return !layers.empty();
+}
+
+void ConvNetwork::apply(const float* input, float* output)
+{
+  ASSERT(isLoaded());
+  const float* current = input;
+  for(const Layer& layer : layers)
+  {
+    float* next = current == buffers[0].data() ? buffers[1].data() : buffers[0].data();
+    switch(layer.type)
+    {
+      case conv:
+        applyConv(layer, current, next);
+        break;
+      case depthwise:
+        applyDepthwise(layer, current, next);
+        break;
+      case maxPool:
+        applyMaxPool(layer, current, next);
+        break;
+      case leakyRelu:
+        std::memcpy(next, current, layer.input.size() * sizeof(float));
+        applyLeakyRelu(layer, next);
+        break;
+    }
+    current = next;
+  }
+  std::memcpy(output, current, getOutputShape().size() * sizeof(float));
+}
+
+void ConvNetwork::applyConv(const Layer& layer, const float* input, float* output)
+{
+  const unsigned inputChannels = layer.input.channels;
+  const unsigned outputChannels = layer.output.channels;
+  const unsigned patchSize = layer.kernelHeight * layer.kernelWidth * inputChannels;
+  const bool pointwise = layer.kernelHeight == 1 && layer.kernelWidth == 1 && layer.strideHeight == 1
+                         && layer.strideWidth == 1 && layer.paddingTop == 0 && layer.paddingLeft == 0
+                         && layer.input.width == layer.output.width;
+
+  for(unsigned y = 0; y < layer.output.height; ++y)
+  {
+    const float* rowPatches;
+    if(pointwise)
+      rowPatches = input + y * layer.input.width * inputChannels;
+    else
+    {
+      // im2col of the current output row with zero padding.
+      float* p = patches.data();
+      const int yBegin = static_cast<int>(y * layer.strideHeight) - static_cast<int>(layer.paddingTop);
+      for(unsigned x = 0; x < layer.output.width; ++x)
+      {
+        const int xBegin = static_cast<int>(x * layer.strideWidth) - static_cast<int>(layer.paddingLeft);
+        for(int yIn = yBegin; yIn < yBegin + static_cast<int>(layer.kernelHeight); ++yIn)
+          for(int xIn = xBegin; xIn < xBegin + static_cast<int>(layer.kernelWidth); ++xIn, p += inputChannels)
+            if(yIn >= 0 && yIn < static_cast<int>(layer.input.height) && xIn >= 0 && xIn < static_cast<int>(layer.input.width))
+            {
+              const float* in = input + (yIn * layer.input.width + xIn) * inputChannels;
+              for(unsigned c = 0; c < inputChannels; ++c)
+                p[c] = in[c];
+            }
+            else
+              for(unsigned c = 0; c < inputChannels; ++c)
+                p[c] = 0.f;
+      }
+      rowPatches = patches.data();
+    }
+
+    float* out = output + y * layer.output.width * outputChannels;
+    for(unsigned c = 0; c < outputChannels; c += 8)
+    {
+      const float* weights = layer.weights.data() + c;
+      const float* bias = layer.bias.data() + c;
+      const unsigned channels = std::min(8u, outputChannels - c);
+      if(channels > 4)
+        gemm<2>(rowPatches, layer.output.width, patchSize, weights, layer.weightStride, bias,
+                out + c, outputChannels, channels, layer.activation, layer.alpha);
+      else
+        gemm<1>(rowPatches, layer.output.width, patchSize, weights, layer.weightStride, bias,
+                out + c, outputChannels, channels, layer.activation, layer.alpha);
+    }
+  }
+}
+
+void ConvNetwork::applyDepthwise(const Layer& layer, const float* input, float* output) const
+{
+  const unsigned inputChannels = layer.input.channels;
+  const unsigned outputChannels = layer.output.channels;
+  const unsigned multiplier = layer.multiplier;
+  const unsigned rowStride = layer.input.width * inputChannels;
+  const unsigned kernelRowStride = layer.kernelWidth * outputChannels;
+
+  float* out = output;
+  for(unsigned y = 0; y < layer.output.height; ++y)
+  {
+    const int yIn = static_cast<int>(y * layer.strideHeight) - static_cast<int>(layer.paddingTop);
+    const int iBegin = std::max(0, -yIn);
+    const int iEnd = std::min(static_cast<int>(layer.kernelHeight), static_cast<int>(layer.input.height) - yIn);
+    for(unsigned x = 0; x < layer.output.width; ++x, out += outputChannels)
+    {
+      const int xIn = static_cast<int>(x * layer.strideWidth) - static_cast<int>(layer.paddingLeft);
+      const int jBegin = std::max(0, -xIn);
+      const int jEnd = std::min(static_cast<int>(layer.kernelWidth), static_cast<int>(layer.input.width) - xIn);
+      const float* in = input + yIn * static_cast<int>(rowStride) + xIn * static_cast<int>(inputChannels);
+
+      std::memcpy(out, layer.bias.data(), outputChannels * sizeof(float));
+      for(int i = iBegin; i < iEnd; ++i)
+        for(int j = jBegin; j < jEnd; ++j)
+        {
+          const float* inPixel = in + i * rowStride + j * inputChannels;
+          const float* weights = layer.weights.data() + i * kernelRowStride + j * outputChannels;
+          if(multiplier == 4)
+            for(unsigned c = 0; c < inputChannels; ++c)
+              _mm_storeu_ps(out + 4 * c, _mm_add_ps(_mm_loadu_ps(out + 4 * c),
+                                                    _mm_mul_ps(_mm_set1_ps(inPixel[c]), _mm_loadu_ps(weights + 4 * c))));
+          else
+            for(unsigned c = 0; c < inputChannels; ++c)
+              for(unsigned m = c * multiplier; m < (c + 1) * multiplier; ++m)
+                out[m] += inPixel[c] * weights[m];
+        }
+      if(layer.activation)
+        activate(out, outputChannels, layer.alpha);
+    }
+  }
+}
+
+void ConvNetwork::applyMaxPool(const Layer& layer, const float* input, float* output) const
+{
+  const unsigned channels = layer.input.channels;
+  const bool vectorized = channels % 4 == 0;
+
+  float* out = output;
+  for(unsigned y = 0; y < layer.output.height; ++y)
+    for(unsigned x = 0; x < layer.output.width; ++x, out += channels)
+    {
+      std::fill(out, out + channels, -std::numeric_limits<float>::infinity());
+      for(unsigned i = 0; i < layer.kernelHeight; ++i)
+      {
+        const int yIn = static_cast<int>(y * layer.strideHeight + i) - static_cast<int>(layer.paddingTop);
+        if(yIn < 0 || yIn >= static_cast<int>(layer.input.height))
+          continue;
+        for(unsigned j = 0; j < layer.kernelWidth; ++j)
+        {
+          const int xIn = static_cast<int>(x * layer.strideWidth + j) - static_cast<int>(layer.paddingLeft);
+          if(xIn < 0 || xIn >= static_cast<int>(layer.input.width))
+            continue;
+          const float* in = input + (yIn * layer.input.width + xIn) * channels;
+          if(vectorized)
+            for(unsigned c = 0; c < channels; c += 4)
+              _mm_storeu_ps(out + c, _mm_max_ps(_mm_loadu_ps(out + c), _mm_loadu_ps(in + c)));
+          else
+            for(unsigned c = 0; c < channels; ++c)
+              out[c] = std::max(out[c], in[c]);
+        }
+      }
+      if(layer.activation)
+        activate(out, channels, layer.alpha);
+    }
+}
+
+void ConvNetwork::applyLeakyRelu(const Layer& layer, float* data) const
+{
+  activate(data, layer.input.size(), layer.alpha);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file ConvNetwork.h
+ * Declaration of a small inference engine for the convolutional networks of the
+ * YOLO detectors. The layers and their weights are loaded from a network file
+ * written by Util/CNN/extractNetwork.py, so exchanging a network does not
+ * require recompiling generated code. Convolutions are computed as GEMMs on
+ * im2col patches with register blocked SSE kernels.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+class ConvNetwork
+{
+public:
+  /** The dimensions of a tensor in HWC layout. */
+  struct Shape
+  {
+    unsigned height = 0;
+    unsigned width = 0;
+    unsigned channels = 0;
+
+    unsigned size() const {return height * width * channels;}
+    bool operator==(const Shape& other) const {return height == other.height && width == other.width && channels == other.channels;}
+  };
+
+private:
+  enum LayerType
+  {
+    conv,
+    depthwise,
+    maxPool,
+    leakyRelu,
+  };
+
+  struct Layer
+  {
+    LayerType type;
+    Shape input; /**< The shape of the input of this layer. */
+    Shape output; /**< The shape of the output of this layer. */
+    unsigned kernelHeight = 1;
+    unsigned kernelWidth = 1;
+    unsigned strideHeight = 1;
+    unsigned strideWidth = 1;
+    unsigned paddingTop = 0;
+    unsigned paddingLeft = 0;
+    unsigned multiplier = 1; /**< The channel multiplier of a depthwise convolution. */
+    unsigned weightStride = 0; /**< The output channels of a convolution rounded up to a multiple of 4. */
+    std::vector<float> weights; /**< Convolution: (kernel height * kernel width * input channels) x weightStride, depthwise: HWCM. */
+    std::vector<float> bias; /**< Convolution: weightStride entries, depthwise: output channels entries. */
+    float alpha = 0.f; /**< The slope of the leaky ReLU, also if it was fused into a convolution. */
+    bool activation = false; /**< Was a leaky ReLU fused into this convolution? */
+  };
+
+  Shape inputShape;
+  std::vector<Layer> layers;
+  std::vector<float> buffers[2]; /**< The activations, alternately used as input and output of the layers. */
+  std::vector<float> patches; /**< The im2col patches of one output row. */
+
+  void applyConv(const Layer& layer, const float* input, float* output);
+  void applyDepthwise(const Layer& layer, const float* input, float* output) const;
+  void applyMaxPool(const Layer& layer, const float* input, float* output) const;
+  void applyLeakyRelu(const Layer& layer, float* data) const;
+
+public:
+  /**
+   * Loads a network.
+   * @param fileName The name of the network file relative to the configuration directory.
+   * @return Was the network loaded successfully?
+   */
+  bool load(const std::string& fileName);
+
+  /** Was a network loaded? */
+  bool isLoaded() const {return !layers.empty();}
+
+  const Shape& getInputShape() const {return inputShape;}
+  const Shape& getOutputShape() const {return layers.back().output;}
+
+  /**
+   * Executes the network. Different instances can be used by different threads
+   * concurrently.
+   * @param input The input in HWC layout. Its size must match getInputShape().
+   * @param output The output in HWC layout. Its size must match getOutputShape().
+   */
+  void apply(const float* input, float* output);
+};
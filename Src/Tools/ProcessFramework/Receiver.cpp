@@ -12,7 +12,8 @@
 
 ReceiverList::ReceiverList(PlatformProcess* p, const std::string& receiverName) :
   name(receiverName), // copy the receiver's name. The name of the process is still missing.
-  process(p)
+  process(p),
+  middle(1)
 {
   if(getFirst())
   {
@@ -23,16 +24,9 @@ ReceiverList::ReceiverList(PlatformProcess* p, const std::string& receiverName)
   }
   else
     getFirst() = this;
-  for(int i = 0; i < 3; ++i)
-    package[i] = 0;
 }
 
-ReceiverList::~ReceiverList()
-{
-  for(int i = 0; i < 3; ++i)
-    if(package[i])
-      delete[] (char*)package[i];
-}
+ReceiverList::~ReceiverList() = default;
 
 ReceiverList*& ReceiverList::getFirst()
 {
@@ -53,19 +47,8 @@ ReceiverList* ReceiverList::lookup(const std::string& processName, const std::st
   return 0;
 }
 
-void ReceiverList::setPackage(void* p)
+void ReceiverList::setPackage()
 {
-  int writing = 0;
-  if(writing == actual)
-    ++writing;
-  if(writing == reading)
-    if(++writing == actual)
-      ++writing;
-  ASSERT(writing != actual);
-  ASSERT(writing != reading);
-  if(package[writing])
-    delete[] (char*)package[writing];
-  package[writing] = p;
-  actual = writing;
+  back = middle.exchange(back | fresh, std::memory_order_acq_rel) & ~fresh;
   process->trigger();
 }
@@ -9,6 +9,8 @@
 #pragma once
 
 #include "Tools/Streams/InStreams.h"
+#include <atomic>
+#include <vector>
 
 class PlatformProcess;
 
@@ -25,9 +27,30 @@ private:
 
 protected:
   PlatformProcess* process;   /**< The process this receiver is associated with. */
-  void* package[3];           /**< A triple buffer for received packages. */
-  volatile int reading = 0;   /**< Index of package reserved for reading. */
-  volatile int actual = 0;    /**< Index of package that is the most actual. */
+
+  /**
+   * A triple buffer for received packages. The sender owns the back buffer and
+   * the receiver the front buffer. The third one is the newest completed package.
+   * The buffers are reused, so they only allocate memory until they have reached
+   * the size of the largest package.
+   */
+  std::vector<char> package[3];
+  int front = 0;              /**< Index of package reserved for reading. Only used by the receiver. */
+  int back = 2;               /**< Index of package reserved for writing. Only used by the sender. */
+  std::atomic<int> middle;    /**< Index of the newest package. Combined with the flag fresh if it was not read yet. */
+  static const int fresh = 4; /**< The flag marking an unread package in middle. */
+
+  /**
+   * The function makes the newest package the front buffer if it was not read yet.
+   * @return Is there a new package in the front buffer?
+   */
+  bool acquirePackage()
+  {
+    if(!(middle.load(std::memory_order_relaxed) & fresh))
+      return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & ~fresh;
+    return true;
+  }
 
   /**
    * The function checks whether a new package has arrived.
@@ -68,16 +91,23 @@ public:
   void checkAllForPackages();
 
   /**
-   * The function sets the package.
-   * @param p The package.
+   * The function returns the buffer the next package is written into.
+   * It must only be called by the sender.
+   * @return The back buffer.
+   */
+  std::vector<char>& getBackBuffer() {return package[back];}
+
+  /**
+   * The function publishes the package in the back buffer.
+   * It must only be called by the sender.
    */
-  void setPackage(void* p);
+  void setPackage();
 
   /**
    * The function determines whether the receiver has a pending package.
    * @return Is there still an unprocessed package?
    */
-  bool hasPendingPackage() const {return package[actual] != 0;}
+  bool hasPendingPackage() const {return (middle.load(std::memory_order_relaxed) & fresh) != 0;}
 
   /**
    * The function searches for a receiver with the given name.
@@ -101,14 +131,11 @@ private:
    */
   virtual void checkForPackage()
   {
-    reading = actual;
-    if(package[reading])
+    if(acquirePackage())
     {
       T& data = *static_cast<T*>(this);
-      InBinaryMemory memory(package[reading]);
+      InBinaryMemory memory(package[front].data(), package[front].size());
       memory >> data;
-      delete[] (char*)package[reading];
-      package[reading] = 0;
     }
   }
 
@@ -107,8 +107,8 @@ protected:
     if(numOfAlreadyReceived != -1)
     {
       // send() has been called at least once
-      int i;
-      for(i = 0; i < numOfReceivers; ++i)
+      const std::vector<char>* streamed = nullptr;
+      for(int i = 0; i < numOfReceivers; ++i)
       {
         int j;
         for(j = 0; j < numOfAlreadyReceived; ++j)
@@ -117,14 +117,18 @@ protected:
         if(j == numOfAlreadyReceived)
         {
           // receiver[i] has not received its requested package yet
-          const T& data = *static_cast<const T*>(this);
-          OutBinarySize size;
-          size << data;
-          void* r = (void*) new char[size.getSize()];
-          ASSERT(r);
-          OutBinaryMemory memory(r);
-          memory << data;
-          receiver[i]->setPackage(r);
+          std::vector<char>& buffer = receiver[i]->getBackBuffer();
+          if(streamed)
+            buffer.assign(streamed->begin(), streamed->end());
+          else
+          {
+            // the package is only streamed once, all other receivers get a copy
+            OutBinaryVector stream(buffer);
+            stream << *static_cast<const T*>(this);
+          }
+          // after publishing, the receiver only reads the buffer, so it can still be copied
+          streamed = &buffer;
+          receiver[i]->setPackage();
           // note that receiver[i] has received the current package
           ASSERT(numOfAlreadyReceived < RECEIVERS_MAX);
           alreadyReceived[numOfAlreadyReceived++] = receiver[i];
@@ -7,7 +7,7 @@
 #include "Settings.h"
 #include "Tools/Streams/InStreams.h"
 #include "Representations/Infrastructure/RoboCupGameControlData.h"
-#ifdef TARGET_SIM
+#if defined(TARGET_SIM) && !defined(HEADLESS)
 #include "Controller/ConsoleRoboCupCtrl.h"
 #endif
 #ifdef TARGET_ROBOT
@@ -51,6 +51,7 @@ Settings::Settings()
   *this = settings;
 
 #ifdef TARGET_SIM
+#ifndef HEADLESS
   if(SystemCall::getMode() == SystemCall::simulatedRobot)
   {
     int index = atoi(RoboCupCtrl::controller->getRobotName().c_str() + 5) - 1;
@@ -59,9 +60,11 @@ Settings::Settings()
     teamColor = index < 6 ? blue : red;
     playerNumber = index % 6 + 1;
   }
+#endif
 
   robotName = "Nao";
 
+#ifndef HEADLESS
   ConsoleRoboCupCtrl* ctrl = dynamic_cast<ConsoleRoboCupCtrl*>(RoboCupCtrl::controller);
   if(ctrl)
   {
@@ -79,6 +82,7 @@ Settings::Settings()
         robotName = "Default";
     }
   }
+#endif
 
   bodyName = robotName.c_str();
 
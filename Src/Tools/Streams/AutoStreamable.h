@@ -273,22 +273,37 @@
 
 #endif
 
-/** Generate streamable class. */
-#define _STREAM_STREAMABLE(name, base, streamBase, header, ...) \
+/** Generate binary streaming code from declaration. */
+#define _STREAM_SER_BINARY(seq) Streaming::streamBinary(in, out, _STREAM_VAR(seq));
+
+/**
+ * Generate streamable class. If the stream is binary and the class was
+ * already registered, the attributes are streamed directly without
+ * registering them.
+ */
+#define _STREAM_STREAMABLE(name, base, streamBase, binaryStreamBase, header, ...) \
   struct name : public base \
   _STREAM_UNWRAP header; \
-  _STREAM_STREAMABLE_I(_STREAM_TUPLE_SIZE(__VA_ARGS__), name, streamBase, __VA_ARGS__)
-#define _STREAM_STREAMABLE_I(n, name, streamBase, ...) _STREAM_STREAMABLE_II(n, name, streamBase, (_STREAM_SER, __VA_ARGS__), (_STREAM_DECL, __VA_ARGS__))
-#define _STREAM_STREAMABLE_II(n, name, streamBase, params1, params2) \
+  _STREAM_STREAMABLE_I(_STREAM_TUPLE_SIZE(__VA_ARGS__), name, streamBase, binaryStreamBase, __VA_ARGS__)
+#define _STREAM_STREAMABLE_I(n, name, streamBase, binaryStreamBase, ...) _STREAM_STREAMABLE_II(n, name, streamBase, binaryStreamBase, (_STREAM_SER, __VA_ARGS__), (_STREAM_DECL, __VA_ARGS__), (_STREAM_SER_BINARY, __VA_ARGS__))
+#define _STREAM_STREAMABLE_II(n, name, streamBase, binaryStreamBase, params1, params2, params3) \
     _STREAM_ATTR_##n params2 \
   protected: \
     friend struct Streaming::OnRead<name, true>; \
     void serialize(In* in, Out* out) \
     { \
-      STREAM_REGISTER_BEGIN \
-      streamBase \
-      _STREAM_ATTR_##n params1 \
-      STREAM_REGISTER_FINISH \
+      if(Streaming::isBinaryAndRegistered(in, out, typeid(*this))) \
+      { \
+        binaryStreamBase \
+        _STREAM_ATTR_##n params3 \
+      } \
+      else \
+      { \
+        STREAM_REGISTER_BEGIN \
+        streamBase \
+        _STREAM_ATTR_##n params1 \
+        STREAM_REGISTER_FINISH \
+      } \
       if(in) \
         Streaming::onRead(*this); \
     } \
@@ -303,9 +318,9 @@
  * @param ... The actual declarations. It must end with a closing curly bracket.
  */
 #ifdef WINDOWS
-#define STREAMABLE(name, header, ...) _STREAM_STREAMABLE(name, Streamable, , header, __VA_ARGS__)
+#define STREAMABLE(name, header, ...) _STREAM_STREAMABLE(name, Streamable, , , header, __VA_ARGS__)
 #else
-#define STREAMABLE(name, header, ...) _STREAM_STREAMABLE(name, Streamable, , (header), __VA_ARGS__)
+#define STREAMABLE(name, header, ...) _STREAM_STREAMABLE(name, Streamable, , , (header), __VA_ARGS__)
 #endif
 
 /**
@@ -321,9 +336,9 @@
  * @param ... The actual declarations. It must end with a closing curly bracket.
  */
 #ifdef WINDOWS
-#define STREAMABLE_WITH_BASE(name, base, header, ...) _STREAM_STREAMABLE(name, base, STREAM_BASE(base), header, __VA_ARGS__)
+#define STREAMABLE_WITH_BASE(name, base, header, ...) _STREAM_STREAMABLE(name, base, STREAM_BASE(base), this->base::serialize(in, out);, header, __VA_ARGS__)
 #else
-#define STREAMABLE_WITH_BASE(name, base, header, ...) _STREAM_STREAMABLE(name, base, STREAM_BASE(base), (header), __VA_ARGS__)
+#define STREAMABLE_WITH_BASE(name, base, header, ...) _STREAM_STREAMABLE(name, base, STREAM_BASE(base), this->base::serialize(in, out);, (header), __VA_ARGS__)
 #endif
 
 /**
@@ -483,3 +483,30 @@ Out& operator<<(Out& stream, const Eigen::Quaternion<T, OPTIONS>& quaternion)
 
   return stream;
 }
+
+namespace Streaming
+{
+  /**
+   * All operators above stream the coefficients of fixed-size matrices in memory order.
+   * Therefore, they can be streamed as a whole if they are part of a registered class.
+   */
+  template<typename T, int ROWS, int COLS, int OPTIONS, int MAX_ROWS, int MAX_COLS>
+  struct BinaryStreamer<Eigen::Matrix<T, ROWS, COLS, OPTIONS, MAX_ROWS, MAX_COLS>, false>
+  {
+    static void stream(In* in, Out* out, Eigen::Matrix<T, ROWS, COLS, OPTIONS, MAX_ROWS, MAX_COLS>& matrix)
+    {
+      static_assert(ROWS != Eigen::Dynamic && COLS != Eigen::Dynamic,
+                    "Streaming dynamic Eigen matrix not supported yet");
+      BinaryArrayStreamer<T>::stream(in, out, matrix.data(), ROWS * COLS);
+    }
+  };
+
+  template<typename T, int OPTIONS>
+  struct BinaryStreamer<Eigen::Array<T, 2, 1, OPTIONS, 2, 1>, false>
+  {
+    static void stream(In* in, Out* out, Eigen::Array<T, 2, 1, OPTIONS, 2, 1>& array)
+    {
+      BinaryArrayStreamer<T>::stream(in, out, array.data(), 2);
+    }
+  };
+}
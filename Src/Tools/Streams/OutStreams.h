@@ -771,6 +771,40 @@ protected:
   virtual void writeToStream(const void* p, size_t size);
 };
 
+/**
+ * @class OutVector
+ *
+ * A PhysicalOutStream that appends the data to a vector. The vector keeps
+ * its capacity if it is reused, so no memory is allocated once it has grown
+ * to the size of the data.
+ */
+class OutVector : public PhysicalOutStream
+{
+private:
+  std::vector<char>* buffer = nullptr; /**< The vector the data is appended to. */
+
+protected:
+  /**
+   * opens the stream. The vector is cleared.
+   * @param buffer The vector into which is written.
+   */
+  void open(std::vector<char>& buffer)
+  {
+    this->buffer = &buffer;
+    buffer.clear();
+  }
+
+  /**
+   * The function appends a number of bytes to the vector.
+   * @param p The address the data is located at.
+   * @param size The number of bytes to be written.
+   */
+  virtual void writeToStream(const void* p, size_t size)
+  {
+    buffer->insert(buffer->end(), static_cast<const char*>(p), static_cast<const char*>(p) + size);
+  }
+};
+
 /**
  * @class OutSize
  *
@@ -871,6 +905,30 @@ public:
   virtual bool isBinary() const {return true;}
 };
 
+/**
+ * @class OutBinaryVector
+ *
+ * A binary stream into a vector.
+ */
+class OutBinaryVector : public OutStream<OutVector, OutBinary>
+{
+public:
+  /**
+   * Constructor.
+   * @param buffer The vector into which is written. It is cleared first.
+   */
+  OutBinaryVector(std::vector<char>& buffer)
+  {
+    open(buffer);
+  }
+
+  /**
+   * The function returns whether this is a binary stream.
+   * @return Does it output data in binary format?
+   */
+  virtual bool isBinary() const {return true;}
+};
+
 /**
  * @class OutBinarySize
  *
@@ -79,6 +79,17 @@ public:
   void registerWithSpecification(const char* name, const std::type_info& ti);
   void registerEnum(const std::type_info& ti, const char* (*fp)(int));
 
+  /**
+   * Was the specification of a type already registered? If so, registering
+   * its instances again would not change anything.
+   * @param name The name of the type as returned by typeid.
+   * @return Can the registration of the type be skipped?
+   */
+  bool isRegistered(const char* name) const
+  {
+    return !registeringBase && specification.find(name) != specification.end();
+  }
+
   /**
    * Check whether the specifications of two types are structurally identical,
    * so that the first type could read the data written by the second type.
@@ -106,4 +117,5 @@ private:
   friend class DebugDataStreamer; // needs access to internal data types.
   friend class LogPlayer; // constructs a StreamHandler to represent specification of logged data.
   friend class LogDataProvider; // constructs a StreamHandler to represent specification of logged data.
+  friend class LogReplay; // constructs the StreamHandler of the replaying process.
 };
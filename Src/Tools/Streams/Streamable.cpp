@@ -59,6 +59,11 @@ namespace Streaming
     Global::getStreamHandler().registerEnum(ti, fp);
   }
 
+  bool isBinaryAndRegistered(const In* in, const Out* out, const std::type_info& ti)
+  {
+    return (in ? in->isBinary() : out->isBinary()) && Global::getStreamHandler().isRegistered(ti.name());
+  }
+
   std::string demangle(const char* name)
   {
 #ifdef WINDOWS
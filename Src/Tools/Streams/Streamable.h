@@ -10,6 +10,7 @@
 #pragma once
 
 #include <typeinfo>
+#include <type_traits>
 #include <vector>
 #include <array>
 #include "InOut.h"
@@ -334,6 +335,123 @@ namespace Streaming
     }
   };
 
+  /**
+   * Can an object be streamed without registering its type and without
+   * selecting its members? This is the case if the stream is binary and the
+   * specification of the type was already registered by the current process.
+   * @param in The stream to read from or nullptr.
+   * @param out The stream to write to or nullptr.
+   * @param ti The type of the object.
+   * @return Can streamBinary() be used for all members of the object?
+   */
+  bool isBinaryAndRegistered(const In* in, const Out* out, const std::type_info& ti);
+
+  /**
+   * Is the binary representation of a type identical to its memory layout?
+   * Enums are streamed as single bytes or ints, so only these sizes qualify.
+   */
+  template<typename T> struct IsRawBinary
+  {
+    static const bool value = std::is_arithmetic<T>::value || (std::is_enum<T>::value && (sizeof(T) == 1 || sizeof(T) == sizeof(int)));
+  };
+  template<> struct IsRawBinary<Angle> {static const bool value = true;};
+
+  /**
+   * Streams a member in binary format without registering it. The bytes
+   * streamed are the same as the ones Streamer<S> produces for binary streams.
+   * This version is used for all types that have no raw representation. It
+   * just calls the streaming operators.
+   */
+  template<typename S, bool raw = IsRawBinary<S>::value> struct BinaryStreamer
+  {
+    static void stream(In* in, Out* out, S& s)
+    {
+      if(in)
+        *in >> s;
+      else
+        *out << s;
+    }
+  };
+
+  /** Types that are streamed as their memory representation. */
+  template<typename S> struct BinaryStreamer<S, true>
+  {
+    static void stream(In* in, Out* out, S& s)
+    {
+      if(in)
+        in->read(&s, sizeof(S));
+      else
+        out->write(&s, sizeof(S));
+    }
+  };
+
+  /** Elements of static arrays, vectors, and std::arrays. */
+  template<typename E, bool raw = IsRawBinary<E>::value> struct BinaryArrayStreamer
+  {
+    static void stream(In* in, Out* out, E* s, size_t n)
+    {
+      for(E* end = s + n; s != end; ++s)
+        BinaryStreamer<E>::stream(in, out, *s);
+    }
+  };
+
+  template<typename E> struct BinaryArrayStreamer<E, true>
+  {
+    static void stream(In* in, Out* out, E* s, size_t n)
+    {
+      if(in)
+        in->read(s, n * sizeof(E));
+      else
+        out->write(s, n * sizeof(E));
+    }
+  };
+
+  template<typename E, size_t N> struct BinaryStreamer<E[N], false>
+  {
+    static void stream(In* in, Out* out, E(&s)[N]) {BinaryArrayStreamer<E>::stream(in, out, s, N);}
+  };
+
+  template<typename E, typename A> struct BinaryStreamer<std::vector<E, A>, false>
+  {
+    static void stream(In* in, Out* out, std::vector<E, A>& s)
+    {
+      if(in)
+      {
+        unsigned size;
+        *in >> size;
+        s.resize(size);
+      }
+      else
+        *out << static_cast<unsigned>(s.size());
+      if(!s.empty())
+        BinaryArrayStreamer<E>::stream(in, out, s.data(), s.size());
+    }
+  };
+
+  template<typename E, size_t n> struct BinaryStreamer<std::array<E, n>, false>
+  {
+    static void stream(In* in, Out* out, std::array<E, n>& s)
+    {
+      unsigned size = static_cast<unsigned>(n);
+      if(in)
+        *in >> size;
+      else
+        *out << size;
+      BinaryArrayStreamer<E>::stream(in, out, s.data(), n);
+    }
+  };
+
+  /**
+   * Streams a member of an object for which isBinaryAndRegistered() returned true.
+   * @param in The stream to read from or nullptr.
+   * @param out The stream to write to or nullptr.
+   * @param s The member to be streamed.
+   */
+  template<typename S> void streamBinary(In* in, Out* out, S& s)
+  {
+    BinaryStreamer<S>::stream(in, out, s);
+  }
+
   /**
    * The following three functions are helpers for streaming data. (in == 0) != (out == 0).
    * @tparam S The type of the variable to be streamed.
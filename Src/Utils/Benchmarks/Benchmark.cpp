@@ -0,0 +1,38 @@
+#include "Benchmark.h"
+
+#include <iostream>
+
+Benchmark::Benchmark(const char* name, void (*function)()) :
+  name(name), function(function)
+{
+  getAll().push_back(this);
+}
+
+std::vector<const Benchmark*>& Benchmark::getAll()
+{
+  static std::vector<const Benchmark*> benchmarks;
+  return benchmarks;
+}
+
+int Benchmark::run(const std::string& prefix)
+{
+  int executed = 0;
+  for(const Benchmark* benchmark : getAll())
+    if(benchmark->name.compare(0, prefix.size(), prefix) == 0)
+    {
+      std::cout << benchmark->name << std::endl;
+      benchmark->function();
+      ++executed;
+    }
+  return executed;
+}
+
+int main(int argc, char** argv)
+{
+  if(Benchmark::run(argc > 1 ? argv[1] : "") == 0)
+  {
+    std::cerr << "No benchmark matches " << argv[1] << std::endl;
+    return 1;
+  }
+  return 0;
+}
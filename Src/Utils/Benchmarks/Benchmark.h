@@ -0,0 +1,56 @@
+/**
+ * @file Benchmark.h
+ * A minimal registry for benchmarks that are executed by the application
+ * Benchmarks instead of the unit tests, because their results depend on the
+ * machine and the load.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+class Benchmark
+{
+private:
+  std::string name; /**< "Group.name" as given to BENCHMARK. */
+  void (*function)(); /**< The function that executes the benchmark and prints its results. */
+
+  /** All benchmarks registered. */
+  static std::vector<const Benchmark*>& getAll();
+
+public:
+  Benchmark(const char* name, void (*function)());
+
+  /**
+   * Executes all benchmarks the names of which start with a prefix.
+   * @param prefix The prefix. An empty one selects all benchmarks.
+   * @return The number of benchmarks executed.
+   */
+  static int run(const std::string& prefix);
+
+  /**
+   * Measures the average duration of a function.
+   * @param runs How often the function is called.
+   * @param function The function.
+   * @return The average duration in microseconds.
+   */
+  template<typename Function> static double measure(int runs, Function function)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < runs; ++i)
+      function();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+  }
+};
+
+/**
+ * Defines and registers a benchmark.
+ * @param group The group of the benchmark, e.g. the class measured.
+ * @param name The name of the benchmark within its group.
+ */
+#define BENCHMARK(group, name) \
+  static void group##_##name(); \
+  static Benchmark group##_##name##_benchmark(#group "." #name, &group##_##name); \
+  static void group##_##name()
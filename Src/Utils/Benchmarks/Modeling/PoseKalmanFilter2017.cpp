@@ -0,0 +1,41 @@
+#include "Utils/Benchmarks/Benchmark.h"
+#include "Utils/Tests/Modeling/PoseKalmanFilter2017Reference.h"
+
+#include <iostream>
+
+using namespace PoseKalmanFilter2017Reference;
+
+BENCHMARK(PoseKalmanFilter2017, update)
+{
+  Matrix2d singleMeasurementCovariance;
+  singleMeasurementCovariance << 0.01, 0.0, 0.0, 0.02;
+  KalmanStateUpdateObservations2017<3, 40> stateUpdate;
+  stateUpdate.initMeasurementCovariance(singleMeasurementCovariance, correlationFactor);
+
+  std::mt19937 random(42);
+  SphericalObservationVector<3> observations;
+  Matrix3d covariance;
+  for(size_t count : {5, 10, 20, 40})
+  {
+    createObservations(random, count, observations, covariance);
+
+    // the checksums keep the compiler from dropping the updates
+    double denseChecksum = 0.0, informationChecksum = 0.0;
+    const double dense = Benchmark::measure(1000, [&]
+    {
+      Matrix3d c = covariance;
+      denseChecksum += denseUpdate(observations, singleMeasurementCovariance, c).sum();
+    });
+    const double information = Benchmark::measure(1000, [&]
+    {
+      Matrix3d c = covariance;
+      informationChecksum += stateUpdate.updateWithLocalObservations(observations, c).sum();
+    });
+
+    std::cout << "  " << count << " spherical observations: dense " << dense << " us, information form "
+              << information << " us per update";
+    if(std::abs(denseChecksum - informationChecksum) > 1e-6 * (1.0 + std::abs(denseChecksum)))
+      std::cout << " (results differ)";
+    std::cout << std::endl;
+  }
+}
@@ -0,0 +1,278 @@
+/**
+ * @file Utils/LogReplay/LogReplay.cpp
+ * Implementation of a class that replays a log file through the Cognition modules
+ * without the simulator and as fast as possible.
+ *
+ * Usage: LogReplay [-m <modules.cfg>] [-n <frames>] <log file>
+ */
+
+#include "LogReplay.h"
+#include "Modules/Configuration/CognitionConfigurationDataProvider.h"
+#include "Modules/Infrastructure/CognitionLogDataProvider.h"
+#include "Platform/BHAssert.h"
+#include "Tools/Streams/InStreams.h"
+#include "Tools/Streams/OutStreams.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <regex>
+
+/**
+ * A PhysicalOutStream that does not store the data, but computes a 64 bit FNV-1a hash over it.
+ */
+class OutHash : public PhysicalOutStream
+{
+private:
+  uint64_t* hash = nullptr; /**< The hash updated. */
+
+protected:
+  void open(uint64_t& hash) {this->hash = &hash;}
+
+  void writeToStream(const void* p, size_t size) override
+  {
+    for(const unsigned char* c = reinterpret_cast<const unsigned char*>(p), * end = c + size; c < end; ++c)
+      *hash = (*hash ^ *c) * 1099511628211ull;
+  }
+};
+
+/**
+ * A binary stream that continues a hash.
+ */
+class OutBinaryHash : public OutStream<OutHash, OutBinary>
+{
+public:
+  /**
+   * Constructor.
+   * @param hash The hash that is continued with everything written.
+   */
+  OutBinaryHash(uint64_t& hash) {open(hash);}
+};
+
+LogReplay::LogReplay() :
+  logPlayer(frame),
+  moduleManager({ModuleBase::cognitionInfrastructure, ModuleBase::perception, ModuleBase::pathPlanning, ModuleBase::modeling, ModuleBase::behaviorControl})
+{
+  setGlobals();
+  moduleManager.setObserver(this);
+}
+
+LogReplay::~LogReplay()
+{
+  moduleManager.setObserver(nullptr);
+  moduleManager.destroy();
+}
+
+void LogReplay::setGlobals()
+{
+  Global::theAnnotationManager = &annotationManager;
+  Global::theDebugOut = &debugOut.out;
+  Global::theTeamOut = &teamOut;
+  Global::theSettings = &settings;
+  Global::theDebugRequestTable = &debugRequestTable;
+  Global::theDebugDataTable = &debugDataTable;
+  Global::theStreamHandler = &streamHandler;
+  Global::theDrawingManager = &drawingManager;
+  Global::theDrawingManager3D = &drawingManager3D;
+  Global::theTimingManager = &timingManager;
+  Global::theNTP = &ntp;
+}
+
+bool LogReplay::open(const std::string& logFile, const std::string& modulesFile)
+{
+  // Use the robot the log was recorded on, as the simulator does.
+  std::smatch match;
+  if(std::regex_search(logFile, match, std::regex("[0-9]_([A-Za-z]*)_[0-9]{4}-[0-9]{2}-[0-9]{2}_[0-9]{2}-[0-9]{2}-[0-9]{2}\\.log")))
+    settings.robotName = match[1];
+  else
+    settings.robotName = "Default";
+  settings.bodyName = settings.robotName;
+
+  if(!logPlayer.open(logFile.c_str()))
+  {
+    std::fprintf(stderr, "Cannot open log file %s.\n", logFile.c_str());
+    return false;
+  }
+  logPlayer.setLoop(false);
+
+  InMapFile stream(modulesFile);
+  if(!stream.exists())
+  {
+    std::fprintf(stderr, "Cannot open module configuration %s.\n", modulesFile.c_str());
+    return false;
+  }
+  ModuleManager::Configuration config;
+  stream >> config;
+
+  // Equivalent to "log mr": everything logged that can be replayed is provided by the log.
+  int upperFrequencies[numOfDataMessageIDs];
+  int lowerFrequencies[numOfDataMessageIDs];
+  logPlayer.statistics(upperFrequencies, nullptr, 'c');
+  logPlayer.statistics(lowerFrequencies, nullptr, 'd');
+  const ModuleBase* logDataProvider = ModuleBase::first;
+  while(logDataProvider && std::string(logDataProvider->name) != "CognitionLogDataProvider")
+    logDataProvider = logDataProvider->next;
+  ASSERT(logDataProvider);
+  for(int i = idProcessFinished + 1; i < numOfDataMessageIDs; ++i)
+    if(upperFrequencies[i] || lowerFrequencies[i])
+    {
+      std::string representation = std::string(::getName(MessageID(i))).substr(2);
+      if(representation == "JPEGImage" || representation == "LowFrameRateImage" ||
+         representation == "Thumbnail" || representation == "YoloInput")
+        representation = "Image";
+      else if(representation == "JPEGImageUpper" || representation == "LowFrameRateImageUpper" ||
+              representation == "ThumbnailUpper" || representation == "YoloInputUpper")
+        representation = "ImageUpper";
+      for(const ModuleBase::Info* info = logDataProvider->info; info->representation; ++info)
+        if(info->update && representation == info->representation)
+        {
+          config.representationProviders.erase(std::remove_if(config.representationProviders.begin(), config.representationProviders.end(),
+                                                              [&](const ModuleManager::Configuration::RepresentationProvider& rp) {return rp.representation == representation;}),
+                                               config.representationProviders.end());
+          config.representationProviders.emplace_back(representation, logDataProvider->name);
+          break;
+        }
+    }
+
+  OutBinarySize size;
+  size << config;
+  std::vector<char> buffer(size.getSize());
+  OutBinaryMemory out(buffer.data());
+  out << config;
+  InBinaryMemory in(buffer.data(), buffer.size());
+  moduleManager.update(in, 0xffffffff);
+  // The execution parameters of the robot are not loaded: the default ones execute
+  // all providers serially and never skip one, so the results do not depend on timing.
+  return true;
+}
+
+unsigned LogReplay::run(unsigned maxFrames)
+{
+  unsigned frames = 0;
+  logPlayer.play();
+
+  // The first frame creates all modules and is not measured.
+  moduleManager.execute();
+  debugOut.clear();
+  recording = true;
+
+  while((!maxFrames || frames < maxFrames) && logPlayer.replay())
+  {
+    frame.handleAllMessages(*this);
+    frame.clear();
+    if(CognitionLogDataProvider::isFrameDataComplete())
+    {
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      moduleManager.execute();
+      frameDurations.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+      hashProvided();
+      debugOut.clear();
+      ++frames;
+    }
+  }
+  recording = false;
+  return frames;
+}
+
+bool LogReplay::handleMessage(InMessage& message)
+{
+  if(message.getMessageID() == idProcessBegin)
+  {
+    message.bin >> process;
+    return true;
+  }
+  else if(process == 'c' || process == 'd') // Motion frames are not replayed
+    return CognitionLogDataProvider::handleMessage(message) ||
+           CognitionConfigurationDataProvider::handleMessage(message);
+  else
+    return false;
+}
+
+void LogReplay::providerExecuted(const char* representation, const char* module, float duration, unsigned allocations)
+{
+  if(recording)
+  {
+    SYNC;
+    Statistics& s = statistics[representation];
+    if(s.module.empty())
+      s.module = module;
+    s.durations.push_back(duration);
+    s.allocations += allocations;
+    s.maxAllocations = std::max(s.maxAllocations, allocations);
+    s.executed = true;
+  }
+}
+
+void LogReplay::hashProvided()
+{
+  for(auto& entry : statistics)
+    if(entry.second.executed)
+    {
+      OutBinaryHash stream(entry.second.hash);
+      stream << blackboard[entry.first.c_str()];
+      entry.second.executed = false;
+    }
+}
+
+/**
+ * Returns a percentile of a set of durations.
+ * @param durations The durations, sorted in ascending order.
+ * @param p The percentile in [0..1].
+ * @return The duration at that percentile (nearest rank).
+ */
+static float percentile(const std::vector<float>& durations, float p)
+{
+  if(durations.empty())
+    return 0.f;
+  const size_t index = static_cast<size_t>(p * static_cast<float>(durations.size()));
+  return durations[std::min(index, durations.size() - 1)];
+}
+
+void LogReplay::print(unsigned frames, double seconds) const
+{
+  std::printf("%u frames in %.2f s (%.1f frames/s)\n\n", frames, seconds, seconds > 0. ? frames / seconds : 0.);
+  std::printf("%-32s %-32s %8s %8s %8s %10s %8s  %s\n", "representation", "provider", "p50 ms", "p95 ms", "p99 ms", "allocs/fr", "max", "hash");
+
+  std::vector<float> sorted(frameDurations);
+  std::sort(sorted.begin(), sorted.end());
+  std::printf("%-32s %-32s %8.3f %8.3f %8.3f\n", "(frame)", "", percentile(sorted, 0.5f), percentile(sorted, 0.95f), percentile(sorted, 0.99f));
+
+  for(const auto& entry : statistics)
+  {
+    const Statistics& s = entry.second;
+    sorted = s.durations;
+    std::sort(sorted.begin(), sorted.end());
+    std::printf("%-32s %-32s %8.3f %8.3f %8.3f %10.1f %8u  %016" PRIx64 "\n", entry.first.c_str(), s.module.c_str(),
+                percentile(sorted, 0.5f), percentile(sorted, 0.95f), percentile(sorted, 0.99f),
+                static_cast<double>(s.allocations) / static_cast<double>(std::max<size_t>(s.durations.size(), 1)),
+                s.maxAllocations, s.hash);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  std::string modulesFile = "modules.cfg";
+  unsigned maxFrames = 0;
+  int i = 1;
+  for(; i < argc - 1 && argv[i][0] == '-'; i += 2)
+    if(std::string(argv[i]) == "-m")
+      modulesFile = argv[i + 1];
+    else if(std::string(argv[i]) == "-n")
+      maxFrames = static_cast<unsigned>(std::atoi(argv[i + 1]));
+    else
+      break;
+  if(i != argc - 1)
+  {
+    std::fprintf(stderr, "Usage: %s [-m <modules.cfg>] [-n <frames>] <log file>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  LogReplay logReplay;
+  if(!logReplay.open(argv[i], modulesFile))
+    return EXIT_FAILURE;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const unsigned frames = logReplay.run(maxFrames);
+  logReplay.print(frames, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  return EXIT_SUCCESS;
+}
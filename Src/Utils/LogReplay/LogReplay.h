@@ -0,0 +1,105 @@
+/**
+ * @file Utils/LogReplay/LogReplay.h
+ * Declaration of a class that replays a log file through the Cognition modules
+ * without the simulator and as fast as possible. It measures how long every
+ * provider needs, how many heap allocations it does, and hashes the
+ * representations it provides, so that two versions of the code can be compared
+ * on the same log file.
+ */
+
+#pragma once
+
+#include "Controller/LogPlayer.h"
+#include "Tools/Debugging/AnnotationManager.h"
+#include "Tools/Debugging/DebugDataTable.h"
+#include "Tools/Debugging/DebugDrawings.h"
+#include "Tools/Debugging/DebugDrawings3D.h"
+#include "Tools/Debugging/DebugRequest.h"
+#include "Tools/Debugging/TimingManager.h"
+#include "Tools/Module/Blackboard.h"
+#include "Tools/Module/ModuleManager.h"
+#include "Tools/Network/NTP.h"
+#include "Tools/ProcessFramework/TeamHandler.h"
+#include "Tools/Settings.h"
+#include "Tools/Streams/StreamHandler.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class LogReplay : public MessageHandler, public ModuleManager::Observer
+{
+private:
+  /** The measurements of a single provider. */
+  struct Statistics
+  {
+    std::string module; /**< The module that provided the representation. */
+    std::vector<float> durations; /**< The duration of every execution in ms. */
+    unsigned long long allocations = 0; /**< The sum of all allocations. */
+    unsigned maxAllocations = 0; /**< The most allocations in a single execution. */
+    uint64_t hash = 14695981039346656037ull; /**< FNV-1a hash over the representation after each execution. */
+    bool executed = false; /**< Was the provider executed in the current frame? */
+  };
+
+  // The process infrastructure the modules expect. The blackboard sets itself as instance.
+  Blackboard blackboard;
+  Settings settings;
+  AnnotationManager annotationManager;
+  TimingManager timingManager;
+  DebugRequestTable debugRequestTable;
+  DebugDataTable debugDataTable;
+  StreamHandler streamHandler;
+  DrawingManager drawingManager;
+  DrawingManager3D drawingManager3D;
+  TeamDataOut teamOut;
+  NTP ntp;
+  MessageQueue debugOut; /**< Collects the debug output of the modules. It is dropped after each frame. */
+
+  MessageQueue frame; /**< The messages of the frame currently replayed. */
+  LogPlayer logPlayer; /**< Reads the log file and copies it frame by frame to "frame". */
+  ModuleManager moduleManager; /**< Executes the Cognition modules. */
+  char process = 0; /**< The process identifier of the frame currently replayed. */
+
+  std::map<std::string, Statistics> statistics; /**< The measurements per representation. */
+  std::vector<float> frameDurations; /**< The time each frame needed in ms. */
+  bool recording = false; /**< Are measurements currently recorded? */
+  DECLARE_SYNC; /**< Protects "statistics", because providers may run in parallel. */
+
+public:
+  LogReplay();
+  ~LogReplay();
+
+  /**
+   * The method opens a log file and configures the modules to be fed from it.
+   * All representations in the log that CognitionLogDataProvider can provide
+   * are provided by it, everything else as selected in the module configuration.
+   * @param logFile The name of the log file.
+   * @param modulesFile The name of the module configuration file.
+   * @return Was the log file opened and the configuration accepted?
+   */
+  bool open(const std::string& logFile, const std::string& modulesFile);
+
+  /**
+   * The method replays the log file once.
+   * @param maxFrames The maximum number of Cognition frames to execute. 0 means no limit.
+   * @return The number of Cognition frames executed.
+   */
+  unsigned run(unsigned maxFrames);
+
+  /**
+   * The method prints the measurements to stdout. The providers are executed serially
+   * without a frame budget and modules with worker threads run synchronously in the
+   * replay, so the hashes do not depend on timing and can be diffed between two runs.
+   * @param frames The number of frames executed.
+   * @param seconds The wall-clock time the replay needed.
+   */
+  void print(unsigned frames, double seconds) const;
+
+private:
+  void setGlobals();
+  bool handleMessage(InMessage& message) override;
+  void providerExecuted(const char* representation, const char* module, float duration, unsigned allocations) override;
+
+  /** Updates the hashes of all representations provided in the current frame. */
+  void hashProvided();
+};
@@ -0,0 +1,26 @@
+#include "PoseKalmanFilter2017Reference.h"
+
+#include "gtest/gtest.h"
+
+using namespace PoseKalmanFilter2017Reference;
+
+TEST(PoseKalmanFilter2017, informationFormMatchesDenseUpdate)
+{
+  Matrix2d singleMeasurementCovariance;
+  singleMeasurementCovariance << 0.01, 0.002, 0.002, 0.02;
+  KalmanStateUpdateObservations2017<3, 40> stateUpdate;
+  stateUpdate.initMeasurementCovariance(singleMeasurementCovariance, correlationFactor);
+
+  std::mt19937 random(42);
+  SphericalObservationVector<3> observations;
+  for (int i = 0; i < 1000; i++)
+  {
+    Matrix3d covariance;
+    createObservations(random, 1 + i % 20, observations, covariance);
+    Matrix3d expectedCovariance = covariance;
+    const Vector3d expectedMovement = denseUpdate(observations, singleMeasurementCovariance, expectedCovariance);
+    const Vector3d movement = stateUpdate.updateWithLocalObservations(observations, covariance);
+    EXPECT_LE((movement - expectedMovement).norm(), 1e-6 * (1.0 + expectedMovement.norm()));
+    EXPECT_LE((covariance - expectedCovariance).norm(), 1e-6 * (1.0 + expectedCovariance.norm()));
+  }
+}
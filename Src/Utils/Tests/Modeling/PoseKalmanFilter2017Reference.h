@@ -0,0 +1,52 @@
+/**
+ * @file PoseKalmanFilter2017Reference.h
+ * The update of the pose hypotheses with the stacked innovation covariance as it was
+ * implemented before the information form, and random observations to feed it with.
+ * Used by the test and the benchmark of the information form.
+ */
+
+#pragma once
+
+#include "Modules/Modeling/WorldModelGenerator/models/PoseKalmanFilter2017.h"
+
+#include <random>
+
+namespace PoseKalmanFilter2017Reference
+{
+  const double correlationFactor = 0.5;
+
+  /** The update as it was implemented before, i.e. with the stacked n x n innovation covariance. */
+  inline Vector3d denseUpdate(const SphericalObservationVector<3>& observations, const Matrix2d& singleMeasurementCovariance, Matrix3d& covariance)
+  {
+    const int n = 2 * static_cast<int>(observations.size());
+    Eigen::MatrixXd H(n, 3), R(n, n);
+    Eigen::VectorXd z(n);
+    for (int i = 0; i < n / 2; i++)
+    {
+      H.block(2 * i, 0, 2, 3) = observations[i].measurementModelJacobian;
+      z.segment(2 * i, 2) = (observations[i].realAngles - observations[i].nominalAngles) * observations[i].weight;
+    }
+    for (int row = 0; row < n; row++)
+      for (int col = 0; col < n; col++)
+        R(row, col) = (row / 2 != col / 2 ? correlationFactor : 1.0) * singleMeasurementCovariance(row % 2, col % 2);
+    const Eigen::MatrixXd K = covariance * H.transpose() * (H * covariance * H.transpose() + R).inverse();
+    covariance = (Matrix3d::Identity() - K * H) * covariance;
+    return K * z;
+  }
+
+  inline void createObservations(std::mt19937& random, size_t count, SphericalObservationVector<3>& observations, Matrix3d& covariance)
+  {
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    observations.resize(count);
+    for (SphericalObservation<3>& observation : observations)
+    {
+      observation.realAngles = Vector2d(uniform(random), uniform(random)) * 0.5;
+      observation.nominalAngles = Vector2d(uniform(random), uniform(random)) * 0.5;
+      observation.measurementModelJacobian << uniform(random) * 1e-3, uniform(random) * 1e-3, uniform(random),
+        uniform(random) * 1e-3, uniform(random) * 1e-3, uniform(random);
+      observation.weight = 0.5 + 0.5 * uniform(random);
+    }
+    const Matrix3d a = Matrix3d::Random();
+    covariance = a * a.transpose() * 1000.0 + Vector3d(100.0, 100.0, 0.01).asDiagonal().toDenseMatrix();
+  }
+}
@@ -11,26 +11,175 @@
 #include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <ctime>
 #include <cstring>
+#include <string>
 #include <unistd.h>
 #include <stdio.h>
 #include "stdlib.h"
 
 #include "ndevils.h"
 
-#include "msgpack.hpp"
 #include <chrono>
 
 const char *socket_path = "/tmp/robocup";
 #define LOLA_SENSOR_SIZE 896
+#define LOLA_ACTUATOR_MAX_SIZE 1024
 
-// helper function for msgpack str type
-std::string to_string(const msgpack::object_str& str) 
+/*
+  Reads the few msgpack types LoLA uses directly from a packet, without building an object tree.
+  Numbers are only classified and skipped. They are decoded later using their offsets.
+*/
+class MsgPackReader
 {
-  return std::string(str.ptr, str.size);
-}
+public:
+  MsgPackReader(const char* buffer, unsigned size) :
+    begin(reinterpret_cast<const unsigned char*>(buffer)), pos(begin), end(begin + size) {}
+
+  unsigned offset() const {return static_cast<unsigned>(pos - begin);}
+
+  bool readMap(unsigned& size)
+  {
+    if(pos < end && (*pos & 0xf0) == 0x80)
+    {
+      size = *pos++ & 0x0f;
+      return true;
+    }
+    return readSized(0xde, 0xdf, size);
+  }
+
+  bool readArray(unsigned& size)
+  {
+    if(pos < end && (*pos & 0xf0) == 0x90)
+    {
+      size = *pos++ & 0x0f;
+      return true;
+    }
+    return readSized(0xdc, 0xdd, size);
+  }
+
+  bool readString(const char*& str, unsigned& length)
+  {
+    if(pos >= end)
+      return false;
+    if((*pos & 0xe0) == 0xa0)
+      length = *pos++ & 0x1f;
+    else if(*pos == 0xd9 && pos + 2 <= end)
+    {
+      length = pos[1];
+      pos += 2;
+    }
+    else if(!readSized(0xda, 0xdb, length))
+      return false;
+    if(pos + length > end)
+      return false;
+    str = reinterpret_cast<const char*>(pos);
+    pos += length;
+    return true;
+  }
+
+  /* Skips a number and returns its format, or 0xc1 (never used) if it is none. */
+  unsigned char skipNumber()
+  {
+    if(pos >= end)
+      return 0xc1;
+    const unsigned char format = getFormat(*pos);
+    const unsigned size = getSize(format);
+    if(!size || pos + size > end)
+      return 0xc1;
+    pos += size;
+    return format;
+  }
+
+  /* Fixints contain their value. Their format is that of the value 0 (or -32). */
+  static unsigned char getFormat(unsigned char type)
+  {
+    return type < 0x80 ? 0x00 : type >= 0xe0 ? 0xe0 : type;
+  }
+
+  /* The size of a number including its type byte, 0 if the format is no number. */
+  static unsigned getSize(unsigned char format)
+  {
+    switch(format)
+    {
+      case 0x00: case 0xe0: case 0xc2: case 0xc3: return 1;
+      case 0xcc: case 0xd0: return 2;
+      case 0xcd: case 0xd1: return 3;
+      case 0xca: case 0xce: case 0xd2: return 5;
+      case 0xcb: case 0xcf: case 0xd3: return 9;
+      default: return 0;
+    }
+  }
+
+  /* Decodes a number of the given format. */
+  static double decode(const unsigned char* p, unsigned char format)
+  {
+    switch(format)
+    {
+      case 0x00: return p[0];
+      case 0xe0: return static_cast<signed char>(p[0]);
+      case 0xc2: return 0.;
+      case 0xc3: return 1.;
+      case 0xcc: return p[1];
+      case 0xd0: return static_cast<signed char>(p[1]);
+      case 0xcd: return static_cast<uint16_t>(readBigEndian(p + 1, 2));
+      case 0xd1: return static_cast<int16_t>(readBigEndian(p + 1, 2));
+      case 0xce: return static_cast<uint32_t>(readBigEndian(p + 1, 4));
+      case 0xd2: return static_cast<int32_t>(readBigEndian(p + 1, 4));
+      case 0xcf: return static_cast<double>(readBigEndian(p + 1, 8));
+      case 0xd3: return static_cast<double>(static_cast<int64_t>(readBigEndian(p + 1, 8)));
+      case 0xca:
+      {
+        const uint32_t bits = static_cast<uint32_t>(readBigEndian(p + 1, 4));
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+      }
+      case 0xcb:
+      {
+        const uint64_t bits = readBigEndian(p + 1, 8);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+      }
+      default: return 0.;
+    }
+  }
+
+private:
+  const unsigned char* begin;
+  const unsigned char* pos;
+  const unsigned char* end;
+
+  static uint64_t readBigEndian(const unsigned char* p, int bytes)
+  {
+    uint64_t value = 0;
+    for(int i = 0; i < bytes; ++i)
+      value = value << 8 | p[i];
+    return value;
+  }
+
+  bool readSized(unsigned char type16, unsigned char type32, unsigned& size)
+  {
+    if(pos + 3 <= end && *pos == type16)
+    {
+      size = static_cast<unsigned>(readBigEndian(pos + 1, 2));
+      pos += 3;
+      return true;
+    }
+    if(pos + 5 <= end && *pos == type32)
+    {
+      size = static_cast<unsigned>(readBigEndian(pos + 1, 4));
+      pos += 5;
+      return true;
+    }
+    return false;
+  }
+};
 
 /*
   @class NDevils
@@ -46,20 +195,49 @@ public:
   int main();
 private:
   static const int allowedFrameDrops = 10; /**< Maximum number of frame drops allowed before Nao sits down. */
+  static const int numOfSensorFloats = offsetof(NDSensorData, status) / sizeof(float); /**< Sensor values before the status category. */
+  static const int numOfSensorValues = numOfSensorFloats + numOfJoints; /**< Sensor values including the status category. */
+  static const int numOfActuatorFloats = offsetof(NDActuatorData, sonars) / sizeof(float); /**< Actuator values before the sonars. */
+
   /*
-    Takes @buffer from socket stream and unpacks msgpack (hard coded order!) into data pointer.
+    Takes @buffer from socket stream and decodes the sensor values at the offsets of the sensor layout (hard coded order!) into data pointer.
+    If the layout changed, it is recreated. Returns false if @buffer does not contain the expected sensor values.
   */
-  void unpack_data(const char* buffer);
+  bool unpack_data(const char* buffer);
 
   /*
-    Packs data into a @sbuffer with hard coded array element order within category.
+    Walks once through the LoLA packet in @buffer and remembers the offset and format of each sensor value.
+    Returns false if the number of values does not match NDSensorData.
   */
-  void pack_data(msgpack::sbuffer &sbuffer);
-  
-  // helper function for pack_data
-  void pack_map(msgpack::packer<msgpack::sbuffer> &pk, const std::string &name, const int size, float* &data_ptr);
+  bool createSensorLayout(const char* buffer);
+
+  /*
+    Reads body and head id from the RobotConfig category of the LoLA packet in @buffer.
+  */
+  bool readRobotConfig(const char* buffer);
+
+  /*
+    Creates the actuator packet with hard coded key order once. Only its values are replaced later.
+  */
+  void createActuatorPacket();
+
+  /*
+    Writes the current actuator values into the actuator packet (hard coded array element order within category).
+  */
+  void pack_data();
+
+  struct SensorSlot
+  {
+    unsigned short offset; /**< The offset of the value in the LoLA packet. */
+    unsigned char format; /**< The msgpack format of the value. */
+  };
+  SensorSlot sensorLayout[numOfSensorValues]; /**< Where to find the sensor values in a LoLA packet. */
+  bool sensorLayoutValid = false; /**< Was the sensor layout created? */
 
-  void pack_map_bool(msgpack::packer<msgpack::sbuffer> &pk, const std::string &name, const int size, bool* &data_ptr);
+  unsigned char actuatorPacket[LOLA_ACTUATOR_MAX_SIZE]; /**< The packet sent to LoLA. */
+  unsigned actuatorPacketSize = 0; /**< The number of bytes used in actuatorPacket. */
+  unsigned short actuatorOffsets[numOfActuatorFloats]; /**< The offsets of the float values in actuatorPacket. */
+  unsigned short sonarOffsets[numOfSonars]; /**< The offsets of the sonar values in actuatorPacket. */
 
   int fd = 0;
   int memoryHandle = -1; /**< The file handle of the shared memory. */
@@ -116,8 +294,18 @@ private:
 
 bool NDevils::run = true;
 
-void NDevils::unpack_data(const char* buffer)
+bool NDevils::unpack_data(const char* buffer)
 {
+  const unsigned char* packet = reinterpret_cast<const unsigned char*>(buffer);
+  for (int i = 0; i < numOfSensorValues; i++)
+    if (!sensorLayoutValid || MsgPackReader::getFormat(packet[sensorLayout[i].offset]) != sensorLayout[i].format)
+    {
+      // a value changed its size, e.g. a status grew beyond a fixint, so all following offsets moved
+      if (!createSensorLayout(buffer))
+        return false;
+      break;
+    }
+
   int writingSensors = 0;
   if(writingSensors == data->newestSensors)
     ++writingSensors;
@@ -127,35 +315,14 @@ void NDevils::unpack_data(const char* buffer)
   assert(writingSensors != data->newestSensors);
   assert(writingSensors != data->readingSensors);
 
+  // copy the float categories and then the status category to data->sensor field
   float* data_ptr = (float*)&data->sensors[writingSensors]; // get pointer to start of sensor data
-  
-  msgpack::object_handle oh = 
-    msgpack::unpack(&buffer[0], LOLA_SENSOR_SIZE); // char* to object handle
-  
-  // get map of key (category as string) and value (float, except status(int))
-  // and copy to data->sensor field
-  // first the float categories
-  const auto& map = oh.get().via.map;
-  auto* category = map.ptr;
-  // ignore first category since robot config was read already
-  category++;
-  for (uint32_t i = 1; i < map.size-1; i++, category++) 
-  {
-    const auto& arr = category->val.via.array;
-    for (uint32_t j = 0; j < arr.size; j++) 
-    {
-      *data_ptr = static_cast<float>((arr.ptr + j)->via.f64);
-      ++data_ptr;
-    }
-  }
-  // .. then the status category
-  const auto& arr = category->val.via.array;
-  int* data_ptr_int = (int*)data_ptr;
-  for (uint32_t j = 0; j < arr.size; j++) 
-  {
-    *data_ptr_int = static_cast<int>((arr.ptr + j)->via.u64);
-    ++data_ptr_int;
-  }
+  const SensorSlot* slot = sensorLayout;
+  for (int i = 0; i < numOfSensorFloats; i++, slot++)
+    data_ptr[i] = static_cast<float>(MsgPackReader::decode(packet + slot->offset, slot->format));
+  int* data_ptr_int = data->sensors[writingSensors].status;
+  for (int i = 0; i < numOfJoints; i++, slot++)
+    data_ptr_int[i] = static_cast<int>(MsgPackReader::decode(packet + slot->offset, slot->format));
   
   data->newestSensors = writingSensors;
   data->sensors[writingSensors].timestamp =
@@ -227,9 +394,143 @@ void NDevils::unpack_data(const char* buffer)
       }
     }
   }
+  return true;
+}
+
+bool NDevils::createSensorLayout(const char* buffer)
+{
+  sensorLayoutValid = false;
+  MsgPackReader reader(buffer, LOLA_SENSOR_SIZE);
+  unsigned categories, values;
+  const char* key;
+  unsigned keyLength;
+  // ignore first category since robot config was read already
+  if (!reader.readMap(categories) || categories < 2 || !reader.readString(key, keyLength) || !reader.readArray(values))
+    return false;
+  for (unsigned j = 0; j < values; j++)
+    if (!reader.readString(key, keyLength))
+      return false;
+
+  int numOfValues = 0;
+  for (unsigned i = 1; i < categories; i++)
+  {
+    if (!reader.readString(key, keyLength) || !reader.readArray(values))
+      return false;
+    // all categories but the last one (status) contain floats
+    const int numOfValuesAfter = numOfValues + static_cast<int>(values);
+    if ((i < categories - 1 && numOfValuesAfter > numOfSensorFloats)
+       || (i == categories - 1 && numOfValuesAfter != numOfSensorValues))
+    {
+      fprintf(stderr, "ndevilsbase: LoLA packet contains %u values in category %.*s, which does not match NDSensorData.\n", values, keyLength, key);
+      return false;
+    }
+    for (unsigned j = 0; j < values; j++, numOfValues++)
+    {
+      sensorLayout[numOfValues].offset = static_cast<unsigned short>(reader.offset());
+      sensorLayout[numOfValues].format = reader.skipNumber();
+      if (MsgPackReader::getSize(sensorLayout[numOfValues].format) == 0)
+        return false;
+    }
+  }
+  sensorLayoutValid = true;
+  return true;
+}
+
+bool NDevils::readRobotConfig(const char* buffer)
+{
+  MsgPackReader reader(buffer, LOLA_SENSOR_SIZE);
+  unsigned categories, values;
+  const char* str;
+  unsigned length;
+  if (!reader.readMap(categories) || !reader.readString(str, length)
+     || std::string(str, length) != "RobotConfig" || !reader.readArray(values) || values < 3)
+    return false;
+
+  // order in array is body id, body version, head id, head version
+  char* ids[] = {data->bodyId, nullptr, data->headId};
+  for (char* id : ids)
+  {
+    if (!reader.readString(str, length))
+      return false;
+    if (id)
+    {
+      length = std::min(length, static_cast<unsigned>(sizeof(data->bodyId) - 1));
+      memcpy(id, str, length);
+      id[length] = 0;
+    }
+  }
+  return true;
+}
+
+static unsigned char* writeArrayHeader(unsigned char* p, int size)
+{
+  if (size < 16)
+    *p++ = static_cast<unsigned char>(0x90 | size);
+  else
+  {
+    *p++ = 0xdc;
+    *p++ = static_cast<unsigned char>(size >> 8);
+    *p++ = static_cast<unsigned char>(size);
+  }
+  return p;
 }
 
-void NDevils::pack_data(msgpack::sbuffer &sbuffer)
+static unsigned char* writeString(unsigned char* p, const char* str)
+{
+  const size_t length = strlen(str);
+  *p++ = static_cast<unsigned char>(0xa0 | length); // all keys are shorter than 32 characters
+  memcpy(p, str, length);
+  return p + length;
+}
+
+void NDevils::createActuatorPacket()
+{
+  static const struct
+  {
+    const char* name;
+    int size;
+  } categories[] =
+  {
+    {"Chest", numOfRGBLEDs},
+    {"LEar", numOfLEarLEDs},
+    {"LEye", numOfLEyeLEDs * numOfRGBLEDs},
+    {"LFoot", numOfRGBLEDs},
+    {"Position", numOfJoints},
+    {"REar", numOfREarLEDs},
+    {"REye", numOfREyeLEDs * numOfRGBLEDs},
+    {"RFoot", numOfRGBLEDs},
+    {"Skull", numOfSkullLEDs},
+    {"Stiffness", numOfJoints}
+  };
+
+  unsigned char* p = actuatorPacket;
+  *p++ = 0x80 | 11; // map with 11 categories
+  int numOfValues = 0;
+  for (const auto& category : categories)
+  {
+    p = writeString(p, category.name);
+    p = writeArrayHeader(p, category.size);
+    for (int i = 0; i < category.size; ++i, ++numOfValues)
+    {
+      actuatorOffsets[numOfValues] = static_cast<unsigned short>(p - actuatorPacket);
+      *p = 0xca; // float 32
+      memset(p + 1, 0, 4);
+      p += 5;
+    }
+  }
+  assert(numOfValues == numOfActuatorFloats);
+  p = writeString(p, "Sonar");
+  p = writeArrayHeader(p, numOfSonars);
+  for (int i = 0; i < numOfSonars; ++i)
+  {
+    sonarOffsets[i] = static_cast<unsigned short>(p - actuatorPacket);
+    *p++ = 0xc2; // false
+  }
+  actuatorPacketSize = static_cast<unsigned>(p - actuatorPacket);
+  assert(actuatorPacketSize <= sizeof(actuatorPacket));
+}
+
+void NDevils::pack_data()
 {
   data->readingActuators = data->newestActuators;
 
@@ -259,39 +560,21 @@ void NDevils::pack_data(msgpack::sbuffer &sbuffer)
   setSkullLeds(&data->actuators[data->readingActuators].skullLEDs[0]);
   setChestLeds(&data->actuators[data->readingActuators].chestLEDs[0]);
 
-  msgpack::packer<msgpack::sbuffer> pk(&sbuffer);
-  pk.pack_map(11);
-  float* data_ptr = data->actuators[data->readingActuators].chestLEDs;
-  
-  pack_map(pk, std::string("Chest"), numOfRGBLEDs, data_ptr);
-  pack_map(pk, std::string("LEar"), numOfLEarLEDs, data_ptr);
-  pack_map(pk, std::string("LEye"), numOfLEyeLEDs * numOfRGBLEDs, data_ptr);
-  pack_map(pk, std::string("LFoot"), numOfRGBLEDs, data_ptr);
-  pack_map(pk, std::string("Position"), numOfJoints, data_ptr);
-  pack_map(pk, std::string("REar"), numOfREarLEDs, data_ptr);
-  pack_map(pk, std::string("REye"), numOfREyeLEDs * numOfRGBLEDs, data_ptr);
-  pack_map(pk, std::string("RFoot"), numOfRGBLEDs, data_ptr);
-  pack_map(pk, std::string("Skull"), numOfSkullLEDs, data_ptr);
-  pack_map(pk, std::string("Stiffness"), numOfJoints, data_ptr);
-  bool* data_ptr_bool = &data->actuators[0].sonars[0];
-  pack_map_bool(pk, std::string("Sonar"), numOfSonars, data_ptr_bool);
-  return;
-}
-
-void NDevils::pack_map(msgpack::packer<msgpack::sbuffer> &pk, const std::string &name, const int size, float* &data_ptr)
-{
-  pk.pack(name);
-  pk.pack_array(size);
-  for (int i = 0; i < size; ++i, ++data_ptr)
-    pk.pack(*data_ptr);
-}
-
-void NDevils::pack_map_bool(msgpack::packer<msgpack::sbuffer> &pk, const std::string &name, const int size, bool* &data_ptr)
-{
-  pk.pack(name);
-  pk.pack_array(size);
-  for (int i = 0; i < size; ++i, ++data_ptr)
-    pk.pack(*data_ptr);
+  // the values are stored as big endian floats behind their type byte
+  const float* data_ptr = data->actuators[data->readingActuators].chestLEDs;
+  for (int i = 0; i < numOfActuatorFloats; ++i, ++data_ptr)
+  {
+    uint32_t bits;
+    memcpy(&bits, data_ptr, sizeof(bits));
+    unsigned char* p = actuatorPacket + actuatorOffsets[i] + 1;
+    p[0] = static_cast<unsigned char>(bits >> 24);
+    p[1] = static_cast<unsigned char>(bits >> 16);
+    p[2] = static_cast<unsigned char>(bits >> 8);
+    p[3] = static_cast<unsigned char>(bits);
+  }
+  const bool* data_ptr_bool = &data->actuators[0].sonars[0];
+  for (int i = 0; i < numOfSonars; ++i, ++data_ptr_bool)
+    actuatorPacket[sonarOffsets[i]] = *data_ptr_bool ? 0xc3 : 0xc2;
 }
 
 static const float sitDownAngles[25] =
@@ -479,21 +762,10 @@ int NDevils::main()
       if (size == LOLA_SENSOR_SIZE)
       {
         printf("ndevilsbase: Got the LoLA header package!\n");
-        msgpack::object_handle oh = 
-          msgpack::unpack(&buffer[0], LOLA_SENSOR_SIZE); // char* to object handle
-        // std::cout << oh.get() << std::endl; // dump header definition into cout
         // get body id and head id
-        const auto& map = oh.get().via.map;
-        auto* robotConfig = map.ptr;
-        
-        std::string key = to_string(robotConfig->key.via.str);
-        if (key == "RobotConfig")
+        if (readRobotConfig(buffer) && createSensorLayout(buffer))
         {
-          const auto& rc_arr = robotConfig->val.via.array;
-          // order in array is body id, body version, head id, head version
-          strcpy(data->bodyId, to_string((rc_arr.ptr + 0)->via.str).c_str());
-          strcpy(data->headId, to_string((rc_arr.ptr + 2)->via.str).c_str());
-          
+          createActuatorPacket();
           lolaConnectionAttempts = 5;
         }
         else
@@ -509,11 +781,14 @@ int NDevils::main()
           size = recv(fd, buffer, LOLA_SENSOR_SIZE, 0);
           if (size == LOLA_SENSOR_SIZE)
           {
-            unpack_data(&buffer[0]);
-            msgpack::sbuffer sbuffer;
-            pack_data(sbuffer);
+            if (!unpack_data(&buffer[0]))
+            {
+              std::cout << "ndevilsbase: inner loop: LoLA package does not have the expected layout!" << std::endl;
+              break;
+            }
+            pack_data();
             //unsigned size = 
-            send(fd, sbuffer.data(), sbuffer.size(), 0);
+            send(fd, actuatorPacket, actuatorPacketSize, 0);
             //printf("libndevils: sent %u bytes!\n", size);
           }
           else
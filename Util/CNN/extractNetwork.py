@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""
+Extracts the layers and weights of a network from the C code generated for
+the YOLO detectors (e.g. Src/Modules/Perception/CNN/tiny-yolo-*_framework.c)
+and writes them to a network file that can be loaded by
+Src/Tools/NeuralNetwork/ConvNetwork.h.
+
+File format (all values little endian, 32 bit):
+  unsigned version, input height, input width, input channels, number of layers
+  per layer: unsigned type, then
+    conv (0), depthwise (1): kernel height, kernel width, stride height, stride width,
+                             padding top, padding left, output height, output width,
+                             output channels (depthwise: channel multiplier),
+                             number of weights, weights (HWIO, depthwise: HWCM),
+                             number of biases, biases
+    max pooling (2):         pool height, pool width, stride height, stride width,
+                             padding top, padding left, output height, output width
+    leaky relu (3):          float alpha
+
+Usage: extractNetwork.py <generated.c> <network.dat>
+"""
+
+import re
+import struct
+import sys
+
+VERSION = 1
+CONV, DEPTHWISE, MAX_POOL, LEAKY_RELU = range(4)
+
+
+def parse_arrays(code):
+  arrays = {}
+  for name, values in re.findall(r"float (\w+)\[\] = \{([^}]*)\};", code):
+    arrays[name] = [float(v.strip().rstrip("f")) for v in values.split(",") if v.strip()]
+  return arrays
+
+
+def parse_int(pattern, block, default=None):
+  match = re.search(pattern, block)
+  if match is None:
+    if default is None:
+      raise ValueError("Pattern '%s' not found in block:\n%s" % (pattern, block[:400]))
+    return default
+  return int(match.group(1))
+
+
+def parse_window(block, first, second):
+  """Returns stride and padding of both dimensions."""
+  strides = []
+  paddings = []
+  for loopVar, outVar in ((first, "x_out_1"), (second, "x_out_2")):
+    match = re.search(r"int %s = %s \* (\d+) - (\d+);" % (loopVar, outVar), block)
+    if match:
+      strides.append(int(match.group(1)))
+      paddings.append(int(match.group(2)))
+    else:
+      match = re.search(r"for \(int %s = -(\d+); [^;]*; %s \+= (\d+)\)" % (loopVar, loopVar), block)
+      paddings.append(int(match.group(1)))
+      strides.append(int(match.group(2)))
+  return strides, paddings
+
+
+def parse_output_shape(block, stride, padding, kernel, input_shape):
+  """Returns the output height and width."""
+  dims = []
+  for i, (loopVar, outVar) in enumerate((("ix", "x_out_1"), ("jx", "x_out_2"))):
+    match = re.search(r"for \(int %s = 0; %s < (\d+); %s\+\+\)" % (outVar, outVar, outVar), block)
+    if match:
+      dims.append(int(match.group(1)))
+    else:
+      match = re.search(r"for \(int %s = -\d+; %s < ([^;]*); %s \+= \d+\)" % (loopVar, loopVar, loopVar), block)
+      end = eval(match.group(1))
+      dims.append(len(range(-padding[i], end, stride[i])))
+  return dims
+
+
+def parse_layers(code, arrays, input_shape):
+  blocks = re.split(r"CNN_STOPWATCH\(\"[^\"]*\"\)", code.split("void cnn(")[1].split("int main(")[0])[1:]
+  layers = []
+  shape = list(input_shape)
+  for block in blocks:
+    comment = re.search(r"// ([a-z0-9 ]+)", block).group(1).strip()
+    if comment.startswith("leaky relu"):
+      match = re.search(r"_mm_set_ps1\(([-0-9.e]+)f\)", block) or re.search(r"element \* ([-0-9.e]+)f", block)
+      layers.append((LEAKY_RELU, float(match.group(1))))
+    elif comment.startswith("max pooling"):
+      stride, padding = parse_window(block, "ix", "jx")
+      kernel = [parse_int(r"dx < (\d+);", block), parse_int(r"dy < (\d+);", block)]
+      out = parse_output_shape(block, stride, padding, kernel, shape)
+      layers.append((MAX_POOL, kernel, stride, padding, out))
+      shape = [out[0], out[1], shape[2]]
+    elif "convolution" in comment:
+      depthwise = comment.startswith("depthwise")
+      weights_name = re.search(r"(\w+_WEIGHTS)\[\(\(iw\) \* \((\d+)\) \* \((\d+)\) \* \((\d+)\)", block)
+      name, kw, a, b = weights_name.group(1), int(weights_name.group(2)), int(weights_name.group(3)), int(weights_name.group(4))
+      kh = parse_int(r"for \(int iw = 0; iw < (\d+); iw\+\+\)", block)
+      assert kw == parse_int(r"for \(int jw = 0; jw < (\d+); jw\+\+\)", block)
+      assert a == shape[2], "%s: %d input channels expected, %d found" % (name, shape[2], a)
+      stride, padding = parse_window(block, "ix", "jx")
+      out = parse_output_shape(block, stride, padding, [kh, kw], shape)
+      weights = arrays[name]
+      bias_match = re.search(r"(\w+_BIAS)\[", block)
+      bias = arrays[bias_match.group(1)] if bias_match else []
+      if depthwise:
+        assert len(weights) == kh * kw * a * b
+        layers.append((DEPTHWISE, [kh, kw], stride, padding, out, b, weights, bias))
+        shape = [out[0], out[1], a * b]
+      else:
+        # the output channels of the weights might be padded
+        cout = parse_int(r"\w+\[\(\(x_out_1\) \* \(\d+\) \* \((\d+)\) \+ \(x_out_2\)", block)
+        assert len(weights) == kh * kw * a * b
+        if cout != b:
+          weights = [w for i, w in enumerate(weights) if i % b < cout]
+        bias = bias[:cout]
+        layers.append((CONV, [kh, kw], stride, padding, out, cout, weights, bias))
+        shape = [out[0], out[1], cout]
+    else:
+      raise ValueError("Unknown layer type '%s'" % comment)
+  return layers, shape
+
+
+def write(file_name, input_shape, layers):
+  with open(file_name, "wb") as f:
+    def u(*values):
+      f.write(struct.pack("<%dI" % len(values), *values))
+
+    def floats(values):
+      u(len(values))
+      f.write(struct.pack("<%df" % len(values), *values))
+
+    u(VERSION, *input_shape)
+    u(len(layers))
+    for layer in layers:
+      u(layer[0])
+      if layer[0] == LEAKY_RELU:
+        f.write(struct.pack("<f", layer[1]))
+      elif layer[0] == MAX_POOL:
+        _, kernel, stride, padding, out = layer
+        u(*(kernel + stride + padding + out))
+      else:
+        _, kernel, stride, padding, out, channels, weights, bias = layer
+        u(*(kernel + stride + padding + out + [channels]))
+        floats(weights)
+        floats(bias)
+
+
+def main():
+  if len(sys.argv) != 3:
+    print(__doc__)
+    sys.exit(1)
+  code = open(sys.argv[1]).read()
+  input_shape = [parse_int(r"input_%s = (\d+);" % dim, code) for dim in ("height", "width", "channel")]
+  layers, output_shape = parse_layers(code, parse_arrays(code), input_shape)
+  expected = [parse_int(r"output_%s = (\d+);" % dim, code) for dim in ("height", "width", "channel")]
+  assert output_shape == expected, "Output shape %s does not match %s" % (output_shape, expected)
+  write(sys.argv[2], input_shape, layers)
+  print("%s: %d layers, input %s, output %s" % (sys.argv[2], len(layers), input_shape, output_shape))
+
+
+if __name__ == "__main__":
+  main()